@@ -0,0 +1,289 @@
+#ifndef COMPILEDGRAPH_H
+#define COMPILEDGRAPH_H
+
+#include <autoGradEngine/node.h>
+#include <autoGradEngine/graphArena.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * A computation graph that was traced once and frozen into a flat list of instructions. Every node of the traced graph
+ * becomes a slot in two preallocated arrays (values and gradients), and every computed node becomes an instruction
+ * that reads its operands from slots. Replaying the graph for a new input only overwrites the input slots and runs the
+ * instructions forward and then in reverse, so no node is ever allocated after the trace.
+ *
+ * The graph must have a fixed shape: the instructions are the ones that were recorded for the example input, and the
+ * constants of the trace (for example the target of a loss) are baked into the program.
+ *
+ * The slots that were not computed inside the trace fall in three groups:
+ * - inputs, which are overwritten on every run,
+ * - constants, nodes that were created inside the trace and are copied into the program,
+ * - bindings, nodes that outlive the trace (parameters), whose value is read before every run and whose gradient is
+ *   accumulated into them after every run.
+ *
+ * The program computes in the scalar type of the nodes it was traced from; CompiledGraph is the double precision one.
+ */
+template<typename Scalar>
+class BasicCompiledGraph {
+public:
+    /**
+     * A single operation of the program. The operands are slot indices, stored contiguously in the operand list.
+     */
+    struct Instruction {
+        NodeOp op;
+        std::uint32_t output;
+        std::uint32_t firstOperand;
+        std::uint32_t operandCount;
+        typename BasicNode<Scalar>::Payload payload;
+    };
+
+private:
+    struct Binding {
+        Scalar *data;
+        Scalar *grad;
+        std::uint32_t slot;
+    };
+
+    std::vector<Instruction> instructions;
+    std::vector<std::uint32_t> operands;
+    std::vector<Scalar> values;
+    std::vector<Scalar> gradients;
+    std::vector<std::uint32_t> inputSlots;
+    std::vector<Binding> bindings;
+    // the rows of the DENSE_ROW instructions, which point into it; they never change, so copies of a program share it
+    std::shared_ptr<const std::vector<typename BasicNode<Scalar>::DenseRow> > denseRows;
+    std::uint32_t outputSlot = 0;
+
+public:
+    BasicCompiledGraph() = default;
+
+    /**
+     * @brief Freezes a recorded graph into a program.
+     *
+     * @param inputs - The nodes whose values are provided on every run, in the order in which they are provided
+     * @param output - The node whose value is returned and from which the gradients are propagated
+     * @param tape - The nodes of the graph in creation order, as recorded by a GraphScope
+     * @return - The compiled program
+     */
+    static BasicCompiledGraph compile(const std::vector<BasicNode<Scalar> *> &inputs, BasicNode<Scalar> *output,
+                                      const std::vector<void *> &tape) {
+        std::unordered_map<const BasicNode<Scalar> *, size_t> tapeIndex;
+        for (size_t i = 0; i < tape.size(); ++i) {
+            tapeIndex[node(tape, i)] = i;
+        }
+        const auto outputOnTape = tapeIndex.find(output);
+        if (outputOnTape == tapeIndex.end()) {
+            throw std::invalid_argument("The output of a compiled graph must have been recorded on the tape");
+        }
+
+        // Keep only the nodes that the output depends on, walking the tape backwards from the output
+        std::vector<char> needed(outputOnTape->second + 1, 0);
+        needed.back() = 1;
+        for (size_t i = needed.size(); i > 0; --i) {
+            if (!needed.at(i - 1)) continue;
+            const BasicNode<Scalar> *computed = node(tape, i - 1);
+            for (size_t j = 0; j < computed->parentCount(); ++j) {
+                const auto parent = tapeIndex.find(computed->parent(j));
+                if (parent != tapeIndex.end()) needed.at(parent->second) = 1;
+            }
+        }
+
+        BasicCompiledGraph program;
+        std::unordered_map<const BasicNode<Scalar> *, std::uint32_t> slots;
+        auto newSlot = [&program, &slots](const BasicNode<Scalar> *node) {
+            const auto slot = static_cast<std::uint32_t>(program.values.size());
+            program.values.push_back(node->data);
+            slots[node] = slot;
+            return slot;
+        };
+
+        for (BasicNode<Scalar> *input: inputs) {
+            program.inputSlots.push_back(newSlot(input));
+        }
+
+        // The rows of the nodes go away with the trace, so the program keeps copies. The vector is sized up front
+        // because the instructions point into it.
+        size_t rowCount = 0;
+        for (size_t i = 0; i < needed.size(); ++i) {
+            if (needed.at(i) && node(tape, i)->opcode() == NodeOp::DENSE_ROW) ++rowCount;
+        }
+        auto rows = std::make_shared<std::vector<typename BasicNode<Scalar>::DenseRow> >();
+        rows->reserve(rowCount);
+
+        for (size_t i = 0; i < needed.size(); ++i) {
+            if (!needed.at(i)) continue;
+            BasicNode<Scalar> *computed = node(tape, i);
+
+            Instruction instruction{};
+            instruction.op = computed->opcode();
+            instruction.firstOperand = static_cast<std::uint32_t>(program.operands.size());
+            instruction.operandCount = static_cast<std::uint32_t>(computed->parentCount());
+            instruction.payload = computed->payload;
+            if (instruction.op == NodeOp::DENSE_ROW) {
+                rows->push_back(*computed->payload.row);
+                instruction.payload.row = &rows->back();
+            }
+
+            for (size_t j = 0; j < computed->parentCount(); ++j) {
+                BasicNode<Scalar> *parent = computed->parent(j);
+                auto slot = slots.find(parent);
+                if (slot == slots.end()) {
+                    if (parent->parentCount() > 0) {
+                        throw std::invalid_argument("A computed node of the graph was not recorded on the tape");
+                    }
+                    const std::uint32_t index = newSlot(parent);
+                    if (!BasicNode<Scalar>::isArenaAllocated(parent)) {
+                        program.bindings.push_back(Binding{&parent->data, &parent->grad, index});
+                    }
+                    slot = slots.find(parent);
+                }
+                program.operands.push_back(slot->second);
+            }
+
+            instruction.output = newSlot(computed);
+            program.instructions.push_back(instruction);
+        }
+
+        program.denseRows = rows;
+        program.outputSlot = slots.at(output);
+        program.gradients.assign(program.values.size(), Scalar(0));
+        return program;
+    }
+
+    /**
+     * @brief Builds the graph once for @p exampleInputs inside a recording scope and compiles it.
+     *
+     * @param exampleInputs - The values of the inputs during the trace
+     * @param build - Builds the graph from the input nodes and returns its output
+     * @return - The compiled program
+     */
+    static BasicCompiledGraph trace(
+        const std::vector<double> &exampleInputs,
+        const std::function<BasicNode<Scalar>*(const std::vector<BasicNode<Scalar> *> &)> &build) {
+        GraphArena arena;
+        GraphScope scope(arena, true);
+
+        std::vector<BasicNode<Scalar> *> inputs;
+        inputs.reserve(exampleInputs.size());
+        for (const double value: exampleInputs) {
+            inputs.push_back(new BasicNode<Scalar>(static_cast<Scalar>(value)));
+        }
+
+        BasicNode<Scalar> *output = build(inputs);
+        return compile(inputs, output, arena.tape());
+    }
+
+    /**
+     * @brief Runs the program forward for @p inputs.
+     *
+     * @param inputs - The input values, as many as there were input nodes in the trace
+     * @return - The value of the output
+     */
+    Scalar forward(const std::vector<double> &inputs) {
+        if (inputs.size() != inputSlots.size()) {
+            throw std::invalid_argument("A compiled graph must be run with as many inputs as it was traced with");
+        }
+        for (size_t i = 0; i < inputSlots.size(); ++i) {
+            values[inputSlots[i]] = static_cast<Scalar>(inputs[i]);
+        }
+        for (const Binding &binding: bindings) {
+            values[binding.slot] = *binding.data;
+        }
+        for (Instruction &instruction: instructions) {
+            execute(instruction);
+        }
+        return values[outputSlot];
+    }
+
+    /**
+     * @brief Propagates the gradient of the output back through the program. The gradients of bound nodes and of the
+     * dense rows are accumulated into their owners, exactly like Node::backward() does.
+     *
+     * @param seed - The gradient the output starts with, see Node::backward()
+     */
+    void backward(const double seed = 1.0) {
+        std::fill(gradients.begin(), gradients.end(), Scalar(0));
+        gradients[outputSlot] = static_cast<Scalar>(seed);
+        for (auto it = instructions.rbegin(); it != instructions.rend(); ++it) {
+            propagate(*it);
+        }
+        for (const Binding &binding: bindings) {
+            *binding.grad += gradients[binding.slot];
+        }
+    }
+
+    /**
+     * @brief Runs one forward and one backward pass.
+     *
+     * @param seed - The gradient the output starts with, see Node::backward()
+     * @return - The value of the output
+     */
+    Scalar run(const std::vector<double> &inputs, const double seed = 1.0) {
+        const Scalar output = forward(inputs);
+        backward(seed);
+        return output;
+    }
+
+    /**
+     * @return The gradient of the output with respect to the input at @p index, after the last backward pass
+     */
+    Scalar inputGradient(const size_t index) const {
+        return gradients.at(inputSlots.at(index));
+    }
+
+    size_t instructionCount() const {
+        return instructions.size();
+    }
+
+    size_t slotCount() const {
+        return values.size();
+    }
+
+private:
+    static BasicNode<Scalar> *node(const std::vector<void *> &tape, const size_t i) {
+        return static_cast<BasicNode<Scalar> *>(tape.at(i));
+    }
+
+    /**
+     * The operands of an instruction, as seen by the operation rules of BasicNode.
+     */
+    struct SlotOperands {
+        const std::uint32_t *o;
+        Scalar *v;
+        Scalar *gr;
+
+        Scalar value(const size_t i) const {
+            return v[o[i]];
+        }
+
+        Scalar &grad(const size_t i) const {
+            return gr[o[i]];
+        }
+    };
+
+    SlotOperands operandsOf(const Instruction &instruction) {
+        return SlotOperands{operands.data() + instruction.firstOperand, values.data(), gradients.data()};
+    }
+
+    void execute(Instruction &instruction) {
+        if (instruction.op == NodeOp::LEAF || instruction.op == NodeOp::VIEW) return;
+        values[instruction.output] = BasicNode<Scalar>::forwardOp(instruction.op, instruction.payload,
+                                                                  instruction.operandCount, operandsOf(instruction));
+    }
+
+    void propagate(const Instruction &instruction) {
+        BasicNode<Scalar>::propagateOp(instruction.op, instruction.payload, values[instruction.output],
+                                       gradients[instruction.output], instruction.operandCount,
+                                       operandsOf(instruction));
+    }
+};
+
+using CompiledGraph = BasicCompiledGraph<double>;
+
+#endif //COMPILEDGRAPH_H
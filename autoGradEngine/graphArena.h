@@ -0,0 +1,330 @@
+#ifndef GRAPHARENA_H
+#define GRAPHARENA_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+/**
+ * The GraphArena is a bump allocator that owns the intermediate nodes of a computation graph. Every node that is
+ * created while a GraphScope is open is carved out of a large memory block instead of being requested from the heap
+ * one by one, and the whole graph is released at once when the scope closes by simply moving the bump pointer back.
+ *
+ * Blocks are never handed back to the system while the arena lives, so a training loop that opens one scope per
+ * sample (or per batch) reaches a steady state after the first step and stops allocating altogether.
+ *
+ * While recording is on, the arena also keeps a tape: every computed node it allocates is appended in creation order.
+ * Since a node is always created after its parents, the tape is already a topological order of the graph, and the
+ * backward pass can simply walk it in reverse. The tape does not know the scalar type of the nodes, so a recorded graph
+ * is made of nodes of a single type.
+ */
+class GraphArena {
+public:
+    /**
+     * A position inside the arena. Rewinding to a marker releases everything that was allocated after it.
+     */
+    struct Marker {
+        size_t block;
+        size_t offset;
+        size_t finalizers;
+        size_t tapeLength;
+    };
+
+private:
+    struct Block {
+        std::unique_ptr<unsigned char[]> memory;
+        size_t size;
+    };
+
+    // Objects with a non-trivial destructor register themselves so that rewinding the arena still destroys them
+    struct Finalizer {
+        void *object;
+        void (*destroy)(void *);
+    };
+
+    std::vector<Block> blocks;
+    std::vector<Finalizer> finalizers;
+    std::vector<void *> recordedNodes;
+    size_t blockSize;
+    size_t currentBlock;
+    size_t offset;
+    bool isRecording;
+
+    static GraphArena *&activeSlot() {
+        thread_local GraphArena *active = nullptr;
+        return active;
+    }
+
+public:
+    explicit GraphArena(const size_t blockSize = 1 << 16)
+        : blockSize(blockSize), currentBlock(0), offset(0), isRecording(false) {
+    }
+
+    ~GraphArena() {
+        reset();
+    }
+
+    GraphArena(const GraphArena &) = delete;
+
+    GraphArena &operator=(const GraphArena &) = delete;
+
+    /**
+     * @return The arena that is currently open on the calling thread, or nullptr when nodes go to the heap
+     */
+    static GraphArena *active() {
+        return activeSlot();
+    }
+
+    /**
+     * @brief Installs @p arena as the active arena of the calling thread and returns the one it replaces.
+     */
+    static GraphArena *activate(GraphArena *arena) {
+        GraphArena *previous = activeSlot();
+        activeSlot() = arena;
+        return previous;
+    }
+
+    /**
+     * @return An arena that is private to the calling thread, used by scopes that do not bring their own arena
+     */
+    static GraphArena &forThread() {
+        thread_local GraphArena arena;
+        return arena;
+    }
+
+    /**
+     * @brief Bump-allocates @p bytes aligned to @p alignment. When the current block is exhausted the arena moves on
+     * to the next one, reusing blocks from previous steps before asking the heap for a new block.
+     */
+    void *allocate(const size_t bytes, const size_t alignment = alignof(std::max_align_t)) {
+        while (true) {
+            if (currentBlock < blocks.size()) {
+                Block &block = blocks.at(currentBlock);
+                const auto base = reinterpret_cast<std::uintptr_t>(block.memory.get());
+                const std::uintptr_t aligned = (base + offset + alignment - 1) & ~(alignment - 1);
+                const size_t end = static_cast<size_t>(aligned - base) + bytes;
+                if (end <= block.size) {
+                    offset = end;
+                    return reinterpret_cast<void *>(aligned);
+                }
+                if (currentBlock + 1 < blocks.size() && blocks.at(currentBlock + 1).size >= bytes + alignment) {
+                    ++currentBlock;
+                    offset = 0;
+                    continue;
+                }
+            }
+
+            // Either there are no blocks yet or the following one is too small: insert a fresh block after the current
+            const size_t size = std::max(blockSize, bytes + alignment);
+            Block block{std::unique_ptr<unsigned char[]>(new unsigned char[size]), size};
+            const size_t position = blocks.empty() ? 0 : currentBlock + 1;
+            blocks.insert(blocks.begin() + static_cast<std::ptrdiff_t>(position), std::move(block));
+            currentBlock = position;
+            offset = 0;
+        }
+    }
+
+    /**
+     * @brief Registers the destructor of an object that lives in the arena, so that it runs when the arena rewinds.
+     *
+     * @return The index of the registration, which can later be used to cancel it
+     */
+    size_t registerFinalizer(void *object, void (*destroy)(void *)) {
+        finalizers.push_back(Finalizer{object, destroy});
+        return finalizers.size() - 1;
+    }
+
+    /**
+     * @brief Cancels a registration, used when an arena object is destroyed explicitly before the arena rewinds.
+     */
+    void cancelFinalizer(const size_t index) {
+        if (index < finalizers.size()) {
+            finalizers.at(index).destroy = nullptr;
+        }
+    }
+
+    bool recording() const {
+        return isRecording;
+    }
+
+    /**
+     * @brief Turns the tape on or off and returns the previous setting.
+     */
+    bool setRecording(const bool enabled) {
+        const bool previous = isRecording;
+        isRecording = enabled;
+        return previous;
+    }
+
+    /**
+     * @brief Appends a node to the tape. Nodes call it from their constructor while recording is on.
+     */
+    void record(void *node) {
+        recordedNodes.push_back(node);
+    }
+
+    /**
+     * @return The nodes recorded since the tape was last rewound, in creation order
+     */
+    const std::vector<void *> &tape() const {
+        return recordedNodes;
+    }
+
+    Marker mark() const {
+        return Marker{currentBlock, offset, finalizers.size(), recordedNodes.size()};
+    }
+
+    /**
+     * @brief Releases everything that was allocated after @p marker. Memory is not returned to the heap, the bump
+     * pointer is just moved back, so the cost does not depend on how many nodes were created.
+     */
+    void rewind(const Marker &marker) {
+        for (size_t i = finalizers.size(); i > marker.finalizers; --i) {
+            const Finalizer &finalizer = finalizers.at(i - 1);
+            if (finalizer.destroy) finalizer.destroy(finalizer.object);
+        }
+        finalizers.resize(marker.finalizers);
+        recordedNodes.resize(std::min(marker.tapeLength, recordedNodes.size()));
+        currentBlock = marker.block;
+        offset = marker.offset;
+    }
+
+    void reset() {
+        rewind(Marker{0, 0, 0, 0});
+    }
+
+    /**
+     * @return The number of bytes that are reserved by the arena, which stays flat once the training loop is warm
+     */
+    size_t capacity() const {
+        size_t total = 0;
+        for (const auto &block: blocks) total += block.size;
+        return total;
+    }
+
+    bool owns(const void *pointer) const {
+        const auto address = reinterpret_cast<std::uintptr_t>(pointer);
+        for (const auto &block: blocks) {
+            const auto base = reinterpret_cast<std::uintptr_t>(block.memory.get());
+            if (address >= base && address < base + block.size) return true;
+        }
+        return false;
+    }
+};
+
+/**
+ * A GraphScope routes every node that is created on the current thread into an arena for as long as the scope lives.
+ * When the scope closes, the graph that was built inside of it is released in one go. Scopes can be nested, even on the
+ * same arena, since each of them only rewinds what was allocated after it was opened.
+ *
+ * A scope can also record the graph on the tape of its arena, in which case Node::backward() replays the tape instead
+ * of sorting the graph. Recording stays on in scopes nested inside a recording scope of the same arena, so that the
+ * tape never misses a node of the graph.
+ */
+class GraphScope {
+    GraphArena &arena;
+    GraphArena *previous;
+    GraphArena::Marker marker;
+    bool previousRecording;
+
+public:
+    /**
+     * @param arena - The arena that receives the nodes created while the scope is open
+     * @param record - Whether the nodes are recorded on the tape of @p arena
+     */
+    explicit GraphScope(GraphArena &arena = GraphArena::forThread(), const bool record = false)
+        : arena(arena), previous(GraphArena::activate(&arena)), marker(arena.mark()),
+          previousRecording(arena.setRecording(record || arena.recording())) {
+    }
+
+    ~GraphScope() {
+        arena.rewind(marker);
+        arena.setRecording(previousRecording);
+        GraphArena::activate(previous);
+    }
+
+    GraphScope(const GraphScope &) = delete;
+
+    GraphScope &operator=(const GraphScope &) = delete;
+};
+
+/**
+ * Temporarily sends allocations back to the heap while a GraphScope is open. It is used for objects that have to
+ * outlive the step in which they are created, like the parameters of a freshly constructed network.
+ */
+class HeapScope {
+    GraphArena *previous;
+
+public:
+    HeapScope() : previous(GraphArena::activate(nullptr)) {
+    }
+
+    ~HeapScope() {
+        GraphArena::activate(previous);
+    }
+
+    HeapScope(const HeapScope &) = delete;
+
+    HeapScope &operator=(const HeapScope &) = delete;
+};
+
+/**
+ * Base class for graph objects that should be allocated from the active arena. Each allocation is prefixed with a small
+ * header that remembers where it came from, so that a plain `delete` works for both heap and arena objects.
+ *
+ * @tparam T - The derived class
+ * @tparam Finalize - Whether the arena has to run the destructor of T when it rewinds. Classes whose arena instances do
+ * not own any memory outside of the arena turn it off, which makes releasing them free.
+ */
+template<typename T, bool Finalize = true>
+class ArenaAllocated {
+    struct alignas(std::max_align_t) Header {
+        GraphArena *arena;
+        size_t finalizer;
+    };
+
+    static constexpr size_t noFinalizer = static_cast<size_t>(-1);
+
+    static void destroy(void *object) {
+        static_cast<T *>(object)->~T();
+    }
+
+public:
+    static void *operator new(const size_t size) {
+        GraphArena *arena = GraphArena::active();
+        void *memory = arena ? arena->allocate(sizeof(Header) + size) : ::operator new(sizeof(Header) + size);
+        auto *header = static_cast<Header *>(memory);
+        void *object = header + 1;
+        header->arena = arena;
+        header->finalizer = arena && Finalize
+                                ? arena->registerFinalizer(object, &ArenaAllocated::destroy)
+                                : noFinalizer;
+        return object;
+    }
+
+    static void operator delete(void *object) {
+        if (!object) return;
+        Header *header = static_cast<Header *>(object) - 1;
+        if (header->arena) {
+            // The destructor already ran, the memory itself is reclaimed when the arena rewinds
+            if (header->finalizer != noFinalizer) header->arena->cancelFinalizer(header->finalizer);
+        } else {
+            ::operator delete(header);
+        }
+    }
+
+    /**
+     * @param object - A node created with `new`, either inside or outside a GraphScope
+     * @return True if @p object was allocated inside a GraphScope and is therefore owned by an arena
+     */
+    static bool isArenaAllocated(const T *object) {
+        return object && (reinterpret_cast<const Header *>(object) - 1)->arena != nullptr;
+    }
+};
+
+template<typename T, bool Finalize>
+constexpr size_t ArenaAllocated<T, Finalize>::noFinalizer;
+
+#endif //GRAPHARENA_H
@@ -0,0 +1,234 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <algorithm>
+#include <cstddef>
+#include <autoGradEngine/kernels/kernels.h>
+#include <utils/alignedAllocator.h>
+#include <utils/threadPool.h>
+
+/**
+ * A cache-blocked matrix multiplication, C += alpha * A * B, in the style of the BLIS and GotoBLAS libraries. It is the
+ * workhorse of the batched dense layers: the forward pass (X * W^T), the input gradient (dOut * W) and the weight
+ * gradient (dOut^T * X) are all calls to gemm() that only differ by the strides of their operands.
+ *
+ * The operands are cut into blocks that fit the cache hierarchy. A kc x nc block of B is packed once into panels of
+ * gemmCols columns and stays in the last-level cache, an mc x kc block of A is packed into panels of gemmRows rows that
+ * stay in the L2 cache, and the micro-kernel of the active KernelTable multiplies one panel of A by one panel of B while
+ * the resulting tile of C lives in registers. Packing also turns any strided or transposed operand into contiguous
+ * memory, so transposition is free.
+ *
+ * The blocks never exceed the matrices, so the layer sizes of the network decide how much of the cache is actually used.
+ */
+namespace kernels {
+    /**
+     * A read-only matrix given by its first element and the distance between two rows and between two columns. A
+     * row-major matrix with n columns has strides (n, 1), and swapping the strides transposes it without a copy.
+     */
+    template<typename Scalar>
+    struct BasicMatrixView {
+        const Scalar *data;
+        size_t rowStride;
+        size_t colStride;
+
+        Scalar operator()(const size_t row, const size_t col) const {
+            return data[row * rowStride + col * colStride];
+        }
+
+        BasicMatrixView transposed() const {
+            return BasicMatrixView{data, colStride, rowStride};
+        }
+
+        static BasicMatrixView rowMajor(const Scalar *data, const size_t cols) {
+            return BasicMatrixView{data, cols, 1};
+        }
+    };
+
+    using MatrixView = BasicMatrixView<double>;
+
+    namespace gemmBlocking {
+        constexpr size_t depth = 256;    // kc: the shared dimension of a packed block
+        constexpr size_t rows = 96;      // mc: a multiple of the row count of every micro-kernel
+        constexpr size_t cols = 1024;    // nc: a multiple of the column count of every micro-kernel
+        constexpr size_t smallProduct = 4096; // below m * n * k, packing costs more than it saves
+    }
+
+    /**
+     * Lets the matrix products that are made on the calling thread split their output across @p pool for as long as
+     * the scope is open. Tensor operations pick it up through gemm(), so a whole batched training step can be spread
+     * over the threads of a pool without passing it around.
+     */
+    class GemmScope {
+        ThreadPool *previous;
+
+        static ThreadPool *&activeSlot() {
+            thread_local ThreadPool *active = nullptr;
+            return active;
+        }
+
+    public:
+        explicit GemmScope(ThreadPool &pool) : previous(activeSlot()) {
+            activeSlot() = &pool;
+        }
+
+        ~GemmScope() {
+            activeSlot() = previous;
+        }
+
+        GemmScope(const GemmScope &) = delete;
+
+        GemmScope &operator=(const GemmScope &) = delete;
+
+        /**
+         * @return The pool of the innermost open scope on the calling thread, or nullptr
+         */
+        static ThreadPool *active() {
+            return activeSlot();
+        }
+    };
+
+    /**
+     * @brief Copies the (rows x depth) block of @p a at (row, col) into panels of @p panelRows rows, scaled by
+     * @p alpha. The last panel is padded with zeros.
+     */
+    template<typename Scalar>
+    void packPanelsOfA(const BasicMatrixView<Scalar> &a, const size_t row, const size_t col, const size_t rows,
+                       const size_t depth, const size_t panelRows, const Scalar alpha, Scalar *packed) {
+        for (size_t r0 = 0; r0 < rows; r0 += panelRows) {
+            const size_t height = std::min(panelRows, rows - r0);
+            for (size_t p = 0; p < depth; ++p) {
+                for (size_t r = 0; r < height; ++r) *packed++ = alpha * a(row + r0 + r, col + p);
+                for (size_t r = height; r < panelRows; ++r) *packed++ = 0;
+            }
+        }
+    }
+
+    /**
+     * @brief Copies the (depth x cols) block of @p b at (row, col) into panels of @p panelCols columns. The last panel
+     * is padded with zeros.
+     */
+    template<typename Scalar>
+    void packPanelOfB(const BasicMatrixView<Scalar> &b, const size_t row, const size_t col, const size_t depth,
+                      const size_t cols, const size_t panelCols, Scalar *packed) {
+        const size_t width = std::min(panelCols, cols);
+        for (size_t p = 0; p < depth; ++p) {
+            for (size_t j = 0; j < width; ++j) *packed++ = b(row + p, col + j);
+            for (size_t j = width; j < panelCols; ++j) *packed++ = 0;
+        }
+    }
+
+    /**
+     * @brief Multiplies a packed block of A by a range of packed panels of B into C, one micro-kernel tile at a time.
+     * Tiles that stick out of C are computed into a scratch tile and only their valid part is added.
+     */
+    template<typename Scalar>
+    void multiplyPackedBlocks(const BasicKernelTable<Scalar> &kernel, const Scalar *packedA, const Scalar *packedB,
+                              const size_t rows, const size_t cols, const size_t depth, Scalar *c, const size_t ldc) {
+        const size_t mr = kernel.gemmRows, nr = kernel.gemmCols;
+        thread_local AlignedVector<Scalar> scratch;
+        if (scratch.size() < mr * nr) scratch.resize(mr * nr);
+
+        for (size_t j = 0; j < cols; j += nr) {
+            const Scalar *panelB = packedB + j * depth;
+            const size_t width = std::min(nr, cols - j);
+            for (size_t i = 0; i < rows; i += mr) {
+                const Scalar *panelA = packedA + i * depth;
+                const size_t height = std::min(mr, rows - i);
+                Scalar *tile = c + i * ldc + j;
+                if (height == mr && width == nr) {
+                    kernel.gemmTile(depth, panelA, panelB, tile, ldc);
+                    continue;
+                }
+
+                std::fill(scratch.begin(), scratch.begin() + static_cast<std::ptrdiff_t>(mr * nr), Scalar(0));
+                kernel.gemmTile(depth, panelA, panelB, scratch.data(), nr);
+                for (size_t r = 0; r < height; ++r) {
+                    for (size_t q = 0; q < width; ++q) tile[r * ldc + q] += scratch[r * nr + q];
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief C += alpha * A * B
+     *
+     * @param m - The number of rows of A and C
+     * @param n - The number of columns of B and C
+     * @param k - The number of columns of A and rows of B
+     * @param alpha - The scale of the product, applied in the precision of @p Scalar
+     * @param a - The (m x k) left operand
+     * @param b - The (k x n) right operand
+     * @param c - The (m x n) row-major output, accumulated into
+     * @param ldc - The distance between two rows of @p c
+     * @param pool - An optional thread pool, across which the tiles of C are split. Defaults to the pool of the open
+     * GemmScope, if any.
+     */
+    template<typename Scalar>
+    void gemm(const size_t m, const size_t n, const size_t k, const double alpha, const BasicMatrixView<Scalar> &a,
+              const BasicMatrixView<Scalar> &b, Scalar *c, const size_t ldc, ThreadPool *pool = GemmScope::active()) {
+        if (m == 0 || n == 0 || k == 0) return;
+        const Scalar scale = static_cast<Scalar>(alpha);
+
+        if (m * n * k < gemmBlocking::smallProduct) {
+            for (size_t i = 0; i < m; ++i) {
+                for (size_t p = 0; p < k; ++p) {
+                    const Scalar aip = scale * a(i, p);
+                    for (size_t j = 0; j < n; ++j) c[i * ldc + j] += aip * b(p, j);
+                }
+            }
+            return;
+        }
+
+        const BasicKernelTable<Scalar> &kernel = kernels::active<Scalar>();
+        const size_t mr = kernel.gemmRows, nr = kernel.gemmCols;
+        const size_t kc = std::min(gemmBlocking::depth, k);
+        const size_t mc = std::min(gemmBlocking::rows, (m + mr - 1) / mr * mr);
+        const size_t nc = std::min(gemmBlocking::cols, (n + nr - 1) / nr * nr);
+        const size_t rowBlocks = (m + mc - 1) / mc;
+
+        thread_local AlignedVector<Scalar> packedB;
+        if (packedB.size() < kc * nc) packedB.resize(kc * nc);
+
+        for (size_t jc = 0; jc < n; jc += nc) {
+            const size_t cols = std::min(nc, n - jc);
+            const size_t panels = (cols + nr - 1) / nr;
+
+            // When there are fewer row blocks than threads, the columns of the block are split as well
+            const size_t threads = pool ? pool->size() : 1;
+            const size_t colChunks = std::min(panels, (threads + rowBlocks - 1) / rowBlocks);
+            const size_t chunkPanels = (panels + colChunks - 1) / colChunks;
+
+            for (size_t pc = 0; pc < k; pc += kc) {
+                const size_t depth = std::min(kc, k - pc);
+                Scalar *packedBlockB = packedB.data();
+                auto packB = [&](const size_t panel) {
+                    packPanelOfB(b, pc, jc + panel * nr, depth, cols - panel * nr, nr,
+                                 packedBlockB + panel * nr * depth);
+                };
+                auto multiply = [&](const size_t task) {
+                    const size_t ic = (task / colChunks) * mc;
+                    const size_t firstPanel = (task % colChunks) * chunkPanels;
+                    if (firstPanel >= panels) return;
+                    const size_t rows = std::min(mc, m - ic);
+                    const size_t chunkCols = std::min(chunkPanels * nr, cols - firstPanel * nr);
+
+                    thread_local AlignedVector<Scalar> packedA;
+                    if (packedA.size() < mc * kc) packedA.resize(mc * kc);
+                    packPanelsOfA(a, ic, pc, rows, depth, mr, scale, packedA.data());
+                    multiplyPackedBlocks(kernel, packedA.data(), packedBlockB + firstPanel * nr * depth, rows,
+                                         chunkCols, depth, c + ic * ldc + jc + firstPanel * nr, ldc);
+                };
+
+                if (pool) {
+                    pool->parallelFor(panels, packB);
+                    pool->parallelFor(rowBlocks * colChunks, multiply);
+                } else {
+                    for (size_t panel = 0; panel < panels; ++panel) packB(panel);
+                    for (size_t ic = 0; ic < rowBlocks; ++ic) multiply(ic);
+                }
+            }
+        }
+    }
+}
+
+#endif //GEMM_H
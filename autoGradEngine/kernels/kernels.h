@@ -0,0 +1,170 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <autoGradEngine/kernels/scalarKernels.h>
+#include <autoGradEngine/kernels/x86Kernels.h>
+
+/**
+ * Runtime dispatch of the numeric kernels that the dense layers and activations are built on. Each supported instruction
+ * set provides a KernelTable per scalar type, and the best one the processor can run is selected once per type, the
+ * first time a kernel is needed. Binaries therefore stay portable: they are compiled for the baseline architecture and
+ * still use AVX2 or AVX-512 on machines that have it.
+ *
+ * The NEEDLE_KERNELS environment variable overrides the choice by name (scalar, sse2, avx2, avx512), which is useful to
+ * compare the variants or to rule them out while debugging.
+ */
+namespace kernels {
+    template<typename Scalar>
+    struct BasicKernelTable {
+        const char *name;
+
+        Scalar (*dot)(const Scalar *a, const Scalar *b, size_t n);
+
+        void (*axpy)(Scalar alpha, const Scalar *x, Scalar *y, size_t n);
+
+        void (*add)(const Scalar *x, Scalar *y, size_t n);
+
+        void (*relu)(const Scalar *x, Scalar *y, size_t n);
+
+        void (*reluBackward)(const Scalar *y, const Scalar *g, Scalar *dx, size_t n);
+
+        void (*exp)(const Scalar *x, Scalar *y, size_t n);
+
+        void (*sigmoid)(const Scalar *x, Scalar *y, size_t n);
+
+        // The shape of the output tile computed by gemmTile, see gemm.h
+        size_t gemmRows;
+        size_t gemmCols;
+
+        void (*gemmTile)(size_t k, const Scalar *a, const Scalar *b, Scalar *c, size_t ldc);
+
+        // The int8 product of quantized inference, which does not depend on the scalar type
+        int32_t (*dotInt8)(const int8_t *a, const int8_t *b, size_t n);
+    };
+
+    using KernelTable = BasicKernelTable<double>;
+
+    template<typename Scalar = double>
+    const BasicKernelTable<Scalar> &scalarTable() {
+        static const BasicKernelTable<Scalar> table{
+            "scalar", &scalar::dot<Scalar>, &scalar::axpy<Scalar>, &scalar::add<Scalar>, &scalar::relu<Scalar>,
+            &scalar::reluBackward<Scalar>, &scalar::exp<Scalar>, &scalar::sigmoid<Scalar>, scalar::gemmRows,
+            scalar::gemmCols, &scalar::gemmTile<Scalar>, &scalar::dotInt8
+        };
+        return table;
+    }
+
+    /**
+     * @brief Appends the vectorized tables of the processor to @p supported. There is one overload per scalar type, and
+     * the types without vectorized kernels have none.
+     */
+    template<typename Scalar>
+    void addVectorizedTables(std::vector<const BasicKernelTable<Scalar> *> &) {
+    }
+
+    inline void addVectorizedTables(std::vector<const KernelTable *> &supported) {
+#ifdef NEEDLE_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2")) {
+            static const KernelTable table{
+                "sse2", &sse2::dot, &sse2::axpy, &sse2::add, &sse2::relu, &sse2::reluBackward, &sse2::exp,
+                &sse2::sigmoid, scalar::gemmRows, scalar::gemmCols, &scalar::gemmTile<double>, &sse2::dotInt8
+            };
+            supported.push_back(&table);
+        }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            static const KernelTable table{
+                "avx2", &avx2::dot, &avx2::axpy, &avx2::add, &avx2::relu, &avx2::reluBackward, &avx2::exp,
+                &avx2::sigmoid, avx2::gemmRows, avx2::gemmCols, &avx2::gemmTile, &avx2::dotInt8
+            };
+            supported.push_back(&table);
+        }
+        if (__builtin_cpu_supports("avx512f")) {
+            static const KernelTable table{
+                "avx512", &avx512::dot, &avx512::axpy, &avx512::add, &avx512::relu, &avx512::reluBackward,
+                &avx512::exp, &avx512::sigmoid, avx512::gemmRows, avx512::gemmCols, &avx512::gemmTile,
+                &avx512::dotInt8
+            };
+            supported.push_back(&table);
+        }
+#else
+        (void) supported;
+#endif
+    }
+
+    inline void addVectorizedTables(std::vector<const BasicKernelTable<float> *> &supported) {
+#ifdef NEEDLE_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            static const BasicKernelTable<float> table{
+                "avx2", &avx2::dot, &avx2::axpy, &avx2::add, &avx2::relu, &avx2::reluBackward, &avx2::exp,
+                &avx2::sigmoid, avx2::floatGemmRows, avx2::floatGemmCols, &avx2::gemmTile, &avx2::dotInt8
+            };
+            supported.push_back(&table);
+        }
+        if (__builtin_cpu_supports("avx512f")) {
+            static const BasicKernelTable<float> table{
+                "avx512", &avx512::dot, &avx512::axpy, &avx512::add, &avx512::relu, &avx512::reluBackward,
+                &avx512::exp, &avx512::sigmoid, avx512::floatGemmRows, avx512::floatGemmCols, &avx512::gemmTile,
+                &avx512::dotInt8
+            };
+            supported.push_back(&table);
+        }
+#else
+        (void) supported;
+#endif
+    }
+
+    /**
+     * @return Every kernel table for @p Scalar the processor can run, from the most portable to the fastest one
+     */
+    template<typename Scalar = double>
+    const std::vector<const BasicKernelTable<Scalar> *> &available() {
+        static const std::vector<const BasicKernelTable<Scalar> *> tables = [] {
+            std::vector<const BasicKernelTable<Scalar> *> supported{&scalarTable<Scalar>()};
+            addVectorizedTables(supported);
+            return supported;
+        }();
+        return tables;
+    }
+
+    template<typename Scalar>
+    std::atomic<const BasicKernelTable<Scalar> *> &activeSlot() {
+        static std::atomic<const BasicKernelTable<Scalar> *> slot{nullptr};
+        return slot;
+    }
+
+    /**
+     * @return The kernel table for @p Scalar that is in use. On the first call it is the fastest available one, unless
+     * NEEDLE_KERNELS names another supported table.
+     */
+    template<typename Scalar = double>
+    const BasicKernelTable<Scalar> &active() {
+        const BasicKernelTable<Scalar> *table = activeSlot<Scalar>().load(std::memory_order_acquire);
+        if (table) return *table;
+
+        const std::vector<const BasicKernelTable<Scalar> *> &tables = available<Scalar>();
+        table = tables.back();
+        if (const char *requested = std::getenv("NEEDLE_KERNELS")) {
+            for (const BasicKernelTable<Scalar> *candidate: tables) {
+                if (std::strcmp(candidate->name, requested) == 0) table = candidate;
+            }
+        }
+        activeSlot<Scalar>().store(table, std::memory_order_release);
+        return *table;
+    }
+
+    /**
+     * @brief Switches every kernel of its scalar type to @p table, which has to be one of the available() tables.
+     */
+    template<typename Scalar>
+    void use(const BasicKernelTable<Scalar> &table) {
+        activeSlot<Scalar>().store(&table, std::memory_order_release);
+    }
+}
+
+#endif //KERNELS_H
@@ -0,0 +1,106 @@
+#ifndef SCALARKERNELS_H
+#define SCALARKERNELS_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * The portable reference implementation of the numeric kernels, for any floating point type. Every vectorized variant
+ * is tested against these loops, and they are the fallback on hardware without a supported instruction set.
+ */
+namespace kernels {
+namespace scalar {
+    /**
+     * @return sum(a[i] * b[i])
+     */
+    template<typename T>
+    T dot(const T *a, const T *b, const size_t n) {
+        T sum = 0;
+        for (size_t i = 0; i < n; ++i) sum += a[i] * b[i];
+        return sum;
+    }
+
+    /**
+     * @brief y += alpha * x
+     */
+    template<typename T>
+    void axpy(const T alpha, const T *x, T *y, const size_t n) {
+        for (size_t i = 0; i < n; ++i) y[i] += alpha * x[i];
+    }
+
+    /**
+     * @brief y += x, used to add a bias row
+     */
+    template<typename T>
+    void add(const T *x, T *y, const size_t n) {
+        for (size_t i = 0; i < n; ++i) y[i] += x[i];
+    }
+
+    /**
+     * @brief y = max(x, 0), @p y may be @p x
+     */
+    template<typename T>
+    void relu(const T *x, T *y, const size_t n) {
+        for (size_t i = 0; i < n; ++i) y[i] = x[i] < 0 ? T(0) : x[i];
+    }
+
+    /**
+     * @brief dx += g where the output @p y of the ReLU is positive
+     */
+    template<typename T>
+    void reluBackward(const T *y, const T *g, T *dx, const size_t n) {
+        for (size_t i = 0; i < n; ++i) dx[i] += y[i] > 0 ? g[i] : T(0);
+    }
+
+    /**
+     * @brief y = exp(x), @p y may be @p x
+     */
+    template<typename T>
+    void exp(const T *x, T *y, const size_t n) {
+        for (size_t i = 0; i < n; ++i) y[i] = std::exp(x[i]);
+    }
+
+    /**
+     * @brief y = 1 / (1 + exp(-x)), @p y may be @p x
+     */
+    template<typename T>
+    void sigmoid(const T *x, T *y, const size_t n) {
+        for (size_t i = 0; i < n; ++i) y[i] = T(1) / (T(1) + std::exp(-x[i]));
+    }
+
+    /**
+     * @return sum(a[i] * b[i]) of two int8 vectors, accumulated in int32. Quantized values lie in [-127, 127], so more
+     * than 2^17 products fit before the sum could overflow.
+     */
+    inline int32_t dotInt8(const int8_t *a, const int8_t *b, const size_t n) {
+        int32_t sum = 0;
+        for (size_t i = 0; i < n; ++i) sum += static_cast<int32_t>(a[i]) * static_cast<int32_t>(b[i]);
+        return sum;
+    }
+
+    constexpr size_t gemmRows = 4;
+    constexpr size_t gemmCols = 4;
+
+    /**
+     * @brief The GEMM micro-kernel: c += a * b for one gemmRows x gemmCols tile of c, where @p a is a packed panel
+     * holding gemmRows values per step of k and @p b a packed panel holding gemmCols values per step of k.
+     *
+     * @param ldc - The distance between two rows of @p c
+     */
+    template<typename T>
+    void gemmTile(const size_t k, const T *a, const T *b, T *c, const size_t ldc) {
+        T tile[gemmRows][gemmCols] = {};
+        for (size_t p = 0; p < k; ++p, a += gemmRows, b += gemmCols) {
+            for (size_t r = 0; r < gemmRows; ++r) {
+                for (size_t j = 0; j < gemmCols; ++j) tile[r][j] += a[r] * b[j];
+            }
+        }
+        for (size_t r = 0; r < gemmRows; ++r) {
+            for (size_t j = 0; j < gemmCols; ++j) c[r * ldc + j] += tile[r][j];
+        }
+    }
+}
+}
+
+#endif //SCALARKERNELS_H
@@ -0,0 +1,774 @@
+#ifndef X86KERNELS_H
+#define X86KERNELS_H
+
+#include <autoGradEngine/kernels/scalarKernels.h>
+
+/**
+ * Vectorized variants of the scalar kernels for x86 processors. Each variant is compiled for its own instruction set
+ * through target attributes, so the library itself is built for the baseline architecture and the variants are only
+ * executed after the dispatcher in kernels.h checked that the processor supports them.
+ *
+ * The exponential has no vector instruction, it is computed with the range reduction and rational approximation of
+ * the Cephes library: exp(x) = 2^n * exp(r), with n = round(x / ln 2) and |r| <= ln(2) / 2. Inputs are clamped to
+ * [-708, 709], or [-87.3, 88] in single precision, so that 2^n stays a normal number.
+ *
+ * The AVX2 and AVX-512 variants exist for float as well, as overloads of the same names. SSE2 only covers double.
+ * The int8 dot products widen the bytes to 16 bits (32 bits with AVX-512F alone, which has no byte or word
+ * arithmetic) and accumulate the products in int32 lanes.
+ *
+ * The GEMM micro-kernels keep a whole tile of the output in vector registers and expect panels packed by gemm.h, whose
+ * rows of B are 64-byte aligned, so they can use aligned loads.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define NEEDLE_X86_KERNELS 1
+#include <immintrin.h>
+
+#define NEEDLE_TARGET_SSE2 __attribute__((target("sse2")))
+#define NEEDLE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define NEEDLE_TARGET_AVX512 __attribute__((target("avx512f")))
+
+namespace kernels {
+namespace expConstants {
+    constexpr double minInput = -708.0;
+    constexpr double maxInput = 709.0;
+    constexpr double log2e = 1.4426950408889634073599;
+    constexpr double ln2High = 6.93145751953125E-1;
+    constexpr double ln2Low = 1.42860682030941723212E-6;
+    constexpr double p0 = 1.26177193074810590878E-4;
+    constexpr double p1 = 3.02994407707441961300E-2;
+    constexpr double p2 = 9.99999999999999999910E-1;
+    constexpr double q0 = 3.00198505138664455042E-6;
+    constexpr double q1 = 2.52448340349684104192E-3;
+    constexpr double q2 = 2.27265548208155028766E-1;
+    constexpr double q3 = 2.00000000000000000009E0;
+}
+
+// The single precision version of Cephes uses a polynomial instead of a rational function
+namespace expfConstants {
+    constexpr float minInput = -87.3365f;
+    constexpr float maxInput = 88.0f;
+    constexpr float log2e = 1.44269504088896341f;
+    constexpr float ln2High = 0.693359375f;
+    constexpr float ln2Low = -2.12194440e-4f;
+    constexpr float p0 = 1.9875691500E-4f;
+    constexpr float p1 = 1.3981999507E-3f;
+    constexpr float p2 = 8.3334519073E-3f;
+    constexpr float p3 = 4.1665795894E-2f;
+    constexpr float p4 = 1.6666665459E-1f;
+    constexpr float p5 = 5.0000001201E-1f;
+}
+
+namespace sse2 {
+    NEEDLE_TARGET_SSE2 inline __m128d expPd(__m128d x) {
+        using namespace expConstants;
+        x = _mm_min_pd(_mm_max_pd(x, _mm_set1_pd(minInput)), _mm_set1_pd(maxInput));
+        const __m128i ni = _mm_cvtpd_epi32(_mm_mul_pd(x, _mm_set1_pd(log2e)));
+        const __m128d n = _mm_cvtepi32_pd(ni);
+        x = _mm_sub_pd(x, _mm_mul_pd(n, _mm_set1_pd(ln2High)));
+        x = _mm_sub_pd(x, _mm_mul_pd(n, _mm_set1_pd(ln2Low)));
+
+        const __m128d xx = _mm_mul_pd(x, x);
+        __m128d px = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(p0), xx), _mm_set1_pd(p1));
+        px = _mm_mul_pd(_mm_add_pd(_mm_mul_pd(px, xx), _mm_set1_pd(p2)), x);
+        __m128d qx = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(q0), xx), _mm_set1_pd(q1));
+        qx = _mm_add_pd(_mm_mul_pd(qx, xx), _mm_set1_pd(q2));
+        qx = _mm_add_pd(_mm_mul_pd(qx, xx), _mm_set1_pd(q3));
+        x = _mm_div_pd(px, _mm_sub_pd(qx, px));
+        x = _mm_add_pd(_mm_set1_pd(1.0), _mm_add_pd(x, x));
+
+        // 2^n, built directly in the exponent bits
+        __m128i exponent = _mm_add_epi32(ni, _mm_set1_epi32(1023));
+        exponent = _mm_slli_epi64(_mm_unpacklo_epi32(exponent, _mm_setzero_si128()), 52);
+        return _mm_mul_pd(x, _mm_castsi128_pd(exponent));
+    }
+
+    NEEDLE_TARGET_SSE2 inline double dot(const double *a, const double *b, const size_t n) {
+        __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+            acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+        double sum = lanes[0] + lanes[1];
+        for (; i < n; ++i) sum += a[i] * b[i];
+        return sum;
+    }
+
+    NEEDLE_TARGET_SSE2 inline void axpy(const double alpha, const double *x, double *y, const size_t n) {
+        const __m128d a = _mm_set1_pd(alpha);
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(a, _mm_loadu_pd(x + i))));
+        }
+        for (; i < n; ++i) y[i] += alpha * x[i];
+    }
+
+    NEEDLE_TARGET_SSE2 inline void add(const double *x, double *y, const size_t n) {
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_loadu_pd(x + i)));
+        }
+        for (; i < n; ++i) y[i] += x[i];
+    }
+
+    NEEDLE_TARGET_SSE2 inline void relu(const double *x, double *y, const size_t n) {
+        const __m128d zero = _mm_setzero_pd();
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            _mm_storeu_pd(y + i, _mm_max_pd(_mm_loadu_pd(x + i), zero));
+        }
+        for (; i < n; ++i) y[i] = x[i] < 0.0 ? 0.0 : x[i];
+    }
+
+    NEEDLE_TARGET_SSE2 inline void reluBackward(const double *y, const double *g, double *dx, const size_t n) {
+        const __m128d zero = _mm_setzero_pd();
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            const __m128d mask = _mm_cmpgt_pd(_mm_loadu_pd(y + i), zero);
+            _mm_storeu_pd(dx + i, _mm_add_pd(_mm_loadu_pd(dx + i), _mm_and_pd(mask, _mm_loadu_pd(g + i))));
+        }
+        for (; i < n; ++i) dx[i] += y[i] > 0.0 ? g[i] : 0.0;
+    }
+
+    NEEDLE_TARGET_SSE2 inline void exp(const double *x, double *y, const size_t n) {
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            _mm_storeu_pd(y + i, expPd(_mm_loadu_pd(x + i)));
+        }
+        for (; i < n; ++i) y[i] = std::exp(x[i]);
+    }
+
+    NEEDLE_TARGET_SSE2 inline void sigmoid(const double *x, double *y, const size_t n) {
+        const __m128d one = _mm_set1_pd(1.0);
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            const __m128d e = expPd(_mm_sub_pd(_mm_setzero_pd(), _mm_loadu_pd(x + i)));
+            _mm_storeu_pd(y + i, _mm_div_pd(one, _mm_add_pd(one, e)));
+        }
+        for (; i < n; ++i) y[i] = 1.0 / (1.0 + std::exp(-x[i]));
+    }
+
+    NEEDLE_TARGET_SSE2 inline int32_t sumLanes(const __m128i v) {
+        int32_t lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), v);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    NEEDLE_TARGET_SSE2 inline int32_t dotInt8(const int8_t *a, const int8_t *b, const size_t n) {
+        __m128i acc = _mm_setzero_si128();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+            const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+            // Sign-extends the bytes by moving them into the high half of each word and shifting them back
+            const __m128i aLow = _mm_srai_epi16(_mm_unpacklo_epi8(va, va), 8);
+            const __m128i aHigh = _mm_srai_epi16(_mm_unpackhi_epi8(va, va), 8);
+            const __m128i bLow = _mm_srai_epi16(_mm_unpacklo_epi8(vb, vb), 8);
+            const __m128i bHigh = _mm_srai_epi16(_mm_unpackhi_epi8(vb, vb), 8);
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(aLow, bLow));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(aHigh, bHigh));
+        }
+        int32_t sum = sumLanes(acc);
+        for (; i < n; ++i) sum += static_cast<int32_t>(a[i]) * static_cast<int32_t>(b[i]);
+        return sum;
+    }
+}
+
+namespace avx2 {
+    NEEDLE_TARGET_AVX2 inline __m256d expPd(__m256d x) {
+        using namespace expConstants;
+        x = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(minInput)), _mm256_set1_pd(maxInput));
+        const __m128i ni = _mm256_cvtpd_epi32(_mm256_mul_pd(x, _mm256_set1_pd(log2e)));
+        const __m256d n = _mm256_cvtepi32_pd(ni);
+        x = _mm256_fnmadd_pd(n, _mm256_set1_pd(ln2High), x);
+        x = _mm256_fnmadd_pd(n, _mm256_set1_pd(ln2Low), x);
+
+        const __m256d xx = _mm256_mul_pd(x, x);
+        __m256d px = _mm256_fmadd_pd(_mm256_set1_pd(p0), xx, _mm256_set1_pd(p1));
+        px = _mm256_mul_pd(_mm256_fmadd_pd(px, xx, _mm256_set1_pd(p2)), x);
+        __m256d qx = _mm256_fmadd_pd(_mm256_set1_pd(q0), xx, _mm256_set1_pd(q1));
+        qx = _mm256_fmadd_pd(qx, xx, _mm256_set1_pd(q2));
+        qx = _mm256_fmadd_pd(qx, xx, _mm256_set1_pd(q3));
+        x = _mm256_div_pd(px, _mm256_sub_pd(qx, px));
+        x = _mm256_add_pd(_mm256_set1_pd(1.0), _mm256_add_pd(x, x));
+
+        const __m256i exponent = _mm256_slli_epi64(
+            _mm256_cvtepu32_epi64(_mm_add_epi32(ni, _mm_set1_epi32(1023))), 52);
+        return _mm256_mul_pd(x, _mm256_castsi256_pd(exponent));
+    }
+
+    NEEDLE_TARGET_AVX2 inline double dot(const double *a, const double *b, const size_t n) {
+        __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+            acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), acc1);
+        }
+        for (; i + 4 <= n; i += 4) {
+            acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+        }
+        const __m256d acc = _mm256_add_pd(acc0, acc1);
+        const __m128d half = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+        double sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+        for (; i < n; ++i) sum += a[i] * b[i];
+        return sum;
+    }
+
+    NEEDLE_TARGET_AVX2 inline void axpy(const double alpha, const double *x, double *y, const size_t n) {
+        const __m256d a = _mm256_set1_pd(alpha);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(y + i, _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+        }
+        for (; i < n; ++i) y[i] += alpha * x[i];
+    }
+
+    NEEDLE_TARGET_AVX2 inline void add(const double *x, double *y, const size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(y + i, _mm256_add_pd(_mm256_loadu_pd(y + i), _mm256_loadu_pd(x + i)));
+        }
+        for (; i < n; ++i) y[i] += x[i];
+    }
+
+    NEEDLE_TARGET_AVX2 inline void relu(const double *x, double *y, const size_t n) {
+        const __m256d zero = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(y + i, _mm256_max_pd(_mm256_loadu_pd(x + i), zero));
+        }
+        for (; i < n; ++i) y[i] = x[i] < 0.0 ? 0.0 : x[i];
+    }
+
+    NEEDLE_TARGET_AVX2 inline void reluBackward(const double *y, const double *g, double *dx, const size_t n) {
+        const __m256d zero = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            const __m256d mask = _mm256_cmp_pd(_mm256_loadu_pd(y + i), zero, _CMP_GT_OQ);
+            _mm256_storeu_pd(dx + i, _mm256_add_pd(_mm256_loadu_pd(dx + i),
+                                                   _mm256_and_pd(mask, _mm256_loadu_pd(g + i))));
+        }
+        for (; i < n; ++i) dx[i] += y[i] > 0.0 ? g[i] : 0.0;
+    }
+
+    NEEDLE_TARGET_AVX2 inline void exp(const double *x, double *y, const size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(y + i, expPd(_mm256_loadu_pd(x + i)));
+        }
+        for (; i < n; ++i) y[i] = std::exp(x[i]);
+    }
+
+    NEEDLE_TARGET_AVX2 inline void sigmoid(const double *x, double *y, const size_t n) {
+        const __m256d one = _mm256_set1_pd(1.0);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            const __m256d e = expPd(_mm256_sub_pd(_mm256_setzero_pd(), _mm256_loadu_pd(x + i)));
+            _mm256_storeu_pd(y + i, _mm256_div_pd(one, _mm256_add_pd(one, e)));
+        }
+        for (; i < n; ++i) y[i] = 1.0 / (1.0 + std::exp(-x[i]));
+    }
+
+    constexpr size_t gemmRows = 6;
+    constexpr size_t gemmCols = 8;
+
+    // Twelve accumulators hold the 6 x 8 tile, enough independent FMAs to hide their latency on both ports
+    NEEDLE_TARGET_AVX2 inline void gemmTile(const size_t k, const double *a, const double *b, double *c,
+                                            const size_t ldc) {
+        __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd(), c10 = _mm256_setzero_pd();
+        __m256d c11 = _mm256_setzero_pd(), c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+        __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd(), c40 = _mm256_setzero_pd();
+        __m256d c41 = _mm256_setzero_pd(), c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+        for (size_t p = 0; p < k; ++p, a += gemmRows, b += gemmCols) {
+            const __m256d b0 = _mm256_load_pd(b), b1 = _mm256_load_pd(b + 4);
+            __m256d ar = _mm256_broadcast_sd(a);
+            c00 = _mm256_fmadd_pd(ar, b0, c00);
+            c01 = _mm256_fmadd_pd(ar, b1, c01);
+            ar = _mm256_broadcast_sd(a + 1);
+            c10 = _mm256_fmadd_pd(ar, b0, c10);
+            c11 = _mm256_fmadd_pd(ar, b1, c11);
+            ar = _mm256_broadcast_sd(a + 2);
+            c20 = _mm256_fmadd_pd(ar, b0, c20);
+            c21 = _mm256_fmadd_pd(ar, b1, c21);
+            ar = _mm256_broadcast_sd(a + 3);
+            c30 = _mm256_fmadd_pd(ar, b0, c30);
+            c31 = _mm256_fmadd_pd(ar, b1, c31);
+            ar = _mm256_broadcast_sd(a + 4);
+            c40 = _mm256_fmadd_pd(ar, b0, c40);
+            c41 = _mm256_fmadd_pd(ar, b1, c41);
+            ar = _mm256_broadcast_sd(a + 5);
+            c50 = _mm256_fmadd_pd(ar, b0, c50);
+            c51 = _mm256_fmadd_pd(ar, b1, c51);
+        }
+        const __m256d tile[gemmRows][2] = {{c00, c01}, {c10, c11}, {c20, c21}, {c30, c31}, {c40, c41}, {c50, c51}};
+        for (size_t r = 0; r < gemmRows; ++r) {
+            double *row = c + r * ldc;
+            _mm256_storeu_pd(row, _mm256_add_pd(_mm256_loadu_pd(row), tile[r][0]));
+            _mm256_storeu_pd(row + 4, _mm256_add_pd(_mm256_loadu_pd(row + 4), tile[r][1]));
+        }
+    }
+
+    NEEDLE_TARGET_AVX2 inline __m256 expPs(__m256 x) {
+        using namespace expfConstants;
+        x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(minInput)), _mm256_set1_ps(maxInput));
+        const __m256i ni = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(log2e)));
+        const __m256 n = _mm256_cvtepi32_ps(ni);
+        x = _mm256_fnmadd_ps(n, _mm256_set1_ps(ln2High), x);
+        x = _mm256_fnmadd_ps(n, _mm256_set1_ps(ln2Low), x);
+
+        __m256 y = _mm256_fmadd_ps(_mm256_set1_ps(p0), x, _mm256_set1_ps(p1));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(p2));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(p3));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(p4));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(p5));
+        y = _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), _mm256_add_ps(x, _mm256_set1_ps(1.0f)));
+
+        const __m256i exponent = _mm256_slli_epi32(_mm256_add_epi32(ni, _mm256_set1_epi32(127)), 23);
+        return _mm256_mul_ps(y, _mm256_castsi256_ps(exponent));
+    }
+
+    NEEDLE_TARGET_AVX2 inline float dot(const float *a, const float *b, const size_t n) {
+        __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+            acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+        }
+        for (; i + 8 <= n; i += 8) {
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        }
+        const __m256 acc = _mm256_add_ps(acc0, acc1);
+        __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+        float sum = _mm_cvtss_f32(_mm_add_ss(half, _mm_movehdup_ps(half)));
+        for (; i < n; ++i) sum += a[i] * b[i];
+        return sum;
+    }
+
+    NEEDLE_TARGET_AVX2 inline void axpy(const float alpha, const float *x, float *y, const size_t n) {
+        const __m256 a = _mm256_set1_ps(alpha);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(y + i, _mm256_fmadd_ps(a, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+        }
+        for (; i < n; ++i) y[i] += alpha * x[i];
+    }
+
+    NEEDLE_TARGET_AVX2 inline void add(const float *x, float *y, const size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_loadu_ps(x + i)));
+        }
+        for (; i < n; ++i) y[i] += x[i];
+    }
+
+    NEEDLE_TARGET_AVX2 inline void relu(const float *x, float *y, const size_t n) {
+        const __m256 zero = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(y + i, _mm256_max_ps(_mm256_loadu_ps(x + i), zero));
+        }
+        for (; i < n; ++i) y[i] = x[i] < 0.0f ? 0.0f : x[i];
+    }
+
+    NEEDLE_TARGET_AVX2 inline void reluBackward(const float *y, const float *g, float *dx, const size_t n) {
+        const __m256 zero = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            const __m256 mask = _mm256_cmp_ps(_mm256_loadu_ps(y + i), zero, _CMP_GT_OQ);
+            _mm256_storeu_ps(dx + i, _mm256_add_ps(_mm256_loadu_ps(dx + i),
+                                                   _mm256_and_ps(mask, _mm256_loadu_ps(g + i))));
+        }
+        for (; i < n; ++i) dx[i] += y[i] > 0.0f ? g[i] : 0.0f;
+    }
+
+    NEEDLE_TARGET_AVX2 inline void exp(const float *x, float *y, const size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(y + i, expPs(_mm256_loadu_ps(x + i)));
+        }
+        for (; i < n; ++i) y[i] = std::exp(x[i]);
+    }
+
+    NEEDLE_TARGET_AVX2 inline void sigmoid(const float *x, float *y, const size_t n) {
+        const __m256 one = _mm256_set1_ps(1.0f);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            const __m256 e = expPs(_mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(x + i)));
+            _mm256_storeu_ps(y + i, _mm256_div_ps(one, _mm256_add_ps(one, e)));
+        }
+        for (; i < n; ++i) y[i] = 1.0f / (1.0f + std::exp(-x[i]));
+    }
+
+    NEEDLE_TARGET_AVX2 inline int32_t dotInt8(const int8_t *a, const int8_t *b, const size_t n) {
+        __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            const __m256i a0 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)));
+            const __m256i b0 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)));
+            const __m256i a1 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i + 16)));
+            const __m256i b1 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i + 16)));
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(a0, b0));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(a1, b1));
+        }
+        const __m256i acc = _mm256_add_epi32(acc0, acc1);
+        const __m128i half = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        int32_t lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), half);
+        int32_t sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        for (; i < n; ++i) sum += static_cast<int32_t>(a[i]) * static_cast<int32_t>(b[i]);
+        return sum;
+    }
+
+    constexpr size_t floatGemmRows = 6;
+    constexpr size_t floatGemmCols = 16;
+
+    // The same register layout as the double tile, with twice as many columns per register
+    NEEDLE_TARGET_AVX2 inline void gemmTile(const size_t k, const float *a, const float *b, float *c,
+                                            const size_t ldc) {
+        __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps(), c10 = _mm256_setzero_ps();
+        __m256 c11 = _mm256_setzero_ps(), c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+        __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps(), c40 = _mm256_setzero_ps();
+        __m256 c41 = _mm256_setzero_ps(), c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+        for (size_t p = 0; p < k; ++p, a += floatGemmRows, b += floatGemmCols) {
+            const __m256 b0 = _mm256_load_ps(b), b1 = _mm256_load_ps(b + 8);
+            __m256 ar = _mm256_broadcast_ss(a);
+            c00 = _mm256_fmadd_ps(ar, b0, c00);
+            c01 = _mm256_fmadd_ps(ar, b1, c01);
+            ar = _mm256_broadcast_ss(a + 1);
+            c10 = _mm256_fmadd_ps(ar, b0, c10);
+            c11 = _mm256_fmadd_ps(ar, b1, c11);
+            ar = _mm256_broadcast_ss(a + 2);
+            c20 = _mm256_fmadd_ps(ar, b0, c20);
+            c21 = _mm256_fmadd_ps(ar, b1, c21);
+            ar = _mm256_broadcast_ss(a + 3);
+            c30 = _mm256_fmadd_ps(ar, b0, c30);
+            c31 = _mm256_fmadd_ps(ar, b1, c31);
+            ar = _mm256_broadcast_ss(a + 4);
+            c40 = _mm256_fmadd_ps(ar, b0, c40);
+            c41 = _mm256_fmadd_ps(ar, b1, c41);
+            ar = _mm256_broadcast_ss(a + 5);
+            c50 = _mm256_fmadd_ps(ar, b0, c50);
+            c51 = _mm256_fmadd_ps(ar, b1, c51);
+        }
+        const __m256 tile[floatGemmRows][2] = {
+            {c00, c01}, {c10, c11}, {c20, c21}, {c30, c31}, {c40, c41}, {c50, c51}
+        };
+        for (size_t r = 0; r < floatGemmRows; ++r) {
+            float *row = c + r * ldc;
+            _mm256_storeu_ps(row, _mm256_add_ps(_mm256_loadu_ps(row), tile[r][0]));
+            _mm256_storeu_ps(row + 8, _mm256_add_ps(_mm256_loadu_ps(row + 8), tile[r][1]));
+        }
+    }
+}
+
+// GCC implements the undefined-vector intrinsics as self-initialized variables, which it then reports as uninitialized
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+namespace avx512 {
+    NEEDLE_TARGET_AVX512 inline __m512d expPd(__m512d x) {
+        using namespace expConstants;
+        x = _mm512_min_pd(_mm512_max_pd(x, _mm512_set1_pd(minInput)), _mm512_set1_pd(maxInput));
+        const __m256i ni = _mm512_cvtpd_epi32(_mm512_mul_pd(x, _mm512_set1_pd(log2e)));
+        const __m512d n = _mm512_cvtepi32_pd(ni);
+        x = _mm512_fnmadd_pd(n, _mm512_set1_pd(ln2High), x);
+        x = _mm512_fnmadd_pd(n, _mm512_set1_pd(ln2Low), x);
+
+        const __m512d xx = _mm512_mul_pd(x, x);
+        __m512d px = _mm512_fmadd_pd(_mm512_set1_pd(p0), xx, _mm512_set1_pd(p1));
+        px = _mm512_mul_pd(_mm512_fmadd_pd(px, xx, _mm512_set1_pd(p2)), x);
+        __m512d qx = _mm512_fmadd_pd(_mm512_set1_pd(q0), xx, _mm512_set1_pd(q1));
+        qx = _mm512_fmadd_pd(qx, xx, _mm512_set1_pd(q2));
+        qx = _mm512_fmadd_pd(qx, xx, _mm512_set1_pd(q3));
+        x = _mm512_div_pd(px, _mm512_sub_pd(qx, px));
+        x = _mm512_add_pd(_mm512_set1_pd(1.0), _mm512_add_pd(x, x));
+
+        const __m512i exponent = _mm512_slli_epi64(
+            _mm512_cvtepu32_epi64(_mm256_add_epi32(ni, _mm256_set1_epi32(1023))), 52);
+        return _mm512_mul_pd(x, _mm512_castsi512_pd(exponent));
+    }
+
+    NEEDLE_TARGET_AVX512 inline double dot(const double *a, const double *b, const size_t n) {
+        __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), acc0);
+            acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8), acc1);
+        }
+        if (i < n) {
+            // The remaining elements are loaded with a mask, so there is no scalar tail
+            for (; i < n; i += 8) {
+                const __mmask8 mask = n - i >= 8 ? static_cast<__mmask8>(0xFF)
+                                                 : static_cast<__mmask8>((1u << (n - i)) - 1);
+                acc0 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a + i), _mm512_maskz_loadu_pd(mask, b + i), acc0);
+            }
+        }
+        return _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1));
+    }
+
+    NEEDLE_TARGET_AVX512 inline void axpy(const double alpha, const double *x, double *y, const size_t n) {
+        const __m512d a = _mm512_set1_pd(alpha);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm512_storeu_pd(y + i, _mm512_fmadd_pd(a, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+        }
+        for (; i < n; ++i) y[i] += alpha * x[i];
+    }
+
+    NEEDLE_TARGET_AVX512 inline void add(const double *x, double *y, const size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm512_storeu_pd(y + i, _mm512_add_pd(_mm512_loadu_pd(y + i), _mm512_loadu_pd(x + i)));
+        }
+        for (; i < n; ++i) y[i] += x[i];
+    }
+
+    NEEDLE_TARGET_AVX512 inline void relu(const double *x, double *y, const size_t n) {
+        const __m512d zero = _mm512_setzero_pd();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm512_storeu_pd(y + i, _mm512_max_pd(_mm512_loadu_pd(x + i), zero));
+        }
+        for (; i < n; ++i) y[i] = x[i] < 0.0 ? 0.0 : x[i];
+    }
+
+    NEEDLE_TARGET_AVX512 inline void reluBackward(const double *y, const double *g, double *dx, const size_t n) {
+        const __m512d zero = _mm512_setzero_pd();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            const __mmask8 positive = _mm512_cmp_pd_mask(_mm512_loadu_pd(y + i), zero, _CMP_GT_OQ);
+            const __m512d current = _mm512_loadu_pd(dx + i);
+            _mm512_storeu_pd(dx + i, _mm512_mask_add_pd(current, positive, current, _mm512_loadu_pd(g + i)));
+        }
+        for (; i < n; ++i) dx[i] += y[i] > 0.0 ? g[i] : 0.0;
+    }
+
+    NEEDLE_TARGET_AVX512 inline void exp(const double *x, double *y, const size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm512_storeu_pd(y + i, expPd(_mm512_loadu_pd(x + i)));
+        }
+        for (; i < n; ++i) y[i] = std::exp(x[i]);
+    }
+
+    NEEDLE_TARGET_AVX512 inline void sigmoid(const double *x, double *y, const size_t n) {
+        const __m512d one = _mm512_set1_pd(1.0);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            const __m512d e = expPd(_mm512_sub_pd(_mm512_setzero_pd(), _mm512_loadu_pd(x + i)));
+            _mm512_storeu_pd(y + i, _mm512_div_pd(one, _mm512_add_pd(one, e)));
+        }
+        for (; i < n; ++i) y[i] = 1.0 / (1.0 + std::exp(-x[i]));
+    }
+
+    constexpr size_t gemmRows = 8;
+    constexpr size_t gemmCols = 16;
+
+    // The loops are unrolled by hand: an array of accumulators is not kept in registers without -O3
+    NEEDLE_TARGET_AVX512 inline void gemmTile(const size_t k, const double *a, const double *b, double *c,
+                                              const size_t ldc) {
+        __m512d c00 = _mm512_setzero_pd(), c01 = _mm512_setzero_pd(), c10 = _mm512_setzero_pd();
+        __m512d c11 = _mm512_setzero_pd(), c20 = _mm512_setzero_pd(), c21 = _mm512_setzero_pd();
+        __m512d c30 = _mm512_setzero_pd(), c31 = _mm512_setzero_pd(), c40 = _mm512_setzero_pd();
+        __m512d c41 = _mm512_setzero_pd(), c50 = _mm512_setzero_pd(), c51 = _mm512_setzero_pd();
+        __m512d c60 = _mm512_setzero_pd(), c61 = _mm512_setzero_pd(), c70 = _mm512_setzero_pd();
+        __m512d c71 = _mm512_setzero_pd();
+        for (size_t p = 0; p < k; ++p, a += gemmRows, b += gemmCols) {
+            const __m512d b0 = _mm512_load_pd(b), b1 = _mm512_load_pd(b + 8);
+            __m512d ar = _mm512_set1_pd(a[0]);
+            c00 = _mm512_fmadd_pd(ar, b0, c00);
+            c01 = _mm512_fmadd_pd(ar, b1, c01);
+            ar = _mm512_set1_pd(a[1]);
+            c10 = _mm512_fmadd_pd(ar, b0, c10);
+            c11 = _mm512_fmadd_pd(ar, b1, c11);
+            ar = _mm512_set1_pd(a[2]);
+            c20 = _mm512_fmadd_pd(ar, b0, c20);
+            c21 = _mm512_fmadd_pd(ar, b1, c21);
+            ar = _mm512_set1_pd(a[3]);
+            c30 = _mm512_fmadd_pd(ar, b0, c30);
+            c31 = _mm512_fmadd_pd(ar, b1, c31);
+            ar = _mm512_set1_pd(a[4]);
+            c40 = _mm512_fmadd_pd(ar, b0, c40);
+            c41 = _mm512_fmadd_pd(ar, b1, c41);
+            ar = _mm512_set1_pd(a[5]);
+            c50 = _mm512_fmadd_pd(ar, b0, c50);
+            c51 = _mm512_fmadd_pd(ar, b1, c51);
+            ar = _mm512_set1_pd(a[6]);
+            c60 = _mm512_fmadd_pd(ar, b0, c60);
+            c61 = _mm512_fmadd_pd(ar, b1, c61);
+            ar = _mm512_set1_pd(a[7]);
+            c70 = _mm512_fmadd_pd(ar, b0, c70);
+            c71 = _mm512_fmadd_pd(ar, b1, c71);
+        }
+        const __m512d tile[gemmRows][2] = {
+            {c00, c01}, {c10, c11}, {c20, c21}, {c30, c31}, {c40, c41}, {c50, c51}, {c60, c61}, {c70, c71}
+        };
+        for (size_t r = 0; r < gemmRows; ++r) {
+            double *row = c + r * ldc;
+            _mm512_storeu_pd(row, _mm512_add_pd(_mm512_loadu_pd(row), tile[r][0]));
+            _mm512_storeu_pd(row + 8, _mm512_add_pd(_mm512_loadu_pd(row + 8), tile[r][1]));
+        }
+    }
+
+    NEEDLE_TARGET_AVX512 inline __m512 expPs(__m512 x) {
+        using namespace expfConstants;
+        x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(minInput)), _mm512_set1_ps(maxInput));
+        const __m512i ni = _mm512_cvtps_epi32(_mm512_mul_ps(x, _mm512_set1_ps(log2e)));
+        const __m512 n = _mm512_cvtepi32_ps(ni);
+        x = _mm512_fnmadd_ps(n, _mm512_set1_ps(ln2High), x);
+        x = _mm512_fnmadd_ps(n, _mm512_set1_ps(ln2Low), x);
+
+        __m512 y = _mm512_fmadd_ps(_mm512_set1_ps(p0), x, _mm512_set1_ps(p1));
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(p2));
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(p3));
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(p4));
+        y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(p5));
+        y = _mm512_fmadd_ps(y, _mm512_mul_ps(x, x), _mm512_add_ps(x, _mm512_set1_ps(1.0f)));
+
+        const __m512i exponent = _mm512_slli_epi32(_mm512_add_epi32(ni, _mm512_set1_epi32(127)), 23);
+        return _mm512_mul_ps(y, _mm512_castsi512_ps(exponent));
+    }
+
+    NEEDLE_TARGET_AVX512 inline float dot(const float *a, const float *b, const size_t n) {
+        __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+            acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), acc1);
+        }
+        for (; i < n; i += 16) {
+            const __mmask16 mask = n - i >= 16 ? static_cast<__mmask16>(0xFFFF)
+                                               : static_cast<__mmask16>((1u << (n - i)) - 1);
+            acc0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i), acc0);
+        }
+        return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+    }
+
+    NEEDLE_TARGET_AVX512 inline void axpy(const float alpha, const float *x, float *y, const size_t n) {
+        const __m512 a = _mm512_set1_ps(alpha);
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            _mm512_storeu_ps(y + i, _mm512_fmadd_ps(a, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+        }
+        for (; i < n; ++i) y[i] += alpha * x[i];
+    }
+
+    NEEDLE_TARGET_AVX512 inline void add(const float *x, float *y, const size_t n) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            _mm512_storeu_ps(y + i, _mm512_add_ps(_mm512_loadu_ps(y + i), _mm512_loadu_ps(x + i)));
+        }
+        for (; i < n; ++i) y[i] += x[i];
+    }
+
+    NEEDLE_TARGET_AVX512 inline void relu(const float *x, float *y, const size_t n) {
+        const __m512 zero = _mm512_setzero_ps();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            _mm512_storeu_ps(y + i, _mm512_max_ps(_mm512_loadu_ps(x + i), zero));
+        }
+        for (; i < n; ++i) y[i] = x[i] < 0.0f ? 0.0f : x[i];
+    }
+
+    NEEDLE_TARGET_AVX512 inline void reluBackward(const float *y, const float *g, float *dx, const size_t n) {
+        const __m512 zero = _mm512_setzero_ps();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __mmask16 positive = _mm512_cmp_ps_mask(_mm512_loadu_ps(y + i), zero, _CMP_GT_OQ);
+            const __m512 current = _mm512_loadu_ps(dx + i);
+            _mm512_storeu_ps(dx + i, _mm512_mask_add_ps(current, positive, current, _mm512_loadu_ps(g + i)));
+        }
+        for (; i < n; ++i) dx[i] += y[i] > 0.0f ? g[i] : 0.0f;
+    }
+
+    NEEDLE_TARGET_AVX512 inline void exp(const float *x, float *y, const size_t n) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            _mm512_storeu_ps(y + i, expPs(_mm512_loadu_ps(x + i)));
+        }
+        for (; i < n; ++i) y[i] = std::exp(x[i]);
+    }
+
+    NEEDLE_TARGET_AVX512 inline void sigmoid(const float *x, float *y, const size_t n) {
+        const __m512 one = _mm512_set1_ps(1.0f);
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __m512 e = expPs(_mm512_sub_ps(_mm512_setzero_ps(), _mm512_loadu_ps(x + i)));
+            _mm512_storeu_ps(y + i, _mm512_div_ps(one, _mm512_add_ps(one, e)));
+        }
+        for (; i < n; ++i) y[i] = 1.0f / (1.0f + std::exp(-x[i]));
+    }
+
+    NEEDLE_TARGET_AVX512 inline int32_t dotInt8(const int8_t *a, const int8_t *b, const size_t n) {
+        __m512i acc = _mm512_setzero_si512();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __m512i va = _mm512_cvtepi8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)));
+            const __m512i vb = _mm512_cvtepi8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)));
+            acc = _mm512_add_epi32(acc, _mm512_mullo_epi32(va, vb));
+        }
+        int32_t sum = _mm512_reduce_add_epi32(acc);
+        for (; i < n; ++i) sum += static_cast<int32_t>(a[i]) * static_cast<int32_t>(b[i]);
+        return sum;
+    }
+
+    constexpr size_t floatGemmRows = 8;
+    constexpr size_t floatGemmCols = 32;
+
+    NEEDLE_TARGET_AVX512 inline void gemmTile(const size_t k, const float *a, const float *b, float *c,
+                                              const size_t ldc) {
+        __m512 c00 = _mm512_setzero_ps(), c01 = _mm512_setzero_ps(), c10 = _mm512_setzero_ps();
+        __m512 c11 = _mm512_setzero_ps(), c20 = _mm512_setzero_ps(), c21 = _mm512_setzero_ps();
+        __m512 c30 = _mm512_setzero_ps(), c31 = _mm512_setzero_ps(), c40 = _mm512_setzero_ps();
+        __m512 c41 = _mm512_setzero_ps(), c50 = _mm512_setzero_ps(), c51 = _mm512_setzero_ps();
+        __m512 c60 = _mm512_setzero_ps(), c61 = _mm512_setzero_ps(), c70 = _mm512_setzero_ps();
+        __m512 c71 = _mm512_setzero_ps();
+        for (size_t p = 0; p < k; ++p, a += floatGemmRows, b += floatGemmCols) {
+            const __m512 b0 = _mm512_load_ps(b), b1 = _mm512_load_ps(b + 16);
+            __m512 ar = _mm512_set1_ps(a[0]);
+            c00 = _mm512_fmadd_ps(ar, b0, c00);
+            c01 = _mm512_fmadd_ps(ar, b1, c01);
+            ar = _mm512_set1_ps(a[1]);
+            c10 = _mm512_fmadd_ps(ar, b0, c10);
+            c11 = _mm512_fmadd_ps(ar, b1, c11);
+            ar = _mm512_set1_ps(a[2]);
+            c20 = _mm512_fmadd_ps(ar, b0, c20);
+            c21 = _mm512_fmadd_ps(ar, b1, c21);
+            ar = _mm512_set1_ps(a[3]);
+            c30 = _mm512_fmadd_ps(ar, b0, c30);
+            c31 = _mm512_fmadd_ps(ar, b1, c31);
+            ar = _mm512_set1_ps(a[4]);
+            c40 = _mm512_fmadd_ps(ar, b0, c40);
+            c41 = _mm512_fmadd_ps(ar, b1, c41);
+            ar = _mm512_set1_ps(a[5]);
+            c50 = _mm512_fmadd_ps(ar, b0, c50);
+            c51 = _mm512_fmadd_ps(ar, b1, c51);
+            ar = _mm512_set1_ps(a[6]);
+            c60 = _mm512_fmadd_ps(ar, b0, c60);
+            c61 = _mm512_fmadd_ps(ar, b1, c61);
+            ar = _mm512_set1_ps(a[7]);
+            c70 = _mm512_fmadd_ps(ar, b0, c70);
+            c71 = _mm512_fmadd_ps(ar, b1, c71);
+        }
+        const __m512 tile[floatGemmRows][2] = {
+            {c00, c01}, {c10, c11}, {c20, c21}, {c30, c31}, {c40, c41}, {c50, c51}, {c60, c61}, {c70, c71}
+        };
+        for (size_t r = 0; r < floatGemmRows; ++r) {
+            float *row = c + r * ldc;
+            _mm512_storeu_ps(row, _mm512_add_ps(_mm512_loadu_ps(row), tile[r][0]));
+            _mm512_storeu_ps(row + 16, _mm512_add_ps(_mm512_loadu_ps(row + 16), tile[r][1]));
+        }
+    }
+}
+#pragma GCC diagnostic pop
+}
+
+#undef NEEDLE_TARGET_SSE2
+#undef NEEDLE_TARGET_AVX2
+#undef NEEDLE_TARGET_AVX512
+#endif
+
+#endif //X86KERNELS_H
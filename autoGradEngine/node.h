@@ -4,8 +4,51 @@
 #include <functional>
 #include <string>
 #include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <initializer_list>
 #include <unordered_set>
 #include <iostream>
+#include <utility>
+#include <new>
+#include <autoGradEngine/graphArena.h>
+
+/**
+ * The operation that produced a node. The backward pass dispatches on it instead of calling a closure per node, so a
+ * node does not need to carry a type-erased function around, and the branches of the dispatch are easy to predict
+ * since graphs are made of a handful of operations repeated many times.
+ */
+enum class NodeOp : std::uint8_t {
+    LEAF,
+    VIEW,
+    ADD,
+    ADD_CONSTANT,
+    MUL,
+    MUL_CONSTANT,
+    DIV,
+    DIV_BY_CONSTANT,
+    CONSTANT_DIV,
+    POW,
+    LOG,
+    WEIGHTED_SUM,
+    DENSE_ROW,
+    RELU,
+    SIGMOID,
+    SOFTMAX,
+    SOFTMAX_CROSS_ENTROPY,
+    SIGMOID_CROSS_ENTROPY
+};
+
+/**
+ * @return The printable name of an operation, used for debugging
+ */
+inline const char *nodeOpName(const NodeOp op) {
+    static const char *const names[] = {
+        "", "view", "+", "+", "*", "*", "/", "/", "/", "**", "log", "dot", "dot", "ReLU", "sigmoid", "softmax",
+        "softmax_cross_entropy", "sigmoid_cross_entropy"
+    };
+    return names[static_cast<size_t>(op)];
+}
 
 /**
 * An auto-differentiation engine that is based on an expression tree, where the gradients flow from
@@ -15,31 +58,192 @@
 *
 * The inspiration for the implementation of this class is taken by the Wikipedia article about auto-differentiation:
 * https://en.wikipedia.org/wiki/Automatic_differentiation
+*
+* A node is kept compact: the operation is an opcode, up to two parents are stored inline and only n-ary operations
+* (weighted sums, softmax) need a separate parent array. The few constants that an operation needs to run its backward
+* pass live in a small payload next to the parents, and the dense row of a layer neuron, which would make that payload
+* four pointers wide, lives out of line behind its parents. On 64-bit targets a Node takes 80 bytes, down from the 104
+* of the closure-based node this replaced, and a BasicNode<float> 64; 16 of them are the references to the value and
+* the gradient, which let views alias the storage of a layer.
+*
+* Nodes that are created while a GraphScope is open are allocated from its arena and released together with it, so the
+* intermediate graph of a training step does not have to be deleted node by node. Such nodes take their parent arrays
+* from the arena as well, so releasing them does not even require running their destructors.
+*
+* The node is a template over the floating point type of its value and gradient. Node is the double precision one;
+* BasicNode<float> halves the memory traffic of a graph. Constants that are passed to the operations are given as
+* double and rounded to the scalar type of the node.
 */
-class Node {
+template<typename Scalar>
+class BasicNode : public ArenaAllocated<BasicNode<Scalar>, false> {
+    // the storage of the value and the gradient, unless the node is a view over external storage
+    Scalar value;
+    Scalar gradient;
+
+public:
+    // a single scalar value and its gradient
+    Scalar &data;
+    Scalar &grad;
+
+private:
+    NodeOp op;
+    bool ownsParents; // the parent array was allocated on the heap and is freed with the node
+    bool pending; // the root of the running tape replay depends on the node, which still has to be propagated
+    std::uint32_t numberOfParents;
+
+    union {
+        BasicNode *inlineParents[2];
+        BasicNode **overflowParents;
+    };
+
+    BasicNode(Scalar &data, Scalar &grad)
+        : value(0), gradient(0), data(data), grad(grad), op(NodeOp::VIEW), ownsParents(false), pending(false),
+          numberOfParents(0), inlineParents{nullptr, nullptr}, payload() {
+    }
+
+    /**
+     * @return True if the parents are kept in a separate array, which dense rows always need to store their row
+     */
+    bool parentsOutOfLine() const {
+        return numberOfParents > 2 || op == NodeOp::DENSE_ROW;
+    }
+
+    void setParents(BasicNode *const *parents, const size_t count) {
+        numberOfParents = static_cast<std::uint32_t>(count);
+        BasicNode **target = inlineParents;
+        if (parentsOutOfLine()) {
+            const size_t bytes = count * sizeof(BasicNode *) + (op == NodeOp::DENSE_ROW ? sizeof(DenseRow) : 0);
+            GraphArena *arena = GraphArena::active();
+            if (arena) {
+                target = static_cast<BasicNode **>(arena->allocate(bytes, alignof(BasicNode *)));
+            } else {
+                target = static_cast<BasicNode **>(::operator new(bytes));
+                ownsParents = true;
+            }
+            overflowParents = target;
+        }
+        std::copy(parents, parents + count, target);
+
+        // Leaves have nothing to propagate, so only computed nodes go on the tape
+        GraphArena *arena = GraphArena::active();
+        if (count > 0 && arena && arena->recording()) {
+            arena->record(this);
+        }
+    }
+
 public:
-    // stores a single scalar value and its gradient
-    double data;
-    double grad;
+    /**
+     * The row of a dense weight matrix that a DENSE_ROW node reads its weights from, and where it writes their
+     * gradients.
+     */
+    struct DenseRow {
+        const Scalar *weights;
+        Scalar *weightGradients;
+        const Scalar *bias;
+        Scalar *biasGradient;
+    };
 
-    // internal variables used for autograd graph construction
-    std::function<void()> backwardProp;
-    std::vector<Node *> previousNodes; // parents in the computation graph
-    std::string operation; // the operation that produced this node could be arithmetic or another function
+    /**
+     * The operation specific state of a node, the constants that its backward pass needs besides the parents.
+     */
+    union Payload {
+        Scalar constant; // the constant operand, the exponent of pow, the epsilon of log or a binary target
+        size_t length; // the length of a weighted sum over weight nodes
+        const DenseRow *row; // the dense row that a weighted sum reads its weights from, stored out of line
+
+        struct {
+            Scalar maxLogit;
+            Scalar sumExp;
+            size_t index;
+        } softmax; // what is needed to recompute the probabilities of the softmax, the index is the target class of
+                   // a fused softmax cross-entropy
+    } payload;
+
+private:
+    /**
+     * @brief Stores @p row right behind the parents of a DENSE_ROW node and points the payload to it.
+     */
+    void setRow(const DenseRow &row) {
+        payload.row = new(overflowParents + numberOfParents) DenseRow(row);
+    }
 
+public:
     /**
-     * @brief Constructs the node object given the data, the children that derived it and the operation that was used
-     * to compute the data.
+     * @brief Constructs a leaf node, a value that was not computed from other nodes.
      *
      * @param data - The scalar data that the node encapsulates
-     * @param children - The immediate nodes that were involved in the computation of the current node
-     * @param op - The operation which the children underwent to produce the parent node
      */
-    explicit Node(double data, const std::vector<Node *> &children = {}, const std::string &op = "")
-        : data(data), grad(0.0), backwardProp([] {
-        }), previousNodes(children), operation(op) {
+    explicit BasicNode(const Scalar data) : BasicNode(data, NodeOp::LEAF, nullptr, 0) {
     }
 
+    /**
+     * @brief Constructs the node object given the data, the operation that was used to compute it and the parents that
+     * were involved in the computation.
+     *
+     * @param data - The scalar data that the node encapsulates
+     * @param op - The operation which the parents underwent to produce the node
+     * @param parents - The immediate nodes that were involved in the computation of the current node
+     * @param count - The number of parents
+     */
+    BasicNode(const Scalar data, const NodeOp op, BasicNode *const *parents, const size_t count)
+        : value(data), gradient(0), data(value), grad(gradient), op(op), ownsParents(false), pending(false),
+          numberOfParents(0), inlineParents{nullptr, nullptr}, payload() {
+        setParents(parents, count);
+    }
+
+    BasicNode(const Scalar data, const NodeOp op, std::initializer_list<BasicNode *> parents)
+        : BasicNode(data, op, parents.begin(), parents.size()) {
+    }
+
+    BasicNode(const BasicNode &other)
+        : value(other.data), gradient(other.grad), data(value), grad(gradient),
+          op(other.op == NodeOp::VIEW ? NodeOp::LEAF : other.op), ownsParents(false), pending(false),
+          numberOfParents(0),
+          inlineParents{nullptr, nullptr}, payload(other.payload) {
+        setParents(other.parents(), other.parentCount());
+        if (op == NodeOp::DENSE_ROW) setRow(*other.payload.row);
+    }
+
+    BasicNode &operator=(const BasicNode &) = delete;
+
+    ~BasicNode() {
+        if (ownsParents) ::operator delete(overflowParents);
+    }
+
+    /**
+     * @brief Creates a node that reads and writes its value and gradient from storage that is owned by someone else.
+     * Layers keep their parameters in dense matrices and hand out views of them, so that code working on Node
+     * pointers (the optimizer, the serializer) still sees every single weight.
+     *
+     * @param data - The external value
+     * @param grad - The external gradient
+     */
+    static BasicNode *view(Scalar &data, Scalar &grad) {
+        return new BasicNode(data, grad);
+    }
+
+    NodeOp opcode() const {
+        return op;
+    }
+
+    /**
+     * @return The name of the operation that produced this node, for debugging
+     */
+    const char *operation() const {
+        return nodeOpName(op);
+    }
+
+    size_t parentCount() const {
+        return numberOfParents;
+    }
+
+    BasicNode *const *parents() const {
+        return parentsOutOfLine() ? overflowParents : inlineParents;
+    }
+
+    BasicNode *parent(const size_t i) const {
+        return parents()[i];
+    }
 
     /**
      * @brief Raises the data of the calling node object to the power specified by the parameter {other}
@@ -47,15 +251,10 @@ public:
      * @param other - The exponent of the power function
      * @return
      */
-    Node *pow(double other) {
-        auto self = this;
-        const double out_data = std::pow(self->data, other);
-        auto out = new Node(out_data, {self}, "**" + std::to_string(other));
-
-        out->backwardProp = [self, out, other]() {
-            self->grad += (other * std::pow(self->data, other - 1)) * out->grad;
-        };
-
+    BasicNode *pow(const double other) {
+        const Scalar exponent = static_cast<Scalar>(other);
+        auto out = new BasicNode(std::pow(data, exponent), NodeOp::POW, {this});
+        out->payload.constant = exponent;
         return out;
     }
 
@@ -65,51 +264,368 @@ public:
      * @param epsilon - Minimum input to the log function
      * @return - Returns a new node with data = log(x)
      */
-    static Node *logNode(Node *x, double epsilon = 1e-7) {
-        auto self = x;
+    static BasicNode *logNode(BasicNode *x, const double epsilon = 1e-7) {
         // We clamp the data so that we do not run into issue that are caused by the calculation of log(0)
-        const double clampedData = std::max(self->data, epsilon);
-        const double outData = std::log(clampedData);
-        auto out = new Node(outData, {self}, "log");
+        const Scalar minimum = static_cast<Scalar>(epsilon);
+        const Scalar clampedData = std::max(x->data, minimum);
+        auto out = new BasicNode(std::log(clampedData), NodeOp::LOG, {x});
+        out->payload.constant = minimum;
+        return out;
+    }
 
-        out->backwardProp = [self, out, epsilon]() {
-            const double clamped = std::max(self->data, epsilon);
-            self->grad += (1.0 / clamped) * out->grad;
-        };
+    /**
+     * @brief Computes bias + sum(weights[i] * inputs[i]) as a single node. Compared to chaining additions and
+     * multiplications, this creates one node instead of 2n, keeps the depth of the graph constant, and both passes are
+     * one tight loop over the weights and the inputs.
+     *
+     * @param weights - The weights of the dot product
+     * @param inputs - The inputs of the dot product, the same length as @p weights
+     * @param bias - The bias that is added to the dot product
+     * @return - A new node with the value of the weighted sum
+     */
+    static BasicNode *weightedSum(const std::vector<BasicNode *> &weights, const std::vector<BasicNode *> &inputs, BasicNode *bias) {
+        const size_t n = weights.size();
+
+        // The parents are laid out as [w_0 ... w_n-1, x_0 ... x_n-1, bias]
+        std::vector<BasicNode *> children;
+        children.reserve(2 * n + 1);
+        children.insert(children.end(), weights.begin(), weights.end());
+        children.insert(children.end(), inputs.begin(), inputs.begin() + static_cast<std::ptrdiff_t>(n));
+        children.push_back(bias);
+
+        Scalar sum = bias->data;
+        for (size_t i = 0; i < n; ++i) {
+            sum += weights[i]->data * inputs[i]->data;
+        }
+        auto out = new BasicNode(sum, NodeOp::WEIGHTED_SUM, children.data(), children.size());
+        out->payload.length = n;
+        return out;
+    }
 
+    /**
+     * @brief Computes bias + sum(weights[i] * inputs[i]) for a row of a dense weight matrix. It behaves like the
+     * overload over weight nodes, but reads the weights from contiguous memory and writes their gradients into the
+     * matching row of the gradient matrix, so only the inputs are parents in the graph.
+     *
+     * @param weights - The row of weights, @p n contiguous values
+     * @param weightGradients - The row of the gradient matrix that matches @p weights
+     * @param bias - The bias that is added to the dot product
+     * @param biasGradient - The gradient of the bias
+     * @param inputs - The inputs of the dot product, at least @p n of them
+     * @param n - The length of the dot product
+     * @return - A new node with the value of the weighted sum
+     */
+    static BasicNode *weightedSum(const Scalar *weights, Scalar *weightGradients, const Scalar *bias,
+                             Scalar *biasGradient, const std::vector<BasicNode *> &inputs, const size_t n) {
+        Scalar sum = *bias;
+        for (size_t i = 0; i < n; ++i) {
+            sum += weights[i] * inputs[i]->data;
+        }
+        auto out = new BasicNode(sum, NodeOp::DENSE_ROW, inputs.data(), n);
+        out->setRow(DenseRow{weights, weightGradients, bias, biasGradient});
         return out;
     }
 
     /**
-     * @brief Topologically sorts all the nodes in the expression graph where the calling node belongs to ,and
-     * then it runs back-propagation from the last node in the topologically sorted list to make sure the chain
-     * rule is followed rigorously.
+     * @brief Applies the chain rule for this node only: the gradient of the node is pushed into its parents according
+     * to the local derivative of the operation that produced it.
+     */
+    void propagate() {
+        ParentOperands operands{parents()};
+        propagateOp(op, payload, data, grad, numberOfParents, operands);
+    }
+
+    /**
+     * The parents of a node, as seen by forwardOp() and propagateOp().
+     */
+    struct ParentOperands {
+        BasicNode *const *p;
+
+        Scalar value(const size_t i) const {
+            return p[i]->data;
+        }
+
+        Scalar &grad(const size_t i) const {
+            return p[i]->grad;
+        }
+    };
+
+    /**
+     * @brief Computes the value of an operation from its operands. It is the forward rule that a CompiledGraph
+     * replays; the operators that build a graph compute the same values, which the tests check for every operation.
+     * The softmax operations refresh the maximum and the sum of the exponentials in @p payload for the backward pass.
      *
+     * @param op - The operation
+     * @param payload - The constants of the operation
+     * @param count - The number of operands
+     * @param operands - Gives the value of operand i through value(i)
+     * @return - The value of the operation
      */
-    void backward() {
-        // topological order all the children in the graph
-        std::vector<Node *> topo;
-        std::unordered_set<Node *> visited;
-
-        std::function<void(Node *)> build_topo = [&](Node *v) {
-            if (!v || visited.count(v)) return;
-            visited.insert(v);
-            for (Node *child: v->previousNodes) {
-                build_topo(child);
+    template<typename Operands>
+    static Scalar forwardOp(const NodeOp op, Payload &payload, const size_t count, const Operands &operands) {
+        const Scalar c = payload.constant;
+        switch (op) {
+            case NodeOp::LEAF:
+            case NodeOp::VIEW:
+                return Scalar(0);
+            case NodeOp::ADD:
+                return operands.value(0) + operands.value(1);
+            case NodeOp::ADD_CONSTANT:
+                return operands.value(0) + c;
+            case NodeOp::MUL:
+                return operands.value(0) * operands.value(1);
+            case NodeOp::MUL_CONSTANT:
+                return operands.value(0) * c;
+            case NodeOp::DIV:
+                return operands.value(0) / operands.value(1);
+            case NodeOp::DIV_BY_CONSTANT:
+                return operands.value(0) / c;
+            case NodeOp::CONSTANT_DIV:
+                return c / operands.value(0);
+            case NodeOp::POW:
+                return std::pow(operands.value(0), c);
+            case NodeOp::LOG:
+                return std::log(std::max(operands.value(0), c));
+            case NodeOp::WEIGHTED_SUM: {
+                const size_t length = payload.length;
+                Scalar out = operands.value(2 * length);
+                for (size_t i = 0; i < length; ++i) {
+                    out += operands.value(i) * operands.value(length + i);
+                }
+                return out;
+            }
+            case NodeOp::DENSE_ROW: {
+                const Scalar *w = payload.row->weights;
+                Scalar out = *payload.row->bias;
+                for (size_t i = 0; i < count; ++i) {
+                    out += w[i] * operands.value(i);
+                }
+                return out;
+            }
+            case NodeOp::RELU:
+                return (operands.value(0) < Scalar(0)) ? Scalar(0) : operands.value(0);
+            case NodeOp::SIGMOID:
+                return Scalar(1) / (Scalar(1) + std::exp(-operands.value(0)));
+            case NodeOp::SOFTMAX:
+            case NodeOp::SOFTMAX_CROSS_ENTROPY: {
+                Scalar maxLogit = operands.value(0);
+                for (size_t j = 1; j < count; ++j) maxLogit = std::max(maxLogit, operands.value(j));
+                Scalar sumExp = Scalar(0);
+                for (size_t j = 0; j < count; ++j) sumExp += std::exp(operands.value(j) - maxLogit);
+                payload.softmax.maxLogit = maxLogit;
+                payload.softmax.sumExp = sumExp;
+                const Scalar selected = operands.value(payload.softmax.index);
+                return op == NodeOp::SOFTMAX
+                           ? std::exp(selected - maxLogit) / sumExp
+                           : maxLogit + std::log(sumExp) - selected;
+            }
+            case NodeOp::SIGMOID_CROSS_ENTROPY: {
+                const Scalar z = operands.value(0);
+                return std::max(z, Scalar(0)) - z * c + std::log1p(std::exp(-std::abs(z)));
+            }
+        }
+        return Scalar(0);
+    }
+
+    /**
+     * @brief Pushes the gradient of an operation into its operands according to its local derivative. It is the
+     * backward rule of both propagate() and the replay of a CompiledGraph.
+     *
+     * @param op - The operation
+     * @param payload - The constants of the operation
+     * @param out - The value of the operation
+     * @param g - The gradient of the operation
+     * @param count - The number of operands
+     * @param operands - Gives the value of operand i through value(i) and its gradient through grad(i)
+     */
+    template<typename Operands>
+    static void propagateOp(const NodeOp op, const Payload &payload, const Scalar out, const Scalar g,
+                            const size_t count, const Operands &operands) {
+        switch (op) {
+            case NodeOp::LEAF:
+            case NodeOp::VIEW:
+                break;
+            case NodeOp::ADD:
+                operands.grad(0) += g;
+                operands.grad(1) += g;
+                break;
+            case NodeOp::ADD_CONSTANT:
+                operands.grad(0) += g;
+                break;
+            case NodeOp::MUL:
+                operands.grad(0) += operands.value(1) * g;
+                operands.grad(1) += operands.value(0) * g;
+                break;
+            case NodeOp::MUL_CONSTANT:
+                operands.grad(0) += payload.constant * g;
+                break;
+            case NodeOp::DIV: {
+                operands.grad(0) += (Scalar(1) / operands.value(1)) * g;
+                const Scalar b2 = operands.value(1) * operands.value(1);
+                operands.grad(1) += (-operands.value(0) / b2) * g;
+                break;
+            }
+            case NodeOp::DIV_BY_CONSTANT:
+                // dz/da = 1 / b, b is a plain double constant, no grad
+                operands.grad(0) += (Scalar(1) / payload.constant) * g;
+                break;
+            case NodeOp::CONSTANT_DIV: {
+                // dz/db = -a / b^2, a is a plain constant, no grad
+                const Scalar b2 = operands.value(0) * operands.value(0);
+                operands.grad(0) += (-payload.constant / b2) * g;
+                break;
+            }
+            case NodeOp::POW: {
+                const Scalar exponent = payload.constant;
+                operands.grad(0) += (exponent * std::pow(operands.value(0), exponent - 1)) * g;
+                break;
             }
-            topo.push_back(v);
-        };
+            case NodeOp::LOG:
+                operands.grad(0) += (Scalar(1) / std::max(operands.value(0), payload.constant)) * g;
+                break;
+            case NodeOp::WEIGHTED_SUM: {
+                // The weights come first, then the inputs and the bias
+                const size_t n = payload.length;
+                for (size_t i = 0; i < n; ++i) {
+                    operands.grad(i) += operands.value(n + i) * g;
+                    operands.grad(n + i) += operands.value(i) * g;
+                }
+                operands.grad(2 * n) += g;
+                break;
+            }
+            case NodeOp::DENSE_ROW: {
+                const Scalar *w = payload.row->weights;
+                Scalar *gw = payload.row->weightGradients;
+                for (size_t i = 0; i < count; ++i) {
+                    gw[i] += operands.value(i) * g;
+                    operands.grad(i) += w[i] * g;
+                }
+                *payload.row->biasGradient += g;
+                break;
+            }
+            case NodeOp::RELU:
+                operands.grad(0) += ((out > 0) ? g : Scalar(0));
+                break;
+            case NodeOp::SIGMOID:
+                operands.grad(0) += out * (Scalar(1) - out) * g;
+                break;
+            case NodeOp::SOFTMAX: {
+                const Scalar prob_i = out;
+                for (size_t j = 0; j < count; ++j) {
+                    if (j == payload.softmax.index) {
+                        operands.grad(j) += prob_i * (Scalar(1) - prob_i) * g;
+                    } else {
+                        const Scalar prob_j = std::exp(operands.value(j) - payload.softmax.maxLogit) /
+                                              payload.softmax.sumExp;
+                        operands.grad(j) += -prob_i * prob_j * g;
+                    }
+                }
+                break;
+            }
+            case NodeOp::SOFTMAX_CROSS_ENTROPY: {
+                // d(logsumexp(l) - l_t)/dl_j = p_j - [j == t]
+                for (size_t j = 0; j < count; ++j) {
+                    const Scalar prob_j = std::exp(operands.value(j) - payload.softmax.maxLogit) /
+                                          payload.softmax.sumExp;
+                    const Scalar target = (j == payload.softmax.index) ? Scalar(1) : Scalar(0);
+                    operands.grad(j) += (prob_j - target) * g;
+                }
+                break;
+            }
+            case NodeOp::SIGMOID_CROSS_ENTROPY: {
+                // d/dz of the binary cross-entropy of sigmoid(z) is sigmoid(z) - y
+                const Scalar prediction = Scalar(1) / (Scalar(1) + std::exp(-operands.value(0)));
+                operands.grad(0) += (prediction - payload.constant) * g;
+                break;
+            }
+        }
+    }
 
-        build_topo(this);
+    /**
+     * @brief Runs back-propagation from the calling node. When the node was recorded on the tape of the active arena
+     * (see GraphScope), the tape is replayed in reverse; otherwise the expression graph is sorted topologically first.
+     * Both orders visit every node the calling node depends on after all the nodes that depend on it, and nothing
+     * else, so they produce the same gradients.
+     *
+     * @param seed - The gradient the calling node starts with. It is 1 for the usual dL/dL, and loss scaling passes its
+     * scale instead, which scales every gradient of the graph by the same factor.
+     */
+    void backward(const double seed = 1.0) {
+        GraphArena *arena = GraphArena::active();
+        if (arena && arena->recording() && backwardFromTape(arena->tape(), seed)) {
+            return;
+        }
+
+        // topological order all the children in the graph, with an explicit stack so that deep graphs can not
+        // overflow the call stack
+        std::vector<BasicNode *> topo;
+        std::unordered_set<BasicNode *> visited;
+        std::vector<std::pair<BasicNode *, size_t> > stack;
+
+        visited.insert(this);
+        stack.emplace_back(this, 0);
+        while (!stack.empty()) {
+            BasicNode *v = stack.back().first;
+            const size_t next = stack.back().second;
+            if (next < v->parentCount()) {
+                ++stack.back().second;
+                BasicNode *p = v->parent(next);
+                if (p && visited.insert(p).second) {
+                    stack.emplace_back(p, 0);
+                }
+            } else {
+                topo.push_back(v);
+                stack.pop_back();
+            }
+        }
 
         // go one variable at a time and apply the chain rule to get its gradient
-        this->grad = 1.0;
+        this->grad = static_cast<Scalar>(seed);
         for (auto it = topo.rbegin(); it != topo.rend(); ++it) {
-            (*it)->backwardProp();
+            (*it)->propagate();
         }
     }
+
+    /**
+     * @brief Runs back-propagation by walking @p tape in reverse, starting from the calling node. Only the nodes that
+     * the calling node depends on are propagated: the others may hold the gradients of an earlier backward pass, or
+     * rules such as division by zero that turn a zero gradient into NaN, and must not touch the shared parents.
+     *
+     * @param tape - The nodes of the graph in creation order
+     * @param seed - The gradient the calling node starts with
+     * @return - False if the calling node is not on the tape, in which case nothing was done
+     */
+    bool backwardFromTape(const std::vector<void *> &tape, const double seed = 1.0) {
+        // The root is usually the last node that was created, so the search stops right away
+        size_t end = tape.size();
+        while (end > 0 && tape[end - 1] != this) {
+            --end;
+        }
+        if (end == 0) {
+            return false;
+        }
+
+        // The tape is in creation order, so every node that depends on a node comes after it and has already marked it
+        // when the walk gets there. Leaves are never marked, as they may be shared with the graphs of other threads.
+        this->grad = static_cast<Scalar>(seed);
+        this->pending = true;
+        for (size_t i = end; i > 0; --i) {
+            auto *node = static_cast<BasicNode *>(tape[i - 1]);
+            if (!node->pending) continue;
+            node->pending = false;
+            node->propagate();
+            for (size_t j = 0; j < node->parentCount(); ++j) {
+                BasicNode *p = node->parent(j);
+                if (p && p->parentCount() > 0) p->pending = true;
+            }
+        }
+        return true;
+    }
 };
 
+// The double precision node, which the rest of the library and its tests default to
+using Node = BasicNode<double>;
+
 /*
  * The following is a list of operator overloading functions that contribute in the computation of the
  * arithmetic expressions between (Node) objects. They play a crucial role in building the expression tree
@@ -117,141 +633,72 @@ public:
  * regularly do.
  */
 
-inline Node *operator+(Node &a, Node &b) {
-    auto out = new Node(a.data + b.data, {&a, &b}, "+");
-
-    Node *pa = &a;
-    Node *pb = &b;
-
-    out->backwardProp = [pa, pb, out]() {
-        pa->grad += out->grad;
-        pb->grad += out->grad;
-    };
-
-    return out;
+template<typename Scalar>
+BasicNode<Scalar> *operator+(BasicNode<Scalar> &a, BasicNode<Scalar> &b) {
+    return new BasicNode<Scalar>(a.data + b.data, NodeOp::ADD, {&a, &b});
 }
 
 
-inline Node *operator+(Node &a, const double b) {
-    auto pb = new Node(b);
-    auto out = new Node(a.data + pb->data, {&a, pb}, "+");
-
-    Node *pa = &a;
-    out->backwardProp = [pa, pb, out]() {
-        pa->grad += out->grad;
-        pb->grad += out->grad;
-    };
-
+template<typename Scalar>
+BasicNode<Scalar> *operator+(BasicNode<Scalar> &a, const double b) {
+    auto out = new BasicNode<Scalar>(a.data + b, NodeOp::ADD_CONSTANT, {&a});
+    out->payload.constant = static_cast<Scalar>(b);
     return out;
 }
 
-inline Node *operator+(const double a, Node &b) {
-    auto pa = new Node(a);
-    auto out = new Node(pa->data + b.data, {pa, &b}, "+");
-
-    Node *pb = &b;
-    out->backwardProp = [pa, pb, out]() {
-        pa->grad += out->grad;
-        pb->grad += out->grad;
-    };
-
-    return out;
+template<typename Scalar>
+BasicNode<Scalar> *operator+(const double a, BasicNode<Scalar> &b) {
+    return b + a;
 }
 
 
-inline Node *operator*(Node &a, Node &b) {
-    auto out = new Node(a.data * b.data, {&a, &b}, "*");
-
-    Node *pa = &a;
-    Node *pb = &b;
-    out->backwardProp = [pa, pb, out]() {
-        pa->grad += pb->data * out->grad;
-        pb->grad += pa->data * out->grad;
-    };
-
-    return out;
+template<typename Scalar>
+BasicNode<Scalar> *operator*(BasicNode<Scalar> &a, BasicNode<Scalar> &b) {
+    return new BasicNode<Scalar>(a.data * b.data, NodeOp::MUL, {&a, &b});
 }
 
-inline Node *operator*(Node &a, const double b) {
-    auto pb = new Node(b);
-    auto out = new Node(a.data * pb->data, {&a, pb}, "*");
-
-    Node *pa = &a;
-    out->backwardProp = [pa, pb, out]() {
-        pa->grad += pb->data * out->grad;
-        pb->grad += pa->data * out->grad;
-    };
-
+template<typename Scalar>
+BasicNode<Scalar> *operator*(BasicNode<Scalar> &a, const double b) {
+    auto out = new BasicNode<Scalar>(a.data * b, NodeOp::MUL_CONSTANT, {&a});
+    out->payload.constant = static_cast<Scalar>(b);
     return out;
 }
 
-inline Node *operator*(const double a, Node &b) {
-    auto pa = new Node(a);
-    auto out = new Node(pa->data * b.data, {pa, &b}, "*");
-
-    Node *pb = &b;
-    out->backwardProp = [pa, pb, out]() {
-        pa->grad += pb->data * out->grad;
-        pb->grad += pa->data * out->grad;
-    };
-
-    return out;
+template<typename Scalar>
+BasicNode<Scalar> *operator*(const double a, BasicNode<Scalar> &b) {
+    return b * a;
 }
 
 
-inline Node *operator-(Node &a) {
+template<typename Scalar>
+BasicNode<Scalar> *operator-(BasicNode<Scalar> &a) {
     return a * -1.0;
 }
 
 
-inline Node *operator/(Node &a, Node &b) {
-    auto out = new Node(a.data / b.data, {&a, &b}, "/");
-
-    Node *pa = &a;
-    Node *pb = &b;
-
-    out->backwardProp = [pa, pb, out]() {
-        pa->grad += (1.0 / pb->data) * out->grad;
-
-        const double b2 = pb->data * pb->data;
-        pb->grad += (-pa->data / b2) * out->grad;
-    };
-
-    return out;
+template<typename Scalar>
+BasicNode<Scalar> *operator/(BasicNode<Scalar> &a, BasicNode<Scalar> &b) {
+    return new BasicNode<Scalar>(a.data / b.data, NodeOp::DIV, {&a, &b});
 }
 
 
-inline Node *operator/(Node &a, double b) {
-    auto out = new Node(a.data / b, {&a}, "/");
-
-    Node *pa = &a;
-
-    out->backwardProp = [pa, b, out]() {
-        // dz/da = 1 / b
-        pa->grad += (1.0 / b) * out->grad;
-        // b is a plain double constant, no grad
-    };
-
+template<typename Scalar>
+BasicNode<Scalar> *operator/(BasicNode<Scalar> &a, const double b) {
+    auto out = new BasicNode<Scalar>(a.data / b, NodeOp::DIV_BY_CONSTANT, {&a});
+    out->payload.constant = static_cast<Scalar>(b);
     return out;
 }
 
-inline Node *operator/(double a, Node &b) {
-    auto out = new Node(a / b.data, {&b}, "/");
-
-    Node *pb = &b;
-
-    out->backwardProp = [pb, a, out]() {
-        // dz/db = -a / b^2
-        const double b2 = pb->data * pb->data;
-        pb->grad += (-a / b2) * out->grad;
-        // a is a plain constant, no grad
-    };
-
+template<typename Scalar>
+BasicNode<Scalar> *operator/(const double a, BasicNode<Scalar> &b) {
+    auto out = new BasicNode<Scalar>(a / b.data, NodeOp::CONSTANT_DIV, {&b});
+    out->payload.constant = static_cast<Scalar>(a);
     return out;
 }
 
 
-inline std::ostream &operator<<(std::ostream &os, const Node &n) {
+template<typename Scalar>
+std::ostream &operator<<(std::ostream &os, const BasicNode<Scalar> &n) {
     os << "Node(data=" << n.data << ", grad=" << n.grad << ")";
     return os;
 }
@@ -0,0 +1,465 @@
+#ifndef TENSOR_H
+#define TENSOR_H
+#include <vector>
+#include <functional>
+#include <string>
+#include <cmath>
+#include <unordered_set>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <autoGradEngine/graphArena.h>
+#include <autoGradEngine/node.h>
+#include <autoGradEngine/kernels/gemm.h>
+
+/**
+ * The Tensor is the batched counterpart of the Node. Instead of a single scalar it holds a contiguous row-major matrix of
+ * values along with a gradient buffer of the same shape, so that a whole layer (or a whole batch going through a layer)
+ * is a single node in the expression graph. Every operation defined on tensors comes with a hand-written backward pass
+ * made of plain loops over contiguous memory. The matrix products go through the cache-blocked gemm() and the
+ * activations through the runtime-dispatched kernels of kernels.h, so they use the widest vector instructions the
+ * processor supports.
+ *
+ * Vectors are represented as matrices with a single row, and a batch of samples is a matrix with one sample per row.
+ *
+ * Tensors that are created while a GraphScope is open take both the node and its buffers from the arena of the scope.
+ *
+ * Like the Node, the tensor is a template over its scalar type, and Tensor is the double precision one.
+ */
+template<typename Scalar>
+class BasicTensor : public ArenaAllocated<BasicTensor<Scalar> > {
+    std::vector<Scalar> storage; // owns data and grad when the tensor is neither a view nor in an arena
+
+public:
+    size_t rows;
+    size_t cols;
+    Scalar *data;
+    Scalar *grad;
+
+    // internal variables used for autograd graph construction
+    std::function<void()> backwardProp;
+    std::vector<BasicTensor *> previousTensors; // parents in the computation graph
+    std::string operation;
+
+    /**
+     * @brief Constructs a zero-initialized tensor of shape @p rows x @p cols.
+     *
+     * @param rows - The number of rows (the batch dimension for activations)
+     * @param cols - The number of columns (the feature dimension for activations)
+     * @param children - The tensors that were involved in the computation of the current one
+     * @param op - The operation which the children underwent to produce this tensor
+     */
+    BasicTensor(const size_t rows, const size_t cols, const std::vector<BasicTensor *> &children = {},
+           const std::string &op = "")
+        : rows(rows), cols(cols), data(nullptr), grad(nullptr), backwardProp([] {
+        }), previousTensors(children), operation(op) {
+        const size_t n = rows * cols;
+        GraphArena *arena = GraphArena::active();
+        if (arena) {
+            data = static_cast<Scalar *>(arena->allocate(2 * n * sizeof(Scalar), 64));
+            grad = data + n;
+            std::fill(data, data + 2 * n, Scalar(0));
+        } else {
+            storage.assign(2 * n, Scalar(0));
+            data = storage.data();
+            grad = data + n;
+        }
+    }
+
+    /**
+     * @brief Constructs a tensor of shape @p rows x @p cols from row-major @p values.
+     *
+     * @throws std::invalid_argument - If @p values does not hold exactly @p rows x @p cols values
+     */
+    BasicTensor(const size_t rows, const size_t cols, const std::vector<Scalar> &values) : BasicTensor(rows, cols) {
+        if (values.size() != size()) {
+            throw std::invalid_argument("Tensor of shape " + shapeOf(rows, cols) + " given " +
+                                        std::to_string(values.size()) + " values");
+        }
+        std::copy(values.begin(), values.end(), data);
+    }
+
+    /**
+     * @brief Creates a tensor that does not own its memory, but reads its values from @p data and accumulates its
+     * gradient into @p grad. It is how parameters stored elsewhere enter the graph without being copied.
+     */
+    static BasicTensor *view(const size_t rows, const size_t cols, Scalar *data, Scalar *grad) {
+        auto out = new BasicTensor(0, 0);
+        out->rows = rows;
+        out->cols = cols;
+        out->data = data;
+        out->grad = grad;
+        out->operation = "view";
+        return out;
+    }
+
+    /**
+     * @brief Gathers the values of scalar nodes into a tensor. The backward pass scatters the gradient of the tensor
+     * back into the nodes, which lets the tensor engine train parameters that are held by Node objects.
+     *
+     * @param nodes - The nodes, in row-major order
+     * @param rows - The number of rows of the resulting tensor
+     * @param cols - The number of columns of the resulting tensor
+     */
+    static BasicTensor *fromNodes(const std::vector<BasicNode<Scalar> *> &nodes, const size_t rows, const size_t cols) {
+        auto out = new BasicTensor(rows, cols, {}, "fromNodes");
+        for (size_t i = 0; i < out->size(); ++i) {
+            out->data[i] = nodes.at(i)->data;
+        }
+
+        out->backwardProp = [nodes, out]() {
+            for (size_t i = 0; i < out->size(); ++i) {
+                nodes.at(i)->grad += out->grad[i];
+            }
+        };
+
+        return out;
+    }
+
+    size_t size() const {
+        return rows * cols;
+    }
+
+    /**
+     * @return - The shape @p rows x @p cols as it appears in error messages, for example "2x3"
+     */
+    static std::string shapeOf(const size_t rows, const size_t cols) {
+        return std::to_string(rows) + "x" + std::to_string(cols);
+    }
+
+    Scalar &at(const size_t row, const size_t col) {
+        return data[row * cols + col];
+    }
+
+    Scalar at(const size_t row, const size_t col) const {
+        return data[row * cols + col];
+    }
+
+    /**
+     * @return The single value of a 1x1 tensor, typically the loss
+     */
+    Scalar item() const {
+        return data[0];
+    }
+
+    void zeroGrad() {
+        std::fill(grad, grad + size(), Scalar(0));
+    }
+
+    /**
+     * @brief Applies the natural logarithm element-wise, clamping the input to @p epsilon to avoid log(0).
+     */
+    static BasicTensor *logTensor(BasicTensor *x, const double epsilon = 1e-7) {
+        auto out = new BasicTensor(x->rows, x->cols, {x}, "log");
+        const Scalar minimum = static_cast<Scalar>(epsilon);
+        for (size_t i = 0; i < x->size(); ++i) {
+            out->data[i] = std::log(std::max(x->data[i], minimum));
+        }
+
+        out->backwardProp = [x, out, minimum]() {
+            for (size_t i = 0; i < x->size(); ++i) {
+                x->grad[i] += out->grad[i] / std::max(x->data[i], minimum);
+            }
+        };
+
+        return out;
+    }
+
+    /**
+     * @brief Topologically sorts the graph that the calling tensor belongs to and runs back-propagation through it,
+     * exactly like Node::backward(). The gradient of the calling tensor is seeded with ones, which for a 1x1 loss
+     * tensor is the usual dL/dL = 1, or with @p seed when the loss is scaled.
+     */
+    void backward(const double seed = 1.0) {
+        std::vector<BasicTensor *> topo;
+        std::unordered_set<BasicTensor *> visited;
+
+        std::function<void(BasicTensor *)> build_topo = [&](BasicTensor *v) {
+            if (!v || visited.count(v)) return;
+            visited.insert(v);
+            for (BasicTensor *child: v->previousTensors) {
+                build_topo(child);
+            }
+            topo.push_back(v);
+        };
+
+        build_topo(this);
+
+        std::fill(grad, grad + size(), static_cast<Scalar>(seed));
+        for (auto it = topo.rbegin(); it != topo.rend(); ++it) {
+            (*it)->backwardProp();
+        }
+    }
+};
+
+using Tensor = BasicTensor<double>;
+
+/*
+ * Tensor operations. Each of them checks the shapes of its operands, allocates its output, fills it in with a single
+ * pass over contiguous memory and registers the matching backward pass.
+ */
+
+/**
+ * @brief Throws if the operands of @p operation do not have compatible shapes, before anything is allocated.
+ *
+ * @throws std::invalid_argument - If @p compatible is false, with the shapes of @p a and @p b in the message
+ */
+template<typename Scalar>
+void checkShapes(const bool compatible, const char *operation, const BasicTensor<Scalar> &a,
+                 const BasicTensor<Scalar> &b) {
+    if (!compatible) {
+        throw std::invalid_argument(std::string(operation) + ": incompatible shapes " +
+                                    BasicTensor<Scalar>::shapeOf(a.rows, a.cols) + " and " +
+                                    BasicTensor<Scalar>::shapeOf(b.rows, b.cols));
+    }
+}
+
+/**
+ * @brief Matrix product of @p a (m x k) and @p b (k x n).
+ */
+template<typename Scalar>
+BasicTensor<Scalar> *matmul(BasicTensor<Scalar> *a, BasicTensor<Scalar> *b) {
+    checkShapes(a->cols == b->rows, "matmul", *a, *b);
+    const size_t m = a->rows, k = a->cols, n = b->cols;
+    auto out = new BasicTensor<Scalar>(m, n, {a, b}, "matmul");
+
+    using MatrixView = kernels::BasicMatrixView<Scalar>;
+    kernels::gemm(m, n, k, 1.0, MatrixView::rowMajor(a->data, k), MatrixView::rowMajor(b->data, n), out->data, n);
+
+    out->backwardProp = [a, b, out, m, k, n]() {
+        // dA = dOut * B^T
+        kernels::gemm(m, k, n, 1.0, MatrixView::rowMajor(out->grad, n), MatrixView::rowMajor(b->data, n).transposed(),
+                      a->grad, k);
+        // dB = A^T * dOut
+        kernels::gemm(k, n, m, 1.0, MatrixView::rowMajor(a->data, k).transposed(), MatrixView::rowMajor(out->grad, n),
+                      b->grad, n);
+    };
+
+    return out;
+}
+
+/**
+ * @brief The affine map of a dense layer: out = x * W^T + b, where every row of @p weights holds the weights of one
+ * output. All three products, the forward pass, the transposed product of the backward pass (dx = dOut * W) and the
+ * weight gradient (dW += dOut^T * x), are a single gemm() call each.
+ *
+ * @param x - The (batch x inputs) input
+ * @param weights - The (outputs x inputs) weight matrix
+ * @param bias - The (1 x outputs) bias vector
+ */
+template<typename Scalar>
+BasicTensor<Scalar> *linear(BasicTensor<Scalar> *x, BasicTensor<Scalar> *weights, BasicTensor<Scalar> *bias) {
+    checkShapes(x->cols == weights->cols, "linear", *x, *weights);
+    checkShapes(bias->size() == weights->rows, "linear", *weights, *bias);
+    const size_t m = x->rows, k = x->cols, n = weights->rows;
+    auto out = new BasicTensor<Scalar>(m, n, {x, weights, bias}, "linear");
+
+    using MatrixView = kernels::BasicMatrixView<Scalar>;
+    for (size_t i = 0; i < m; ++i) {
+        std::copy(bias->data, bias->data + n, out->data + i * n);
+    }
+    kernels::gemm(m, n, k, 1.0, MatrixView::rowMajor(x->data, k), MatrixView::rowMajor(weights->data, k).transposed(),
+                  out->data, n);
+
+    out->backwardProp = [x, weights, bias, out, m, k, n]() {
+        const MatrixView gradient = MatrixView::rowMajor(out->grad, n);
+        kernels::gemm(m, k, n, 1.0, gradient, MatrixView::rowMajor(weights->data, k), x->grad, k);
+        kernels::gemm(n, k, m, 1.0, gradient.transposed(), MatrixView::rowMajor(x->data, k), weights->grad, k);
+
+        const kernels::BasicKernelTable<Scalar> &kernel = kernels::active<Scalar>();
+        for (size_t i = 0; i < m; ++i) {
+            kernel.add(out->grad + i * n, bias->grad, n);
+        }
+    };
+
+    return out;
+}
+
+/**
+ * @brief Adds the bias row vector @p bias (1 x n) to every row of @p x (m x n).
+ */
+template<typename Scalar>
+BasicTensor<Scalar> *addBias(BasicTensor<Scalar> *x, BasicTensor<Scalar> *bias) {
+    checkShapes(bias->size() == x->cols, "addBias", *x, *bias);
+    const size_t m = x->rows, n = x->cols;
+    auto out = new BasicTensor<Scalar>(m, n, {x, bias}, "addBias");
+
+    const kernels::BasicKernelTable<Scalar> &kernel = kernels::active<Scalar>();
+    std::copy(x->data, x->data + x->size(), out->data);
+    for (size_t i = 0; i < m; ++i) {
+        kernel.add(bias->data, out->data + i * n, n);
+    }
+
+    out->backwardProp = [x, bias, out, m, n]() {
+        const kernels::BasicKernelTable<Scalar> &kernel = kernels::active<Scalar>();
+        kernel.add(out->grad, x->grad, m * n);
+        for (size_t i = 0; i < m; ++i) {
+            kernel.add(out->grad + i * n, bias->grad, n);
+        }
+    };
+
+    return out;
+}
+
+template<typename Scalar>
+BasicTensor<Scalar> *operator+(BasicTensor<Scalar> &a, BasicTensor<Scalar> &b) {
+    checkShapes(a.rows == b.rows && a.cols == b.cols, "+", a, b);
+    auto out = new BasicTensor<Scalar>(a.rows, a.cols, {&a, &b}, "+");
+    for (size_t i = 0; i < a.size(); ++i) {
+        out->data[i] = a.data[i] + b.data[i];
+    }
+
+    BasicTensor<Scalar> *pa = &a;
+    BasicTensor<Scalar> *pb = &b;
+    out->backwardProp = [pa, pb, out]() {
+        for (size_t i = 0; i < out->size(); ++i) {
+            pa->grad[i] += out->grad[i];
+            pb->grad[i] += out->grad[i];
+        }
+    };
+
+    return out;
+}
+
+template<typename Scalar>
+BasicTensor<Scalar> *operator+(BasicTensor<Scalar> &a, const double b) {
+    auto out = new BasicTensor<Scalar>(a.rows, a.cols, {&a}, "+");
+    for (size_t i = 0; i < a.size(); ++i) {
+        out->data[i] = a.data[i] + static_cast<Scalar>(b);
+    }
+
+    BasicTensor<Scalar> *pa = &a;
+    out->backwardProp = [pa, out]() {
+        for (size_t i = 0; i < out->size(); ++i) {
+            pa->grad[i] += out->grad[i];
+        }
+    };
+
+    return out;
+}
+
+/**
+ * @brief Element-wise (Hadamard) product of two tensors of the same shape.
+ */
+template<typename Scalar>
+BasicTensor<Scalar> *operator*(BasicTensor<Scalar> &a, BasicTensor<Scalar> &b) {
+    checkShapes(a.rows == b.rows && a.cols == b.cols, "*", a, b);
+    auto out = new BasicTensor<Scalar>(a.rows, a.cols, {&a, &b}, "*");
+    for (size_t i = 0; i < a.size(); ++i) {
+        out->data[i] = a.data[i] * b.data[i];
+    }
+
+    BasicTensor<Scalar> *pa = &a;
+    BasicTensor<Scalar> *pb = &b;
+    out->backwardProp = [pa, pb, out]() {
+        for (size_t i = 0; i < out->size(); ++i) {
+            pa->grad[i] += pb->data[i] * out->grad[i];
+            pb->grad[i] += pa->data[i] * out->grad[i];
+        }
+    };
+
+    return out;
+}
+
+template<typename Scalar>
+BasicTensor<Scalar> *operator*(BasicTensor<Scalar> &a, const double b) {
+    auto out = new BasicTensor<Scalar>(a.rows, a.cols, {&a}, "*");
+    const Scalar factor = static_cast<Scalar>(b);
+    for (size_t i = 0; i < a.size(); ++i) {
+        out->data[i] = a.data[i] * factor;
+    }
+
+    BasicTensor<Scalar> *pa = &a;
+    out->backwardProp = [pa, factor, out]() {
+        for (size_t i = 0; i < out->size(); ++i) {
+            pa->grad[i] += factor * out->grad[i];
+        }
+    };
+
+    return out;
+}
+
+template<typename Scalar>
+BasicTensor<Scalar> *operator-(BasicTensor<Scalar> &a) {
+    return a * -1.0;
+}
+
+/**
+ * @brief Reduces all the elements of @p x into a 1x1 tensor holding their sum.
+ */
+template<typename Scalar>
+BasicTensor<Scalar> *sum(BasicTensor<Scalar> *x) {
+    auto out = new BasicTensor<Scalar>(1, 1, {x}, "sum");
+    Scalar total = 0;
+    for (size_t i = 0; i < x->size(); ++i) {
+        total += x->data[i];
+    }
+    out->data[0] = total;
+
+    out->backwardProp = [x, out]() {
+        const Scalar g = out->grad[0];
+        for (size_t i = 0; i < x->size(); ++i) {
+            x->grad[i] += g;
+        }
+    };
+
+    return out;
+}
+
+/**
+ * @brief Reduces all the elements of @p x into a 1x1 tensor holding their average.
+ */
+template<typename Scalar>
+BasicTensor<Scalar> *mean(BasicTensor<Scalar> *x) {
+    auto out = new BasicTensor<Scalar>(1, 1, {x}, "mean");
+    const Scalar scale = x->size() > 0 ? Scalar(1) / static_cast<Scalar>(x->size()) : Scalar(0);
+    Scalar total = 0;
+    for (size_t i = 0; i < x->size(); ++i) {
+        total += x->data[i];
+    }
+    out->data[0] = total * scale;
+
+    out->backwardProp = [x, out, scale]() {
+        const Scalar g = out->grad[0] * scale;
+        for (size_t i = 0; i < x->size(); ++i) {
+            x->grad[i] += g;
+        }
+    };
+
+    return out;
+}
+
+/**
+ * @brief Picks one column per row: the result is an m x 1 tensor with out[i] = x[i][columns[i]]. It is used to select
+ * the probability of the target class of every sample in a batch.
+ */
+template<typename Scalar>
+BasicTensor<Scalar> *selectColumns(BasicTensor<Scalar> *x, const std::vector<size_t> &columns) {
+    auto out = new BasicTensor<Scalar>(x->rows, 1, {x}, "select");
+    for (size_t i = 0; i < x->rows; ++i) {
+        if (columns.at(i) >= x->cols) {
+            throw std::out_of_range("Selected column out of range");
+        }
+        out->data[i] = x->at(i, columns.at(i));
+    }
+
+    out->backwardProp = [x, columns, out]() {
+        for (size_t i = 0; i < x->rows; ++i) {
+            x->grad[i * x->cols + columns.at(i)] += out->grad[i];
+        }
+    };
+
+    return out;
+}
+
+template<typename Scalar>
+std::ostream &operator<<(std::ostream &os, const BasicTensor<Scalar> &t) {
+    os << "Tensor(" << t.rows << "x" << t.cols << ", data=[";
+    for (size_t i = 0; i < t.size(); ++i) {
+        os << t.data[i];
+        if (i + 1 < t.size()) os << ", ";
+    }
+    return os << "])";
+}
+
+#endif //TENSOR_H
@@ -8,7 +8,7 @@
 int main() {
 
     auto datasetLoader = MushroomDataset("mushrooms.csv");
-    auto data = datasetLoader.getData();
+    const DataTable &data = datasetLoader.getData();
 
     MultiClassClassifier model(
         datasetLoader.getNumFeatures(),
@@ -6,13 +6,16 @@
 #include <nnComponents/lossFunctions/binaryCrossEntropy.h>
 #include <nnComponents/trainers/trainer.h>
 #include <utils/serialization/modelSerializer.h>
+#include <utils/helperFunctions.h>
 #include <iostream>
+#include <memory>
 
 /**
  * This is one of the two template networks that the library provides. The user is provided with a plug-and-play
  * solution when it comes to classification tasks that involve only two categories.
  */
-class BinaryClassifier final : public Network {
+template<typename Scalar>
+class BasicBinaryClassifier final : public BasicNetwork<Scalar> {
 public:
     /**
      * @brief Constructs the Network with the input layer the size of @p numberOfInputs with the
@@ -21,8 +24,8 @@ public:
      * @param numberOfInputs
      * @param hiddenLayerSizes
      */
-    BinaryClassifier(const int numberOfInputs, const std::vector<int> &hiddenLayerSizes)
-        : Network(getNetworkSpecs(numberOfInputs, hiddenLayerSizes)) {
+    BasicBinaryClassifier(const int numberOfInputs, const std::vector<int> &hiddenLayerSizes)
+        : BasicNetwork<Scalar>(getNetworkSpecs(numberOfInputs, hiddenLayerSizes)) {
     }
 
     /**
@@ -48,9 +51,9 @@ public:
      */
     std::string representation() const override {
         std::string s = "BinaryClassifier of [";
-        for (size_t i = 0; i < layers.size(); ++i) {
-            s += layers.at(i).representation();
-            if (i + 1 < layers.size()) s += ", ";
+        for (size_t i = 0; i < this->layers.size(); ++i) {
+            s += this->layers.at(i).representation();
+            if (i + 1 < this->layers.size()) s += ", ";
         }
         return s + "]";
     }
@@ -63,16 +66,32 @@ public:
      * @param filepath - location of the .bin file that holds the metadata + parameters of a saved model
      * @return - A BinaryClassifier object that can be used for inferences
      */
-    static BinaryClassifier *loadFromFile(const std::string &filepath) {
+    static BasicBinaryClassifier *loadFromFile(const std::string &filepath) {
         try {
+            if (MappedModel::isBinaryModel(filepath)) {
+                // The parameters are copied straight from the mapped file, without parsing
+                const MappedModel mapped(filepath);
+                std::vector<int> hiddenLayerSizes = mapped.layerSizes();
+                hiddenLayerSizes.pop_back();
+                mapped.checkArchitecture(getNetworkSpecs(mapped.inputSize(), hiddenLayerSizes));
+                std::unique_ptr<BasicBinaryClassifier> model(
+                    new BasicBinaryClassifier(mapped.inputSize(), hiddenLayerSizes));
+                mapped.copyParameters(model->parameterBlocks());
+
+                std::cout << "✓ Model loaded successfully!" << std::endl;
+                std::cout << "  - Input vector size: " << mapped.inputSize() << std::endl;
+                std::cout << "  - Total parameters: " << model->parameters().size() << std::endl;
+                return model.release();
+            }
+
             // Load metadata first
             const ModelMetadata metadata = ModelSerializer::loadMetadata(filepath);
 
             // Create model with the correct architecture
-            auto *model = new BinaryClassifier(metadata.inputVectorSize, metadata.hiddenLayerSizes);
+            auto *model = new BasicBinaryClassifier(metadata.inputVectorSize, metadata.hiddenLayerSizes);
 
             // Load the parameters
-            std::vector<Node *> params = model->parameters();
+            std::vector<BasicNode<Scalar> *> params = model->parameters();
             if (!ModelSerializer::loadWithValidation(params, filepath)) {
                 delete model;
                 return nullptr;
@@ -89,6 +108,23 @@ public:
         }
     }
 
+    /**
+     * @brief Serves a model saved in the binary format straight from the mapped file, without copying its weights
+     * into a network. The model can only make inferences, through the engine of the returned object, whose
+     * threshold() is the predicted class.
+     *
+     * @param filepath - A model saved by a BinaryClassifier with ModelFormat::BINARY
+     * @throws std::runtime_error - If the file is not a binary model of a BinaryClassifier of this scalar type
+     */
+    static std::unique_ptr<BasicMappedInferenceModel<Scalar> > loadForInference(const std::string &filepath) {
+        std::unique_ptr<MappedModel> mapped(new MappedModel(filepath));
+        std::vector<int> hiddenLayerSizes = mapped->layerSizes();
+        hiddenLayerSizes.pop_back();
+        mapped->checkArchitecture(getNetworkSpecs(mapped->inputSize(), hiddenLayerSizes));
+        return std::unique_ptr<BasicMappedInferenceModel<Scalar> >(
+            new BasicMappedInferenceModel<Scalar>(std::move(mapped)));
+    }
+
     /**
      * @brief This function constructs the loss function that should be passed to the training driver, creates
      * a training driver object and then calls the train() method for the model to start learning.
@@ -99,14 +135,24 @@ public:
      * @param dataset - the dataset that we are going to be using to train the network
      */
     void train(const double learningRate, const int epochs, const int batchSize,
-               DatasetFormat &dataset) override {
-        // Create loss function lambda so that we pass it to the trainer
-        auto loss_fn = [](const std::vector<Node *> &predictions, const double target) -> Node *{
-            return BinaryCrossEntropyLoss::compute(predictions.at(0), target);
+               const DataTable &dataset) override {
+        // Create loss function lambda so that we pass it to the trainer. The loss receives the logit of the output
+        // layer and fuses the sigmoid with the binary cross-entropy
+        using NodeType = BasicNode<Scalar>;
+        using TensorType = BasicTensor<Scalar>;
+        auto loss_fn = [](const std::vector<NodeType *> &logits, const double target) -> NodeType *{
+            return BasicBinaryCrossEntropyLoss<Scalar>::fromLogits(logits.at(0), target);
         };
 
         // Create the trainer object and then call the train method to start training the network
-        Trainer trainer(this, loss_fn, learningRate, epochs, batchSize);
+        BasicTrainer<Scalar> trainer(this, loss_fn, learningRate, epochs, batchSize);
+        trainer.setLossOnLogits(true);
+        trainer.setTensorLossFunction([](TensorType *logits, const std::vector<double> &targets) -> TensorType *{
+            return BasicBinaryCrossEntropyLoss<Scalar>::fromLogits(logits, targets);
+        });
+        trainer.setWorkers(this->trainingWorkers);
+        trainer.setMixedPrecision(this->mixedPrecisionTraining);
+        if (this->seededTraining) trainer.setSeed(this->trainingSeed);
         trainer.train(dataset);
     }
 
@@ -116,20 +162,22 @@ public:
      * @param input - The input vector
      * @return - The number of the class that was predicted by the model
      */
-    int predict(std::vector<double> &input) override {
-        auto inputNodes = helper::createInputNodes(input);
-
-        const Node *n = (*this)(inputNodes).at(0);
-        auto prediction = n->data;
-
-        helper::deleteInputNodes(inputNodes);
+    int predict(const std::vector<double> &input) override {
+        BasicInferenceEngine<Scalar> &inference = this->inferenceEngine();
+        if (input.size() < inference.inputSize()) {
+            throw std::invalid_argument("Input vector is smaller than the input layer");
+        }
 
-        return (prediction >= 0.5) ? 1 : 0;
+        std::vector<Scalar> buffer;
+        return inference.threshold(helper::scalarData(input, buffer), 0.5);
     }
 };
 
-inline std::ostream &operator<<(std::ostream &os, const BinaryClassifier &m) {
+template<typename Scalar>
+std::ostream &operator<<(std::ostream &os, const BasicBinaryClassifier<Scalar> &m) {
     return os << m.representation();
 }
 
+using BinaryClassifier = BasicBinaryClassifier<double>;
+
 #endif //BINARYCLASSIFIER_H
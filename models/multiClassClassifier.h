@@ -7,13 +7,15 @@
 #include <nnComponents/trainers/trainer.h>
 #include <utils/serialization/modelSerializer.h>
 #include <iostream>
+#include <memory>
 #include "utils/helperFunctions.h"
 
 /**
  * This is one of the two template networks that the library provides. The user is provided with a plug-and-play
  * solution when it comes to classification tasks that involve several categories.
  */
-class MultiClassClassifier final : public Network {
+template<typename Scalar>
+class BasicMultiClassClassifier final : public BasicNetwork<Scalar> {
     int numClasses;
 
 public:
@@ -25,10 +27,10 @@ public:
      * @param hiddenLayerSizes
      * @param numberOfClasses
      */
-    MultiClassClassifier(const int numberOfInputs,
+    BasicMultiClassClassifier(const int numberOfInputs,
                          const std::vector<int> &hiddenLayerSizes,
                          const int numberOfClasses)
-        : Network(getNetworkSpecs(numberOfInputs, hiddenLayerSizes, numberOfClasses)),
+        : BasicNetwork<Scalar>(getNetworkSpecs(numberOfInputs, hiddenLayerSizes, numberOfClasses)),
           numClasses(numberOfClasses) {
     }
 
@@ -59,9 +61,9 @@ public:
      */
     std::string representation() const override {
         std::string s = "MultiClassClassifier of [";
-        for (size_t i = 0; i < layers.size(); ++i) {
-            s += layers.at(i).representation();
-            if (i + 1 < layers.size()) s += ", ";
+        for (size_t i = 0; i < this->layers.size(); ++i) {
+            s += this->layers.at(i).representation();
+            if (i + 1 < this->layers.size()) s += ", ";
         }
         return s + "]";
     }
@@ -74,8 +76,26 @@ public:
      * @param filepath - location of the .bin file that holds the metadata + parameters of a saved model
      * @return A MultiClassClassifier object that can be used for inferences
      */
-    static MultiClassClassifier *loadFromFile(const std::string &filepath) {
+    static BasicMultiClassClassifier *loadFromFile(const std::string &filepath) {
         try {
+            if (MappedModel::isBinaryModel(filepath)) {
+                // The parameters are copied straight from the mapped file, without parsing
+                const MappedModel mapped(filepath);
+                std::vector<int> hiddenLayerSizes = mapped.layerSizes();
+                const int numClasses = hiddenLayerSizes.back();
+                hiddenLayerSizes.pop_back();
+                mapped.checkArchitecture(getNetworkSpecs(mapped.inputSize(), hiddenLayerSizes, numClasses));
+                std::unique_ptr<BasicMultiClassClassifier> model(
+                    new BasicMultiClassClassifier(mapped.inputSize(), hiddenLayerSizes, numClasses));
+                mapped.copyParameters(model->parameterBlocks());
+
+                std::cout << "✓ Model loaded successfully!" << std::endl;
+                std::cout << "  - Input vector size: " << mapped.inputSize() << std::endl;
+                std::cout << "  - Output classes: " << numClasses << std::endl;
+                std::cout << "  - Total parameters: " << model->parameters().size() << std::endl;
+                return model.release();
+            }
+
             // Load metadata first
             ModelMetadata metadata = ModelSerializer::loadMetadata(filepath);
 
@@ -88,14 +108,14 @@ public:
             );
 
             // Create model with the correct architecture
-            auto *model = new MultiClassClassifier(
+            auto *model = new BasicMultiClassClassifier(
                 metadata.inputVectorSize,
                 actualHiddenLayers,
                 numClasses
             );
 
             // Load the parameters
-            std::vector<Node *> params = model->parameters();
+            std::vector<BasicNode<Scalar> *> params = model->parameters();
             if (!ModelSerializer::loadWithValidation(params, filepath)) {
                 delete model;
                 return nullptr;
@@ -113,6 +133,24 @@ public:
         }
     }
 
+    /**
+     * @brief Serves a model saved in the binary format straight from the mapped file, without copying its weights
+     * into a network. The model can only make inferences, through the engine of the returned object, whose argmax()
+     * is the predicted class.
+     *
+     * @param filepath - A model saved by a MultiClassClassifier with ModelFormat::BINARY
+     * @throws std::runtime_error - If the file is not a binary model of a MultiClassClassifier of this scalar type
+     */
+    static std::unique_ptr<BasicMappedInferenceModel<Scalar> > loadForInference(const std::string &filepath) {
+        std::unique_ptr<MappedModel> mapped(new MappedModel(filepath));
+        std::vector<int> hiddenLayerSizes = mapped->layerSizes();
+        const int numClasses = hiddenLayerSizes.back();
+        hiddenLayerSizes.pop_back();
+        mapped->checkArchitecture(getNetworkSpecs(mapped->inputSize(), hiddenLayerSizes, numClasses));
+        return std::unique_ptr<BasicMappedInferenceModel<Scalar> >(
+            new BasicMappedInferenceModel<Scalar>(std::move(mapped)));
+    }
+
     /**
      * @brief This function constructs the loss function that should be passed to the training driver, creates
      * a training driver object and then calls the train() method for the model to start learning.
@@ -123,20 +161,22 @@ public:
      * @param dataset - the dataset that we are going to be using to train the network
      */
     void train(const double learningRate, const int epochs, const int batchSize,
-               DatasetFormat &dataset) override {
-        // Create loss function lambda that handles softmax + cross-entropy
-        auto loss_fn = [this](const std::vector<Node *> &logits, const double target) -> Node *{
-            // Apply softmax to logits
-            const std::vector<Node *> probabilities = softmax(logits);
-
-            // Compute categorical cross-entropy loss
-            Node *loss = CategoricalCrossEntropyLoss::compute(probabilities, static_cast<int>(target));
-
-            return loss;
+               const DataTable &dataset) override {
+        // Create loss function lambda that handles softmax + cross-entropy as a single fused node
+        using NodeType = BasicNode<Scalar>;
+        using TensorType = BasicTensor<Scalar>;
+        auto loss_fn = [](const std::vector<NodeType *> &logits, const double target) -> NodeType *{
+            return BasicCategoricalCrossEntropyLoss<Scalar>::fromLogits(logits, static_cast<int>(target));
         };
 
         // Create and configure trainer
-        Trainer trainer(this, loss_fn, learningRate, epochs, batchSize);
+        BasicTrainer<Scalar> trainer(this, loss_fn, learningRate, epochs, batchSize);
+        trainer.setTensorLossFunction([](TensorType *logits, const std::vector<double> &targets) -> TensorType *{
+            return BasicCategoricalCrossEntropyLoss<Scalar>::fromLogits(logits, targets);
+        });
+        trainer.setWorkers(this->trainingWorkers);
+        trainer.setMixedPrecision(this->mixedPrecisionTraining);
+        if (this->seededTraining) trainer.setSeed(this->trainingSeed);
         trainer.train(dataset);
     }
 
@@ -146,23 +186,25 @@ public:
      * @param input - The input vector
      * @return - The number of the class that was predicted by the model
      */
-    int predict(std::vector<double> &input) override {
-        const auto inputNodes = helper::createInputNodes(input);
-
-        const std::vector<Node *> logits = (*this)(inputNodes);
-        std::vector<Node *> probabilities = softmax(logits);
-
-        // Find class with the highest probability
-        int predictedClass = 0;
-        double maxProbability = probabilities.at(0)->data;
-        for (size_t i = 1; i < probabilities.size(); ++i) {
-            if (probabilities.at(i)->data > maxProbability) {
-                maxProbability = probabilities.at(i)->data;
-                predictedClass = static_cast<int>(i);
-            }
+    int predict(const std::vector<double> &input) override {
+        BasicInferenceEngine<Scalar> &inference = this->inferenceEngine();
+        if (input.size() < inference.inputSize()) {
+            throw std::invalid_argument("Input vector is smaller than the input layer");
         }
 
-        return predictedClass;
+        // Find class with the highest probability, which is also the class with the highest logit
+        std::vector<Scalar> buffer;
+        return inference.argmax(helper::scalarData(input, buffer));
+    }
+
+    /**
+     * @brief Scores a matrix of samples and writes the softmax probabilities of every class, see
+     * Network::predictProbaBatch.
+     */
+    void predictProbaBatch(const Scalar *features, const size_t rows, Scalar *probabilities,
+                           ThreadPool *pool = nullptr) override {
+        BasicNetwork<Scalar>::predictProbaBatch(features, rows, probabilities, pool);
+        BasicInferenceEngine<Scalar>::softmaxRows(probabilities, rows, static_cast<size_t>(numClasses));
     }
 
     /**
@@ -172,23 +214,26 @@ public:
         std::vector<int> allLayerSizes;
 
         // Add hidden layers
-        for (size_t i = 1; i < networkSpecs.size() - 1; i++) {
-            allLayerSizes.push_back(networkSpecs.at(i).first);
+        for (size_t i = 1; i < this->networkSpecs.size() - 1; i++) {
+            allLayerSizes.push_back(this->networkSpecs.at(i).first);
         }
 
         // Add output layer (number of classes)
-        allLayerSizes.push_back(networkSpecs.back().first);
+        allLayerSizes.push_back(this->networkSpecs.back().first);
 
         return ModelMetadata{
             this->networkSpecs.at(0).first,
             allLayerSizes,
-            parameters().size()
+            this->parameters().size()
         };
     }
 };
 
-inline std::ostream &operator<<(std::ostream &os, const MultiClassClassifier &m) {
+template<typename Scalar>
+std::ostream &operator<<(std::ostream &os, const BasicMultiClassClassifier<Scalar> &m) {
     return os << m.representation();
 }
 
+using MultiClassClassifier = BasicMultiClassClassifier<double>;
+
 #endif //MULTICLASSCLASSIFIER_H
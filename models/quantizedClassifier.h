@@ -0,0 +1,135 @@
+#ifndef QUANTIZEDCLASSIFIER_H
+#define QUANTIZEDCLASSIFIER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+#include <nnComponents/network.h>
+#include <nnComponents/inference/quantizedInferenceEngine.h>
+#include <nnComponents/trainers/trainer.h>
+#include <utils/helperFunctions.h>
+
+/**
+ * How much a quantized model gives up compared with the full precision model it was built from.
+ */
+struct QuantizationReport {
+    double referenceAccuracy = 0.0;
+    double quantizedAccuracy = 0.0;
+    size_t referenceBytes = 0; // the parameters of the full precision model
+    size_t quantizedBytes = 0; // the int8 weights and int32 biases
+
+    /**
+     * @return The accuracy of the quantized model minus the accuracy of the full precision one
+     */
+    double accuracyDelta() const {
+        return quantizedAccuracy - referenceAccuracy;
+    }
+};
+
+/**
+ * An int8 version of a trained classifier, for serving. It is built from a full precision model, either in memory or
+ * saved with Network::saveModel, and evaluates both of them on a dataset so that the cost of the quantization is known
+ * up front. Binary classifiers use the threshold head on their single output, multi-class classifiers the argmax.
+ */
+class QuantizedClassifier {
+    QuantizedInferenceEngine engine;
+    QuantizationReport report;
+
+public:
+    /**
+     * @brief Quantizes a trained network.
+     *
+     * @param model - The full precision model
+     * @param calibration - The samples whose activations set the ranges of the quantized inputs of every layer
+     * @param evaluation - The samples on which the accuracy of both models is measured, may be empty
+     * @throws std::invalid_argument - If the samples of @p calibration or @p evaluation do not have as many features as
+     * the model has inputs
+     */
+    template<typename Scalar>
+    QuantizedClassifier(BasicNetwork<Scalar> &model, const DataTable &calibration, const DataTable &evaluation) {
+        if (!calibration.empty() && calibration.featureCount() != model.inputSize()) {
+            throw std::invalid_argument("The calibration samples do not have as many features as the model has inputs");
+        }
+        if (!evaluation.empty() && evaluation.featureCount() != model.inputSize()) {
+            throw std::invalid_argument("The evaluation samples do not have as many features as the model has inputs");
+        }
+        engine = QuantizedInferenceEngine::quantize(model.layerViews(), calibration.data(), calibration.size());
+
+        report.referenceBytes = model.parameters().size() * sizeof(Scalar);
+        report.quantizedBytes = engine.parameterBytes();
+        if (evaluation.empty()) return;
+
+        size_t referenceCorrect = 0, quantizedCorrect = 0;
+        std::vector<double> input;
+        for (size_t i = 0; i < evaluation.size(); ++i) {
+            input.assign(evaluation.features(i), evaluation.features(i) + evaluation.featureCount());
+            const int target = static_cast<int>(evaluation.label(i));
+            if (model.predict(input) == target) ++referenceCorrect;
+            if (predict(input) == target) ++quantizedCorrect;
+        }
+        report.referenceAccuracy = static_cast<double>(referenceCorrect) / static_cast<double>(evaluation.size());
+        report.quantizedAccuracy = static_cast<double>(quantizedCorrect) / static_cast<double>(evaluation.size());
+    }
+
+    /**
+     * @brief Loads a model saved by Network::saveModel and quantizes it.
+     *
+     * @tparam Model - The class the model was saved from, e.g. MultiClassClassifier, whose loadFromFile() reads it
+     * @param filepath - The location of the saved model
+     * @param calibration - The samples whose activations set the ranges of the quantized inputs of every layer
+     * @param evaluation - The samples on which the accuracy of both models is measured, may be empty
+     */
+    template<typename Model>
+    static QuantizedClassifier fromFile(const std::string &filepath, const DataTable &calibration,
+                                        const DataTable &evaluation) {
+        std::unique_ptr<Model> model(Model::loadFromFile(filepath));
+        if (!model) {
+            throw std::runtime_error("Failed to load the model to quantize from " + filepath);
+        }
+        return QuantizedClassifier(*model, calibration, evaluation);
+    }
+
+    /**
+     * @param input - The input vector
+     * @return - The class predicted by the quantized model
+     */
+    int predict(const std::vector<double> &input) const {
+        if (input.size() < engine.inputSize()) {
+            throw std::invalid_argument("Input vector is smaller than the input layer");
+        }
+        std::vector<float> buffer;
+        return engine.predict(helper::scalarData(input, buffer));
+    }
+
+    /**
+     * @brief Predicts the class of every row of a (rows x inputs) row-major matrix of features.
+     */
+    void predictBatch(const float *features, const size_t rows, int *classes, ThreadPool *pool = nullptr) const {
+        auto classify = [this, features, classes](const size_t row) {
+            classes[row] = engine.predict(features + row * engine.inputSize());
+        };
+        if (pool) {
+            pool->parallelFor(rows, classify);
+        } else {
+            for (size_t row = 0; row < rows; ++row) classify(row);
+        }
+    }
+
+    const QuantizedInferenceEngine &inferenceEngine() const {
+        return engine;
+    }
+
+    const QuantizationReport &getReport() const {
+        return report;
+    }
+};
+
+inline std::ostream &operator<<(std::ostream &os, const QuantizationReport &report) {
+    return os << "Accuracy: " << report.referenceAccuracy * 100.0 << "% -> " << report.quantizedAccuracy * 100.0
+              << "% (" << (report.accuracyDelta() >= 0.0 ? "+" : "") << report.accuracyDelta() * 100.0
+              << " points), parameters: " << report.referenceBytes << " -> " << report.quantizedBytes << " bytes";
+}
+
+#endif //QUANTIZEDCLASSIFIER_H
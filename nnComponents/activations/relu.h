@@ -1,4 +1,5 @@
 #include <autoGradEngine/node.h>
+#include <autoGradEngine/tensor.h>
 
 #ifndef RELU_H
 #define RELU_H
@@ -10,15 +11,27 @@
  * @param x - the input of the ReLU (Rectified Linear Unit) function
  * @return 
  */
-inline Node *relu(Node *x) {
+template<typename Scalar>
+BasicNode<Scalar> *relu(BasicNode<Scalar> *x) {
     auto self = x;
-    const auto out_data = (self->data < 0.0) ? 0.0 : self->data;
-    auto out = new Node(out_data, {self}, "ReLU");
+    const Scalar out_data = (self->data < 0) ? Scalar(0) : self->data;
+    // The backward pass is dispatched by Node::propagate on the RELU opcode
+    return new BasicNode<Scalar>(out_data, NodeOp::RELU, {self});
+}
+
+/**
+ * @brief Element-wise ReLU over a whole tensor.
+ *
+ * @param x - the input of the ReLU function
+ * @return - A new tensor of the same shape as @p x
+ */
+template<typename Scalar>
+BasicTensor<Scalar> *relu(BasicTensor<Scalar> *x) {
+    auto out = new BasicTensor<Scalar>(x->rows, x->cols, {x}, "ReLU");
+    kernels::active<Scalar>().relu(x->data, out->data, x->size());
 
-    // We define the logic for the backward operator
-    out->backwardProp = [self, out]() {
-        const double grad_mask = (out->data > 0.0) ? 1.0 : 0.0;
-        self->grad += grad_mask * out->grad;
+    out->backwardProp = [x, out]() {
+        kernels::active<Scalar>().reluBackward(out->data, out->grad, x->grad, out->size());
     };
 
     return out;
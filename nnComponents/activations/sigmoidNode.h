@@ -1,6 +1,7 @@
 #ifndef SIMOIDNODE_H
 #define SIMOIDNODE_H
 #include <autoGradEngine/node.h>
+#include <autoGradEngine/tensor.h>
 #include <cmath>
 
 /**
@@ -9,15 +10,30 @@
  * @param x - Sigmoid function's input
  * @return - A new node with the value of the sigmoid(x)
  */
-inline Node *sigmoid(Node *x) {
+template<typename Scalar>
+BasicNode<Scalar> *sigmoid(BasicNode<Scalar> *x) {
     auto self = x;
-    const double out_data = 1.0 / (1.0 + std::exp(-self->data));
-    auto out = new Node(out_data, {self}, "sigmoid");
+    const Scalar out_data = Scalar(1) / (Scalar(1) + std::exp(-self->data));
+    // The backward pass is dispatched by Node::propagate on the SIGMOID opcode
+    return new BasicNode<Scalar>(out_data, NodeOp::SIGMOID, {self});
+}
+
+/**
+ * @brief Element-wise sigmoid over a whole tensor.
+ *
+ * @param x - Sigmoid function's input
+ * @return - A new tensor of the same shape as @p x with the values of sigmoid(x)
+ */
+template<typename Scalar>
+BasicTensor<Scalar> *sigmoid(BasicTensor<Scalar> *x) {
+    auto out = new BasicTensor<Scalar>(x->rows, x->cols, {x}, "sigmoid");
+    kernels::active<Scalar>().sigmoid(x->data, out->data, x->size());
 
-    // We define the logic for the backward operator
-    out->backwardProp = [self, out]() {
-        const double sigmoid_val = out->data;
-        self->grad += sigmoid_val * (1.0 - sigmoid_val) * out->grad;
+    out->backwardProp = [x, out]() {
+        for (size_t i = 0; i < out->size(); ++i) {
+            const Scalar sigmoid_val = out->data[i];
+            x->grad[i] += sigmoid_val * (Scalar(1) - sigmoid_val) * out->grad[i];
+        }
     };
 
     return out;
@@ -2,8 +2,10 @@
 #define SOFTMAX_H
 
 #include <autoGradEngine/node.h>
+#include <autoGradEngine/tensor.h>
 #include <vector>
 #include <cmath>
+#include <initializer_list>
 
 /**
  * @brief Creates the probability distribution of the logits based on their weight. The logit with the greatest value
@@ -12,49 +14,35 @@
  * @param logits - A vector of scalar values
  * @return - A vector of nodes whose data values add up to 1.
  */
-inline std::vector<Node *> softmax(const std::vector<Node *> &logits) {
+template<typename Scalar>
+std::vector<BasicNode<Scalar> *> softmax(const std::vector<BasicNode<Scalar> *> &logits) {
     if (logits.empty()) {
         return {};
     }
 
     // Find the maximum logit
-    double maxLogit = logits.at(0)->data;
+    Scalar maxLogit = logits.at(0)->data;
     for (size_t i = 1; i < logits.size(); ++i) {
         maxLogit = std::max(maxLogit, logits.at(i)->data);
     }
 
-    std::vector<Node *> expValues;
-    expValues.reserve(logits.size());
-
-    // Sum all the e^(logit - maxLogit) and push into an array all the e^(logit(i) - maxLogit) for i in (1, n)
-    double sum_exp = 0.0;
-    for (Node *logit: logits) {
-        double exp_val = std::exp(logit->data - maxLogit);
-        sum_exp += exp_val;
-        expValues.push_back(new Node(exp_val, {logit}, "exp"));
+    // Sum all the e^(logit - maxLogit). The exponentials are not kept as nodes: the backward pass recomputes the
+    // probabilities from the logits, the max and the sum, which are stored in the payload of every probability node
+    Scalar sum_exp = 0;
+    for (BasicNode<Scalar> *logit: logits) {
+        sum_exp += std::exp(logit->data - maxLogit);
     }
 
-    std::vector<Node *> probabilities;
+    std::vector<BasicNode<Scalar> *> probabilities;
     probabilities.reserve(logits.size());
 
-    for (size_t i = 0; i < expValues.size(); ++i) {
+    for (size_t i = 0; i < logits.size(); ++i) {
         // Follows the softmax formula for finding the probabilities of each class
-        double prob = expValues.at(i)->data / sum_exp;
-        auto probabilityNode = new Node(prob, logits, "softmax");
-
-        // We define the logic for the backward operator
-        probabilityNode->backwardProp = [logits, i, sum_exp, expValues, probabilityNode]() {
-            const double prob_i = probabilityNode->data;
-
-            for (size_t j = 0; j < logits.size(); ++j) {
-                const double prob_j = expValues.at(j)->data / sum_exp;
-                if (i == j) {
-                    logits.at(j)->grad += prob_i * (1.0 - prob_i) * probabilityNode->grad;
-                } else {
-                    logits.at(j)->grad += -prob_i * prob_j * probabilityNode->grad;
-                }
-            }
-        };
+        const Scalar prob = std::exp(logits.at(i)->data - maxLogit) / sum_exp;
+        auto probabilityNode = new BasicNode<Scalar>(prob, NodeOp::SOFTMAX, logits.data(), logits.size());
+        probabilityNode->payload.softmax.maxLogit = maxLogit;
+        probabilityNode->payload.softmax.sumExp = sum_exp;
+        probabilityNode->payload.softmax.index = i;
 
         probabilities.push_back(probabilityNode);
     }
@@ -62,4 +50,66 @@ inline std::vector<Node *> softmax(const std::vector<Node *> &logits) {
     return probabilities;
 }
 
+/**
+ * @brief The softmax of a braced list of logits, softmax({&a, &b, &c}), whose scalar type can not be deduced through
+ * the vector overload.
+ */
+template<typename Scalar>
+std::vector<BasicNode<Scalar> *> softmax(std::initializer_list<BasicNode<Scalar> *> logits) {
+    return softmax(std::vector<BasicNode<Scalar> *>(logits));
+}
+
+/**
+ * @brief Applies the softmax to every row of @p logits, so that each sample of a batch gets its own probability
+ * distribution. Since the whole row is a single node, the backward pass only needs the dot product of the incoming
+ * gradient with the probabilities: dx_j = p_j * (g_j - sum_k g_k * p_k), which is O(n) per row.
+ *
+ * @param logits - A tensor with one row of logits per sample
+ * @return - A tensor of the same shape whose rows add up to 1.
+ */
+template<typename Scalar>
+BasicTensor<Scalar> *softmax(BasicTensor<Scalar> *logits) {
+    const size_t m = logits->rows, n = logits->cols;
+    auto out = new BasicTensor<Scalar>(m, n, {logits}, "softmax");
+
+    const kernels::BasicKernelTable<Scalar> &kernel = kernels::active<Scalar>();
+    for (size_t i = 0; i < m; ++i) {
+        const Scalar *x = logits->data + i * n;
+        Scalar *p = out->data + i * n;
+
+        Scalar maxLogit = x[0];
+        for (size_t j = 1; j < n; ++j) {
+            maxLogit = std::max(maxLogit, x[j]);
+        }
+
+        for (size_t j = 0; j < n; ++j) {
+            p[j] = x[j] - maxLogit;
+        }
+        kernel.exp(p, p, n);
+        Scalar sum_exp = 0;
+        for (size_t j = 0; j < n; ++j) {
+            sum_exp += p[j];
+        }
+        for (size_t j = 0; j < n; ++j) {
+            p[j] /= sum_exp;
+        }
+    }
+
+    out->backwardProp = [logits, out, m, n]() {
+        const kernels::BasicKernelTable<Scalar> &kernel = kernels::active<Scalar>();
+        for (size_t i = 0; i < m; ++i) {
+            const Scalar *p = out->data + i * n;
+            const Scalar *g = out->grad + i * n;
+            Scalar *dx = logits->grad + i * n;
+
+            const Scalar dot = kernel.dot(g, p, n);
+            for (size_t j = 0; j < n; ++j) {
+                dx[j] += p[j] * (g[j] - dot);
+            }
+        }
+    };
+
+    return out;
+}
+
 #endif //SOFTMAX_H
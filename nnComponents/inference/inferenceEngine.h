@@ -0,0 +1,214 @@
+#ifndef INFERENCEENGINE_H
+#define INFERENCEENGINE_H
+
+#include <vector>
+#include <cmath>
+#include <stdexcept>
+#include <algorithm>
+#include <autoGradEngine/kernels/gemm.h>
+#include <nnComponents/neuron.h>
+#include <utils/alignedAllocator.h>
+#include <utils/threadPool.h>
+
+/**
+ * A read-only description of a dense layer: its shape, its activation and where its parameters live. The weights are
+ * an (outputs x inputs) row-major matrix, like the one owned by Layer.
+ */
+template<typename Scalar>
+struct BasicDenseLayerView {
+    int inputs;
+    int outputs;
+    Activation activation;
+    const Scalar *weights;
+    const Scalar *biases;
+};
+
+using DenseLayerView = BasicDenseLayerView<double>;
+
+/**
+ * The inference engine evaluates a trained Multi-Layer Perceptron directly on plain buffers of its scalar type. It does
+ * not build an autograd graph at all: each layer is a matrix-vector product over the parameter values followed by the
+ * activation, written into an activation buffer that is allocated once and reused by every call.
+ *
+ * The engine does not own the parameters, it reads them from wherever the layer views point to, so it always sees the
+ * latest values of a network that is still being trained. An engine is not meant to be shared between threads, since
+ * the activation buffers are part of its state, with the exception of forwardBatch(), which only uses buffers of the
+ * calling thread.
+ */
+template<typename Scalar>
+class BasicInferenceEngine {
+    std::vector<BasicDenseLayerView<Scalar> > layers;
+    std::vector<AlignedVector<Scalar> > activations; // the output buffer of every layer
+
+    // The number of samples that go through the layers together in forwardBatch()
+    static constexpr size_t batchTile = 64;
+
+    /**
+     * @brief Runs up to batchTile samples through every layer, ping-ponging between two buffers of the calling thread.
+     */
+    void forwardTile(const Scalar *inputs, const size_t rows, Scalar *outputs) const {
+        thread_local AlignedVector<Scalar> buffers[2];
+        size_t widest = 0;
+        for (const auto &layer: layers) widest = std::max(widest, static_cast<size_t>(layer.outputs));
+        for (auto &buffer: buffers) {
+            if (buffer.size() < rows * widest) buffer.resize(rows * widest);
+        }
+
+        const Scalar *x = inputs;
+        for (size_t l = 0; l < layers.size(); ++l) {
+            const BasicDenseLayerView<Scalar> &layer = layers[l];
+            const size_t n = static_cast<size_t>(layer.inputs);
+            const size_t m = static_cast<size_t>(layer.outputs);
+            Scalar *y = (l + 1 == layers.size()) ? outputs : buffers[l % 2].data();
+
+            for (size_t r = 0; r < rows; ++r) {
+                std::copy(layer.biases, layer.biases + m, y + r * m);
+            }
+            // The tile already runs on a thread of its own, so the product itself stays on the calling thread
+            using MatrixView = kernels::BasicMatrixView<Scalar>;
+            kernels::gemm(rows, m, n, 1.0, MatrixView::rowMajor(x, n),
+                          MatrixView::rowMajor(layer.weights, n).transposed(), y, m, nullptr);
+
+            applyActivation(layer.activation, y, rows * m);
+            x = y;
+        }
+    }
+
+public:
+    BasicInferenceEngine() = default;
+
+    explicit BasicInferenceEngine(const std::vector<BasicDenseLayerView<Scalar> > &layers) {
+        bind(layers);
+    }
+
+    /**
+     * @brief Points the engine to a (possibly new) set of layers. The activation buffers are only reallocated when the
+     * shape of the network changes, so rebinding the same network before every call is cheap.
+     *
+     * @param layerViews - The layers of the network, from the first hidden layer to the output layer
+     */
+    void bind(const std::vector<BasicDenseLayerView<Scalar> > &layerViews) {
+        for (size_t i = 1; i < layerViews.size(); ++i) {
+            if (layerViews.at(i).inputs != layerViews.at(i - 1).outputs) {
+                throw std::invalid_argument("Consecutive layers of the inference engine do not fit together");
+            }
+        }
+
+        layers = layerViews;
+        activations.resize(layers.size());
+        for (size_t i = 0; i < layers.size(); ++i) {
+            activations.at(i).resize(static_cast<size_t>(layers.at(i).outputs));
+        }
+    }
+
+    size_t inputSize() const {
+        return layers.empty() ? 0 : static_cast<size_t>(layers.front().inputs);
+    }
+
+    size_t outputSize() const {
+        return layers.empty() ? 0 : static_cast<size_t>(layers.back().outputs);
+    }
+
+    /**
+     * @brief Runs one sample through the network.
+     *
+     * @param input - The features of the sample, inputSize() values
+     * @return - A pointer to the outputSize() activations of the output layer. It stays valid until the next call.
+     */
+    const Scalar *forward(const Scalar *input) {
+        const kernels::BasicKernelTable<Scalar> &kernel = kernels::active<Scalar>();
+        const Scalar *x = input;
+        for (size_t l = 0; l < layers.size(); ++l) {
+            const BasicDenseLayerView<Scalar> &layer = layers[l];
+            Scalar *y = activations[l].data();
+            const size_t n = static_cast<size_t>(layer.inputs);
+
+            for (int o = 0; o < layer.outputs; ++o) {
+                y[o] = layer.biases[o] + kernel.dot(layer.weights + static_cast<size_t>(o) * n, x, n);
+            }
+
+            applyActivation(layer.activation, y, static_cast<size_t>(layer.outputs));
+            x = y;
+        }
+        return x;
+    }
+
+    /**
+     * @brief Runs a whole matrix of samples through the network. The rows are processed in tiles, and each layer of a
+     * tile is a single cache-blocked gemm(). With a thread pool, the tiles are spread
+     * across its threads.
+     *
+     * @param inputs - A (rows x inputSize()) row-major matrix of features
+     * @param rows - The number of samples
+     * @param outputs - A (rows x outputSize()) row-major matrix that receives the activations of the output layer
+     * @param pool - An optional thread pool
+     */
+    void forwardBatch(const Scalar *inputs, const size_t rows, Scalar *outputs, ThreadPool *pool = nullptr) const {
+        const size_t tileRows = batchTile;
+        const size_t tiles = (rows + tileRows - 1) / tileRows;
+        auto runTile = [this, inputs, rows, outputs, tileRows](const size_t tile) {
+            const size_t begin = tile * tileRows;
+            const size_t count = std::min(tileRows, rows - begin);
+            forwardTile(inputs + begin * inputSize(), count, outputs + begin * outputSize());
+        };
+
+        if (pool) {
+            pool->parallelFor(tiles, runTile);
+        } else {
+            for (size_t tile = 0; tile < tiles; ++tile) runTile(tile);
+        }
+    }
+
+    /**
+     * @brief Threshold head for networks with a single output: the sample belongs to class 1 when the output reaches
+     * @p threshold.
+     */
+    int threshold(const Scalar *input, const double threshold = 0.5) {
+        return forward(input)[0] >= threshold ? 1 : 0;
+    }
+
+    /**
+     * @brief Argmax head for networks with one output per class. The softmax is monotonic, so the class with the
+     * largest logit is also the class with the largest probability.
+     */
+    int argmax(const Scalar *input) {
+        const Scalar *output = forward(input);
+        int best = 0;
+        for (size_t i = 1; i < outputSize(); ++i) {
+            if (output[i] > output[best]) best = static_cast<int>(i);
+        }
+        return best;
+    }
+
+    /**
+     * @brief Turns every row of a (rows x n) matrix of logits into a probability distribution, in place.
+     */
+    static void softmaxRows(Scalar *values, const size_t rows, const size_t n) {
+        for (size_t r = 0; r < rows; ++r) {
+            Scalar *row = values + r * n;
+            const Scalar maxLogit = *std::max_element(row, row + n);
+            for (size_t j = 0; j < n; ++j) row[j] -= maxLogit;
+            kernels::active<Scalar>().exp(row, row, n);
+            Scalar sum = 0;
+            for (size_t j = 0; j < n; ++j) sum += row[j];
+            for (size_t j = 0; j < n; ++j) row[j] /= sum;
+        }
+    }
+
+    static void applyActivation(const Activation activation, Scalar *values, const size_t n) {
+        switch (activation) {
+            case Activation::RELU:
+                kernels::active<Scalar>().relu(values, values, n);
+                break;
+            case Activation::SIGMOID:
+                kernels::active<Scalar>().sigmoid(values, values, n);
+                break;
+            default:
+                break;
+        }
+    }
+};
+
+using InferenceEngine = BasicInferenceEngine<double>;
+
+#endif //INFERENCEENGINE_H
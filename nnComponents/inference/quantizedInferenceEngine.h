@@ -0,0 +1,241 @@
+#ifndef QUANTIZEDINFERENCEENGINE_H
+#define QUANTIZEDINFERENCEENGINE_H
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <algorithm>
+#include <nnComponents/inference/inferenceEngine.h>
+#include <utils/alignedAllocator.h>
+#include <utils/threadPool.h>
+
+/**
+ * A dense layer in int8. The weights are quantized symmetrically with one scale per output channel, and the inputs of
+ * the layer with a single scale that was calibrated on sample data. A real value v is stored as round(v / scale),
+ * clamped to [-127, 127]. The biases are stored in int32, in units of the product of the two scales, so that they can
+ * be added to the int32 accumulator of the dot product directly.
+ */
+struct QuantizedDenseLayer {
+    int inputs;
+    int outputs;
+    Activation activation;
+    float inputScale;
+    AlignedVector<int8_t> weights;  // (outputs x inputs) row-major
+    std::vector<int32_t> biases;
+    std::vector<float> outputScales; // inputScale times the scale of the weights of every output
+};
+
+/**
+ * An inference engine for networks whose weights and activations are quantized to int8. Every layer quantizes its
+ * input, computes its outputs as int8 dot products accumulated in int32, and turns them back into floats for the
+ * activation, so the weights take a quarter of the memory of a float network and an eighth of a double one.
+ *
+ * Unlike InferenceEngine, the quantized engine owns a copy of its parameters: it is built once from a trained network
+ * and does not see later updates. Its buffers belong to the calling thread, so it can be shared between threads.
+ */
+class QuantizedInferenceEngine {
+    std::vector<QuantizedDenseLayer> layers;
+
+    // The number of samples that forwardBatch() hands to a thread at a time
+    static constexpr size_t batchTile = 64;
+
+    static int8_t quantizeValue(const float value, const float inverseScale) {
+        const float q = std::nearbyint(value * inverseScale);
+        return static_cast<int8_t>(std::max(-127.0f, std::min(127.0f, q)));
+    }
+
+    /**
+     * @return The scale that maps [-maxAbs, maxAbs] onto [-127, 127]
+     */
+    static float symmetricScale(const double maxAbs) {
+        return maxAbs > 0.0 ? static_cast<float>(maxAbs / 127.0) : 1.0f;
+    }
+
+    void forwardRow(const float *input, float *output) const {
+        thread_local AlignedVector<int8_t> quantized;
+        thread_local AlignedVector<float> buffers[2];
+        const kernels::BasicKernelTable<float> &kernel = kernels::active<float>();
+
+        const float *x = input;
+        for (size_t l = 0; l < layers.size(); ++l) {
+            const QuantizedDenseLayer &layer = layers[l];
+            const size_t n = static_cast<size_t>(layer.inputs);
+            const size_t m = static_cast<size_t>(layer.outputs);
+            if (quantized.size() < n) quantized.resize(n);
+            float *y = output;
+            if (l + 1 < layers.size()) {
+                if (buffers[l % 2].size() < m) buffers[l % 2].resize(m);
+                y = buffers[l % 2].data();
+            }
+
+            const float inverseScale = 1.0f / layer.inputScale;
+            for (size_t i = 0; i < n; ++i) quantized[i] = quantizeValue(x[i], inverseScale);
+            for (size_t o = 0; o < m; ++o) {
+                const int32_t accumulator = layer.biases[o] + kernel.dotInt8(layer.weights.data() + o * n,
+                                                                             quantized.data(), n);
+                y[o] = static_cast<float>(accumulator) * layer.outputScales[o];
+            }
+
+            BasicInferenceEngine<float>::applyActivation(layer.activation, y, m);
+            x = y;
+        }
+    }
+
+public:
+    QuantizedInferenceEngine() = default;
+
+    /**
+     * @brief Quantizes a trained network. The range of the input of every layer is the largest absolute value it
+     * takes when the calibration samples run through the network in full precision, so the samples should cover the
+     * data the engine is going to serve.
+     *
+     * @param layerViews - The layers of the network, from the first hidden layer to the output layer
+     * @param calibration - A (rows x inputs) row-major matrix of sample features
+     * @param rows - The number of calibration samples
+     * @return - The quantized engine
+     */
+    template<typename Scalar>
+    static QuantizedInferenceEngine quantize(const std::vector<BasicDenseLayerView<Scalar> > &layerViews,
+                                             const double *calibration, const size_t rows) {
+        if (layerViews.empty()) {
+            throw std::invalid_argument("Cannot quantize a network without layers");
+        }
+        if (rows == 0) {
+            throw std::invalid_argument("Quantization needs at least one calibration sample");
+        }
+        for (size_t l = 1; l < layerViews.size(); ++l) {
+            if (layerViews[l].inputs != layerViews[l - 1].outputs) {
+                throw std::invalid_argument("Consecutive layers of the quantized engine do not fit together");
+            }
+        }
+
+        // Runs the calibration samples through the network and records the range of the input of every layer
+        std::vector<double> inputRanges(layerViews.size(), 0.0);
+        const kernels::BasicKernelTable<Scalar> &kernel = kernels::active<Scalar>();
+        const size_t inputs = static_cast<size_t>(layerViews.front().inputs);
+        std::vector<Scalar> x, y;
+        for (size_t r = 0; r < rows; ++r) {
+            x.assign(calibration + r * inputs, calibration + (r + 1) * inputs);
+            for (size_t l = 0; l < layerViews.size(); ++l) {
+                const BasicDenseLayerView<Scalar> &layer = layerViews[l];
+                const size_t n = static_cast<size_t>(layer.inputs);
+                for (const Scalar value: x) {
+                    inputRanges[l] = std::max(inputRanges[l], std::fabs(static_cast<double>(value)));
+                }
+
+                y.resize(static_cast<size_t>(layer.outputs));
+                for (size_t o = 0; o < y.size(); ++o) {
+                    y[o] = layer.biases[o] + kernel.dot(layer.weights + o * n, x.data(), n);
+                }
+                BasicInferenceEngine<Scalar>::applyActivation(layer.activation, y.data(), y.size());
+                x.swap(y);
+            }
+        }
+
+        QuantizedInferenceEngine engine;
+        for (size_t l = 0; l < layerViews.size(); ++l) {
+            const BasicDenseLayerView<Scalar> &view = layerViews[l];
+            const size_t n = static_cast<size_t>(view.inputs);
+            const size_t m = static_cast<size_t>(view.outputs);
+
+            QuantizedDenseLayer layer;
+            layer.inputs = view.inputs;
+            layer.outputs = view.outputs;
+            layer.activation = view.activation;
+            layer.inputScale = symmetricScale(inputRanges[l]);
+            layer.weights.resize(m * n);
+            layer.biases.resize(m);
+            layer.outputScales.resize(m);
+
+            for (size_t o = 0; o < m; ++o) {
+                const Scalar *row = view.weights + o * n;
+                double maxAbs = 0.0;
+                for (size_t i = 0; i < n; ++i) maxAbs = std::max(maxAbs, std::fabs(static_cast<double>(row[i])));
+                const float weightScale = symmetricScale(maxAbs);
+                for (size_t i = 0; i < n; ++i) {
+                    layer.weights[o * n + i] = quantizeValue(static_cast<float>(row[i]), 1.0f / weightScale);
+                }
+
+                layer.outputScales[o] = layer.inputScale * weightScale;
+                const double bias = std::nearbyint(static_cast<double>(view.biases[o]) / layer.outputScales[o]);
+                const double limit = static_cast<double>(std::numeric_limits<int32_t>::max());
+                layer.biases[o] = static_cast<int32_t>(std::max(-limit, std::min(limit, bias)));
+            }
+            engine.layers.push_back(std::move(layer));
+        }
+        return engine;
+    }
+
+    size_t inputSize() const {
+        return layers.empty() ? 0 : static_cast<size_t>(layers.front().inputs);
+    }
+
+    size_t outputSize() const {
+        return layers.empty() ? 0 : static_cast<size_t>(layers.back().outputs);
+    }
+
+    const std::vector<QuantizedDenseLayer> &quantizedLayers() const {
+        return layers;
+    }
+
+    /**
+     * @return The memory taken by the int8 weights and the int32 biases of every layer
+     */
+    size_t parameterBytes() const {
+        size_t bytes = 0;
+        for (const QuantizedDenseLayer &layer: layers) {
+            bytes += layer.weights.size() * sizeof(int8_t) + layer.biases.size() * sizeof(int32_t);
+        }
+        return bytes;
+    }
+
+    /**
+     * @brief Runs one sample through the network.
+     *
+     * @param input - The features of the sample, inputSize() values
+     * @param output - Receives the outputSize() activations of the output layer
+     */
+    void forward(const float *input, float *output) const {
+        forwardRow(input, output);
+    }
+
+    /**
+     * @brief Runs a whole matrix of samples through the network, spread over the threads of @p pool if there is one.
+     *
+     * @param inputs - A (rows x inputSize()) row-major matrix of features
+     * @param rows - The number of samples
+     * @param outputs - A (rows x outputSize()) row-major matrix that receives the activations of the output layer
+     * @param pool - An optional thread pool
+     */
+    void forwardBatch(const float *inputs, const size_t rows, float *outputs, ThreadPool *pool = nullptr) const {
+        const size_t tiles = (rows + batchTile - 1) / batchTile;
+        auto runTile = [this, inputs, rows, outputs](const size_t tile) {
+            const size_t end = std::min(rows, (tile + 1) * batchTile);
+            for (size_t r = tile * batchTile; r < end; ++r) {
+                forwardRow(inputs + r * inputSize(), outputs + r * outputSize());
+            }
+        };
+
+        if (pool) {
+            pool->parallelFor(tiles, runTile);
+        } else {
+            for (size_t tile = 0; tile < tiles; ++tile) runTile(tile);
+        }
+    }
+
+    /**
+     * @brief The class of a sample: the threshold head for networks with a single output, the argmax head otherwise,
+     * see InferenceEngine::threshold and InferenceEngine::argmax.
+     */
+    int predict(const float *input, const double threshold = 0.5) const {
+        thread_local std::vector<float> output;
+        output.resize(outputSize());
+        forwardRow(input, output.data());
+        if (output.size() == 1) return output[0] >= threshold ? 1 : 0;
+        return static_cast<int>(std::max_element(output.begin(), output.end()) - output.begin());
+    }
+};
+
+#endif //QUANTIZEDINFERENCEENGINE_H
@@ -1,23 +1,79 @@
 #ifndef LAYER_H
 #define LAYER_H
+#include <memory>
 #include <nnComponents/module.h>
 #include <nnComponents/neuron.h>
+#include <nnComponents/inference/inferenceEngine.h>
+#include <utils/alignedAllocator.h>
 
 /**
- * The Layer class represents a layer in a Multi-Layer perceptron architecture. It takes a vector of Neurons, thus serving
- * as the mediator between Neuron and Network.
+ * The Layer class represents a layer in a Multi-Layer perceptron architecture, serving as the mediator between Neuron
+ * and Network. A layer of n neurons with m inputs each keeps all of its weights in a single dense (n x m) matrix, where
+ * row i holds the weights of neuron i, and its biases in a vector of length n. The gradients live in matrices of the
+ * same shape, so both passes are matrix-vector products over contiguous, cache-line aligned memory. The matrices hold
+ * the scalar type of the layer, and Layer is the double precision one.
  */
-class Layer final : public Module {
-    std::vector<Neuron> neurons;
+template<typename Scalar>
+class BasicLayer final : public BasicModule<Scalar> {
+    int numberOfInputs;
+    int numberOfOutputs;
+    Activation activation;
+
+    AlignedVector<Scalar> weights;
+    AlignedVector<Scalar> biases;
+    AlignedVector<Scalar> weightGradients;
+    AlignedVector<Scalar> biasGradients;
+
+    // Node views over the dense storage, created on the first call to parameters()
+    std::vector<std::unique_ptr<BasicNode<Scalar> > > parameterViews;
+
+    BasicNode<Scalar> *applyActivation(BasicNode<Scalar> *weightedSum) const {
+        switch (activation) {
+            case Activation::RELU:
+                return relu(weightedSum);
+            case Activation::SIGMOID:
+                return sigmoid(weightedSum);
+            default:
+                return weightedSum;
+        }
+    }
 
 public:
-    Layer(int numberOfInputs, int numberOfOutputs, Activation act = Activation::RELU) {
-        neurons.reserve(numberOfOutputs);
-        for (int i = 0; i < numberOfOutputs; ++i) {
-            neurons.emplace_back(numberOfInputs, act);
+    BasicLayer(int numberOfInputs, int numberOfOutputs, Activation act = Activation::RELU)
+        : numberOfInputs(numberOfInputs), numberOfOutputs(numberOfOutputs), activation(act),
+          weights(static_cast<size_t>(numberOfInputs) * numberOfOutputs),
+          biases(numberOfOutputs, Scalar(0)),
+          weightGradients(weights.size(), Scalar(0)),
+          biasGradients(numberOfOutputs, Scalar(0)) {
+        for (Scalar &weight: weights) {
+            weight = static_cast<Scalar>(generate_weight(numberOfInputs));
+        }
+    }
+
+    BasicLayer(const BasicLayer &other)
+        : numberOfInputs(other.numberOfInputs), numberOfOutputs(other.numberOfOutputs),
+          activation(other.activation), weights(other.weights), biases(other.biases),
+          weightGradients(other.weightGradients), biasGradients(other.biasGradients) {
+    }
+
+    BasicLayer(BasicLayer &&other) noexcept = default;
+
+    BasicLayer &operator=(const BasicLayer &other) {
+        if (this != &other) {
+            numberOfInputs = other.numberOfInputs;
+            numberOfOutputs = other.numberOfOutputs;
+            activation = other.activation;
+            weights = other.weights;
+            biases = other.biases;
+            weightGradients = other.weightGradients;
+            biasGradients = other.biasGradients;
+            parameterViews.clear();
         }
+        return *this;
     }
 
+    BasicLayer &operator=(BasicLayer &&other) noexcept = default;
+
     /**
      * @brief Runs the inputs from the previous layer through the current layer and returns the outputs that were
      * calculated with the activation function applied.
@@ -25,39 +81,163 @@ public:
      * @param x - The input passed to the current layer from the previous one
      * @return - The outputs that are produced by each Neuron in the current layer
      */
-    std::vector<Node *> operator()(const std::vector<Node *> &x) {
-        std::vector<Node *> output;
-        output.reserve(neurons.size());
-        for (auto &neuron: neurons) {
-            output.push_back(neuron(x));
+    std::vector<BasicNode<Scalar> *> operator()(const std::vector<BasicNode<Scalar> *> &x) {
+        std::vector<BasicNode<Scalar> *> output = weightedSums(x);
+        for (BasicNode<Scalar> *&node: output) {
+            node = applyActivation(node);
         }
         return output;
     }
 
     /**
-     * @return A vector of all the weights and biases of the neurons (parameters) of a layer
+     * @brief Computes the weighted sums of the layer without applying its activation. Losses that fuse the activation
+     * of the output layer (see BinaryCrossEntropyLoss::fromLogits) are fed from here.
+     *
+     * @param x - The input vector of the layer
+     * @return - One weighted sum per neuron
+     */
+    std::vector<BasicNode<Scalar> *> weightedSums(const std::vector<BasicNode<Scalar> *> &x) {
+        if (x.size() < static_cast<size_t>(numberOfInputs)) {
+            throw std::out_of_range("Layer received fewer inputs than it has weights per neuron");
+        }
+
+        // The gradients go to the buffer of the worker when training is data-parallel
+        Scalar *weightGrad = BasicGradientRedirect<Scalar>::resolve(weightGradients.data());
+        Scalar *biasGrad = BasicGradientRedirect<Scalar>::resolve(biasGradients.data());
+
+        std::vector<BasicNode<Scalar> *> output;
+        output.reserve(numberOfOutputs);
+        for (int i = 0; i < numberOfOutputs; ++i) {
+            const size_t row = static_cast<size_t>(i) * numberOfInputs;
+            output.push_back(BasicNode<Scalar>::weightedSum(weights.data() + row, weightGrad + row,
+                                                            biases.data() + i, biasGrad + i, x, numberOfInputs));
+        }
+        return output;
+    }
+
+    /**
+     * @brief Runs a whole batch through the layer at once. The weight matrix enters the graph as a view, so the forward
+     * pass is one matrix product with the bias added in, followed by one activation.
+     *
+     * @param x - A (batch x inputs) tensor holding one sample per row
+     * @return - A (batch x outputs) tensor with the activations of the layer
+     */
+    BasicTensor<Scalar> *operator()(BasicTensor<Scalar> *x) {
+        BasicTensor<Scalar> *weightedSum = weightedSums(x);
+
+        switch (activation) {
+            case Activation::RELU:
+                return relu(weightedSum);
+            case Activation::SIGMOID:
+                return sigmoid(weightedSum);
+            default:
+                return weightedSum;
+        }
+    }
+
+    /**
+     * @brief Computes the weighted sums of a whole batch without applying the activation of the layer.
+     *
+     * @param x - A (batch x inputs) tensor holding one sample per row
+     * @return - A (batch x outputs) tensor with the weighted sums of the layer
+     */
+    BasicTensor<Scalar> *weightedSums(BasicTensor<Scalar> *x) {
+        using Redirect = BasicGradientRedirect<Scalar>;
+        BasicTensor<Scalar> *weightMatrix = BasicTensor<Scalar>::view(numberOfOutputs, numberOfInputs, weights.data(),
+                                                                      Redirect::resolve(weightGradients.data()));
+        BasicTensor<Scalar> *biasVector = BasicTensor<Scalar>::view(1, numberOfOutputs, biases.data(),
+                                                                    Redirect::resolve(biasGradients.data()));
+        return linear(x, weightMatrix, biasVector);
+    }
+
+    /**
+     * @return A vector of views over all the weights and biases (parameters) of the layer, ordered neuron by neuron
+     * with the bias of each neuron after its weights
      */
-    std::vector<Node *> parameters() override {
-        std::vector<Node *> layerParameters;
-        for (auto &neuron: neurons) {
-            auto neuronParameters = neuron.parameters();
-            layerParameters.insert(layerParameters.end(), neuronParameters.begin(), neuronParameters.end());
+    std::vector<BasicNode<Scalar> *> parameters() override {
+        if (parameterViews.empty()) {
+            // The views belong to the layer, so they must not end up in the arena of an open GraphScope
+            HeapScope heapScope;
+            parameterViews.reserve(weights.size() + biases.size());
+            for (int i = 0; i < numberOfOutputs; ++i) {
+                for (int j = 0; j < numberOfInputs; ++j) {
+                    const size_t index = static_cast<size_t>(i) * numberOfInputs + j;
+                    parameterViews.emplace_back(
+                        BasicNode<Scalar>::view(weights.at(index), weightGradients.at(index)));
+                }
+                parameterViews.emplace_back(BasicNode<Scalar>::view(biases.at(i), biasGradients.at(i)));
+            }
+        }
+
+        std::vector<BasicNode<Scalar> *> layerParameters;
+        layerParameters.reserve(parameterViews.size());
+        for (auto &view: parameterViews) {
+            layerParameters.push_back(view.get());
         }
         return layerParameters;
     }
 
+    /**
+     * @return The weight matrix and the bias vector as two contiguous blocks
+     */
+    std::vector<BasicParameterBlock<Scalar> > parameterBlocks() override {
+        return {
+            BasicParameterBlock<Scalar>{weights.data(), weightGradients.data(), weights.size()},
+            BasicParameterBlock<Scalar>{biases.data(), biasGradients.data(), biases.size()}
+        };
+    }
+
+    void clearGradients() override {
+        std::fill(weightGradients.begin(), weightGradients.end(), Scalar(0));
+        std::fill(biasGradients.begin(), biasGradients.end(), Scalar(0));
+    }
+
+    int getNumberOfInputs() const {
+        return numberOfInputs;
+    }
+
+    int getNumberOfOutputs() const {
+        return numberOfOutputs;
+    }
+
+    Activation getActivation() const {
+        return activation;
+    }
+
+    /**
+     * @return The (outputs x inputs) row-major weight matrix
+     */
+    const Scalar *getWeights() const {
+        return weights.data();
+    }
+
+    const Scalar *getBiases() const {
+        return biases.data();
+    }
+
+    /**
+     * @return A read-only view of the layer that the inference engine can evaluate without building a graph
+     */
+    BasicDenseLayerView<Scalar> denseView() const {
+        return BasicDenseLayerView<Scalar>{numberOfInputs, numberOfOutputs, activation, weights.data(), biases.data()};
+    }
+
     std::string representation() const {
+        const std::string neuron = activationName(activation) + "Neuron(" + std::to_string(numberOfInputs) + ")";
         std::string s = "Layer of [";
-        for (size_t i = 0; i < neurons.size(); ++i) {
-            s += neurons.at(i).representation();
-            if (i + 1 < neurons.size()) s += ", ";
+        for (int i = 0; i < numberOfOutputs; ++i) {
+            s += neuron;
+            if (i + 1 < numberOfOutputs) s += ", ";
         }
         return s + "]";
     }
 };
 
-inline std::ostream &operator<<(std::ostream &os, const Layer &layer) {
+template<typename Scalar>
+std::ostream &operator<<(std::ostream &os, const BasicLayer<Scalar> &layer) {
     return os << layer.representation();
 }
 
+using Layer = BasicLayer<double>;
+
 #endif //LAYER_H
@@ -2,13 +2,22 @@
 #define BINARYCROSSENTROPY_H
 
 #include <autoGradEngine/node.h>
+#include <autoGradEngine/tensor.h>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
 
 /**
  *  The binary cross-entropy loss function computes the loss for the binary classifier given the certainty that the model
  *  has in the correct target class. By minimizing the value of this function, we train the model to make the distinction
  *  between two classes of objects.
+ *
+ *  The loss is a template over the scalar type of the network, and BinaryCrossEntropyLoss is the double precision one.
+ *  Targets are always given as double.
  */
-class BinaryCrossEntropyLoss {
+template<typename Scalar>
+class BasicBinaryCrossEntropyLoss {
 public:
     /**
      * @brief This function is used to produce the loss value for a given prediction to a certain target of interest.
@@ -18,19 +27,98 @@ public:
      * @param epsilon - The minimum value of the input passed to the log function so that we prevent log(0)
      * @return - The value of the binary classifier loss
      */
-    static Node *compute(Node *prediction, double const target, double const epsilon = 1e-7) {
+    static BasicNode<Scalar> *compute(BasicNode<Scalar> *prediction, double const target,
+                                      double const epsilon = 1e-7) {
         const auto predClamped = prediction;
-        const auto logPred = Node::logNode(predClamped, epsilon);
+        const auto logPred = BasicNode<Scalar>::logNode(predClamped, epsilon);
         const auto term1 = (*logPred) * (-target);
 
         const auto oneMinusPred = *((*predClamped) * (-1.0)) + 1.0;
-        const auto logOneMinusPred = Node::logNode(oneMinusPred, epsilon);
+        const auto logOneMinusPred = BasicNode<Scalar>::logNode(oneMinusPred, epsilon);
         const auto term2 = (*logOneMinusPred) * (-(1.0 - target));
 
         const auto loss = (*term1) + (*term2);
         return loss;
     }
+
+    /**
+     * @brief Computes the average binary cross-entropy over a batch of predictions.
+     *
+     * @param predictions - A (batch x 1) tensor with the certainty of the model that each sample belongs to class 1
+     * @param targets - The desired output of every sample in the batch
+     * @param epsilon - The minimum value of the input passed to the log function so that we prevent log(0)
+     * @return - A 1x1 tensor with the mean loss of the batch
+     */
+    static BasicTensor<Scalar> *compute(BasicTensor<Scalar> *predictions, const std::vector<double> &targets,
+                                        double const epsilon = 1e-7) {
+        const auto positive = new BasicTensor<Scalar>(predictions->rows, 1,
+                                                      std::vector<Scalar>(targets.begin(), targets.end()));
+        const auto negative = *((*positive) * (-1.0)) + 1.0;
+
+        const auto logPred = BasicTensor<Scalar>::logTensor(predictions, epsilon);
+        const auto term1 = (*logPred) * (*positive);
+
+        const auto oneMinusPred = *((*predictions) * (-1.0)) + 1.0;
+        const auto logOneMinusPred = BasicTensor<Scalar>::logTensor(oneMinusPred, epsilon);
+        const auto term2 = (*logOneMinusPred) * (*negative);
+
+        const auto loss = (*mean((*term1) + (*term2))) * (-1.0);
+        return loss;
+    }
+
+    /**
+     * @brief Computes the loss straight from the logit, fusing the sigmoid and the binary cross-entropy into a single
+     * node: loss = max(z, 0) - z * y + log(1 + exp(-|z|)). This form never overflows and needs no epsilon, and its
+     * backward pass is simply sigmoid(z) - y.
+     *
+     * @param logit - The raw output of the network, before the sigmoid
+     * @param target - The desired output
+     * @return - The value of the binary classifier loss
+     */
+    static BasicNode<Scalar> *fromLogits(BasicNode<Scalar> *logit, double const target) {
+        const Scalar z = logit->data;
+        const Scalar y = static_cast<Scalar>(target);
+        const Scalar loss = std::max(z, Scalar(0)) - z * y + std::log1p(std::exp(-std::abs(z)));
+        auto out = new BasicNode<Scalar>(loss, NodeOp::SIGMOID_CROSS_ENTROPY, {logit});
+        out->payload.constant = y;
+        return out;
+    }
+
+    /**
+     * @brief Computes the average fused sigmoid binary cross-entropy over a batch of logits.
+     *
+     * @param logits - A (batch x 1) tensor with the raw outputs of the network
+     * @param targets - The desired output of every sample in the batch
+     * @return - A 1x1 tensor with the mean loss of the batch
+     */
+    static BasicTensor<Scalar> *fromLogits(BasicTensor<Scalar> *logits, const std::vector<double> &targets) {
+        const size_t m = logits->rows;
+        if (targets.size() != m) {
+            throw std::invalid_argument("Every row of the logits needs a target");
+        }
+
+        auto out = new BasicTensor<Scalar>(1, 1, {logits}, "sigmoid_cross_entropy");
+        Scalar total = 0;
+        for (size_t i = 0; i < m; ++i) {
+            const Scalar z = logits->data[i * logits->cols];
+            total += std::max(z, Scalar(0)) - z * static_cast<Scalar>(targets.at(i))
+                    + std::log1p(std::exp(-std::abs(z)));
+        }
+        out->data[0] = m > 0 ? total / static_cast<Scalar>(m) : Scalar(0);
+
+        out->backwardProp = [logits, out, targets, m]() {
+            const Scalar g = out->grad[0] / static_cast<Scalar>(m);
+            for (size_t i = 0; i < m; ++i) {
+                const Scalar z = logits->data[i * logits->cols];
+                const Scalar prediction = Scalar(1) / (Scalar(1) + std::exp(-z));
+                logits->grad[i * logits->cols] += (prediction - static_cast<Scalar>(targets.at(i))) * g;
+            }
+        };
+
+        return out;
+    }
 };
 
+using BinaryCrossEntropyLoss = BasicBinaryCrossEntropyLoss<double>;
 
 #endif //BINARYCROSSENTROPY_H
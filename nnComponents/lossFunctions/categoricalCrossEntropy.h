@@ -2,15 +2,23 @@
 #define CATEGORICALCROSSENTROPY_H
 
 #include <autoGradEngine/node.h>
+#include <autoGradEngine/tensor.h>
 #include <vector>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
 
 /**
  *  The categorical cross-entropy loss function computes the loss based on the probability distribution all possible targets.
  *  It computes how certain our model is in assigning the biggest probability to the target class, while assigning probabilities
  *  close to zero for the other classes. By minimizing this function, our model is able to classify inputs among several
  *  classes.
+ *
+ *  Like the binary loss, it is a template over the scalar type of the network, and CategoricalCrossEntropyLoss is the
+ *  double precision one.
  */
-class CategoricalCrossEntropyLoss {
+template<typename Scalar>
+class BasicCategoricalCrossEntropyLoss {
 public:
     /**
      * @brief This function is used to produce the loss value for a given prediction to a certain target of interest.
@@ -20,8 +28,8 @@ public:
      * @param epsilon - The minimum value of the input passed to the log function so that we prevent log(0)
      * @return - The value of the multi-class classifier loss
      */
-    static Node *compute(const std::vector<Node *> &predictions, int target,
-                         const double epsilon = 1e-7) {
+    static BasicNode<Scalar> *compute(const std::vector<BasicNode<Scalar> *> &predictions, int target,
+                                      const double epsilon = 1e-7) {
         if (predictions.empty()) {
             std::cout << "Predictions vector cannot be empty";
         }
@@ -29,11 +37,130 @@ public:
             std::cout << "Target class out of range";
         }
 
-        auto logProb = Node::logNode(predictions.at(target), epsilon);
+        auto logProb = BasicNode<Scalar>::logNode(predictions.at(target), epsilon);
         const auto loss = (*logProb) * (-1.0);
 
         return loss;
     }
+
+    /**
+     * @brief Computes the average categorical cross-entropy over a batch of probability distributions.
+     *
+     * @param predictions - A (batch x classes) tensor with one probability distribution per row
+     * @param targets - The index of the desired class of every sample in the batch
+     * @param epsilon - The minimum value of the input passed to the log function so that we prevent log(0)
+     * @return - A 1x1 tensor with the mean loss of the batch
+     * @throws std::invalid_argument - If the number of targets is not the batch size or a target is not a class
+     */
+    static BasicTensor<Scalar> *compute(BasicTensor<Scalar> *predictions, const std::vector<double> &targets,
+                                        const double epsilon = 1e-7) {
+        if (targets.size() != predictions->rows) {
+            throw std::invalid_argument("Every row of the predictions needs a target");
+        }
+        std::vector<size_t> targetClasses;
+        targetClasses.reserve(targets.size());
+        for (const double target: targets) {
+            if (!(target >= 0 && target < static_cast<double>(predictions->cols))) {
+                throw std::invalid_argument("Target class out of range");
+            }
+            targetClasses.push_back(static_cast<size_t>(target));
+        }
+
+        auto logProb = BasicTensor<Scalar>::logTensor(selectColumns(predictions, targetClasses), epsilon);
+        const auto loss = (*mean(logProb)) * (-1.0);
+
+        return loss;
+    }
+
+    /**
+     * @brief Computes the loss straight from the logits, fusing the softmax and the cross-entropy into a single node:
+     * loss = log(sum_j exp(l_j)) - l_target. It is evaluated with the max-subtraction trick in one pass, and its
+     * backward pass is simply p - onehot(target), which is O(n) instead of the O(n^2) of a separate softmax.
+     *
+     * @param logits - The raw outputs of the network, before any softmax
+     * @param target - The desired output
+     * @return - The value of the multi-class classifier loss
+     */
+    static BasicNode<Scalar> *fromLogits(const std::vector<BasicNode<Scalar> *> &logits, const int target) {
+        if (target < 0 || target >= static_cast<int>(logits.size())) {
+            throw std::out_of_range("Target class out of range");
+        }
+
+        Scalar maxLogit = logits.at(0)->data;
+        for (size_t j = 1; j < logits.size(); ++j) {
+            maxLogit = std::max(maxLogit, logits.at(j)->data);
+        }
+        Scalar sumExp = 0;
+        for (const BasicNode<Scalar> *logit: logits) {
+            sumExp += std::exp(logit->data - maxLogit);
+        }
+
+        const Scalar loss = maxLogit + std::log(sumExp) - logits.at(target)->data;
+        auto out = new BasicNode<Scalar>(loss, NodeOp::SOFTMAX_CROSS_ENTROPY, logits.data(), logits.size());
+        out->payload.softmax.maxLogit = maxLogit;
+        out->payload.softmax.sumExp = sumExp;
+        out->payload.softmax.index = static_cast<size_t>(target);
+        return out;
+    }
+
+    /**
+     * @brief Computes the average fused softmax cross-entropy over a batch of logits.
+     *
+     * @param logits - A (batch x classes) tensor with the raw outputs of the network
+     * @param targets - The index of the desired class of every sample in the batch
+     * @return - A 1x1 tensor with the mean loss of the batch
+     */
+    static BasicTensor<Scalar> *fromLogits(BasicTensor<Scalar> *logits, const std::vector<double> &targets) {
+        const size_t m = logits->rows, n = logits->cols;
+        if (targets.size() != m) {
+            throw std::invalid_argument("Every row of the logits needs a target");
+        }
+        for (const double target: targets) {
+            if (target < 0 || target >= static_cast<double>(n)) {
+                throw std::out_of_range("Target class out of range");
+            }
+        }
+
+        // The probabilities are kept for the backward pass, which owns them
+        std::vector<Scalar> probabilities(m * n);
+        auto out = new BasicTensor<Scalar>(1, 1, {logits}, "softmax_cross_entropy");
+
+        Scalar total = 0;
+        for (size_t i = 0; i < m; ++i) {
+            const Scalar *x = logits->data + i * n;
+            Scalar *p = probabilities.data() + i * n;
+            Scalar maxLogit = x[0];
+            for (size_t j = 1; j < n; ++j) {
+                maxLogit = std::max(maxLogit, x[j]);
+            }
+            Scalar sumExp = 0;
+            for (size_t j = 0; j < n; ++j) {
+                p[j] = std::exp(x[j] - maxLogit);
+                sumExp += p[j];
+            }
+            for (size_t j = 0; j < n; ++j) {
+                p[j] /= sumExp;
+            }
+            total += maxLogit + std::log(sumExp) - x[static_cast<size_t>(targets.at(i))];
+        }
+        out->data[0] = m > 0 ? total / static_cast<Scalar>(m) : Scalar(0);
+
+        out->backwardProp = [logits, probabilities, out, targets, m, n]() {
+            const Scalar g = out->grad[0] / static_cast<Scalar>(m);
+            for (size_t i = 0; i < m; ++i) {
+                const Scalar *p = probabilities.data() + i * n;
+                Scalar *dx = logits->grad + i * n;
+                for (size_t j = 0; j < n; ++j) {
+                    dx[j] += p[j] * g;
+                }
+                dx[static_cast<size_t>(targets.at(i))] -= g;
+            }
+        };
+
+        return out;
+    }
 };
 
+using CategoricalCrossEntropyLoss = BasicCategoricalCrossEntropyLoss<double>;
+
 #endif //CATEGORICALCROSSENTROPY_H
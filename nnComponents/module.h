@@ -2,28 +2,111 @@
 #define MODULE_H
 
 #include <vector>
+#include <algorithm>
 #include <autoGradEngine/node.h>
 
+/**
+ * A contiguous run of parameters together with their gradients. Modules that store their parameters densely expose
+ * them as a few large blocks, which lets the optimizer and the trainer update them with flat loops.
+ */
+template<typename Scalar>
+struct BasicParameterBlock {
+    Scalar *data;
+    Scalar *grad;
+    size_t size;
+};
+
+using ParameterBlock = BasicParameterBlock<double>;
+
+/**
+ * Sends the gradients of a set of parameter blocks to a separate buffer on the current thread, for as long as the
+ * redirect lives. The buffer is laid out like the blocks, one after the other. Data-parallel training gives every
+ * worker its own buffer, so that workers can run backward passes at the same time without racing on the gradients
+ * of the shared parameters. Modules resolve their gradient pointers through resolve() when they build a graph.
+ * There is one active redirect per scalar type.
+ */
+template<typename Scalar>
+class BasicGradientRedirect {
+    const std::vector<BasicParameterBlock<Scalar> > &blocks;
+    Scalar *buffer;
+    BasicGradientRedirect *previous;
+
+    static BasicGradientRedirect *&activeSlot() {
+        thread_local BasicGradientRedirect *active = nullptr;
+        return active;
+    }
+
+public:
+    BasicGradientRedirect(const std::vector<BasicParameterBlock<Scalar> > &blocks, Scalar *buffer)
+        : blocks(blocks), buffer(buffer), previous(activeSlot()) {
+        activeSlot() = this;
+    }
+
+    ~BasicGradientRedirect() {
+        activeSlot() = previous;
+    }
+
+    BasicGradientRedirect(const BasicGradientRedirect &) = delete;
+
+    BasicGradientRedirect &operator=(const BasicGradientRedirect &) = delete;
+
+    /**
+     * @param grad - A pointer into the gradients of a parameter block
+     * @return The matching location in the buffer of the active redirect, or @p grad itself if there is none or the
+     * pointer does not belong to any of its blocks
+     */
+    static Scalar *resolve(Scalar *grad) {
+        const BasicGradientRedirect *redirect = activeSlot();
+        if (!redirect) return grad;
+
+        size_t offset = 0;
+        for (const BasicParameterBlock<Scalar> &block: redirect->blocks) {
+            if (grad >= block.grad && grad < block.grad + block.size) {
+                return redirect->buffer + offset + static_cast<size_t>(grad - block.grad);
+            }
+            offset += block.size;
+        }
+        return grad;
+    }
+};
+
+using GradientRedirect = BasicGradientRedirect<double>;
+
 /**
  * Module is a virtual class that serves as an interface for the Network class, enforcing the implementation of
  * the parameters() and clear_gradients() methods, which are important in the ability to access the parameters and
- * reset their gradients.
+ * reset their gradients. Like the rest of the network components, it is a template over the scalar type of the
+ * parameters, and Module is the double precision one.
  */
-class Module {
+template<typename Scalar>
+class BasicModule {
 public:
-    virtual ~Module() = default;
+    virtual ~BasicModule() = default;
 
-    virtual std::vector<Node *> parameters() {
+    virtual std::vector<BasicNode<Scalar> *> parameters() {
         return {};
     }
 
+    /**
+     * @return The parameters of the module as contiguous blocks. By default every parameter node is a block of its
+     * own, modules with dense storage override it.
+     */
+    virtual std::vector<BasicParameterBlock<Scalar> > parameterBlocks() {
+        std::vector<BasicParameterBlock<Scalar> > blocks;
+        for (BasicNode<Scalar> *p: parameters()) {
+            if (p) blocks.push_back(BasicParameterBlock<Scalar>{&p->data, &p->grad, 1});
+        }
+        return blocks;
+    }
+
     // Clears all the gradients of the parameters so that they are ready for the next backward pass
-    void clearGradients() {
-        for (Node *p: parameters()) {
-            if (p) p->grad = 0.0;
+    virtual void clearGradients() {
+        for (const BasicParameterBlock<Scalar> &block: parameterBlocks()) {
+            std::fill(block.grad, block.grad + block.size, Scalar(0));
         }
     }
 };
 
+using Module = BasicModule<double>;
 
 #endif //MODULE_H
@@ -4,38 +4,66 @@
 #include <nnComponents/layer.h>
 #include <nnComponents/neuron.h>
 #include <utils/serialization/modelSerializer.h>
+#include <utils/serialization/binaryModelFile.h>
+#include <utils/datasets/dataTable.h>
 
 /**
  * The network class provides the user with the right amount of flexibility to customize their own Multi-Layer Perceptron,
  * train it with the desired training parameters, save it a in a binary file and finally use it to make inferences.
+ *
+ * The network computes in its scalar type from end to end: parameters, activations and gradients. Network is the double
+ * precision one, and BasicNetwork<float> trains and serves with half the memory traffic. Samples are given as double
+ * and rounded to the scalar type on their way in.
  */
-class Network : public Module {
+template<typename Scalar>
+class BasicNetwork : public BasicModule<Scalar> {
 protected:
     std::vector<std::pair<int, Activation> > networkSpecs;
-    std::vector<Layer> layers;
+    std::vector<BasicLayer<Scalar> > layers;
+    BasicInferenceEngine<Scalar> engine;
+    int trainingWorkers = 1;
+    bool mixedPrecisionTraining = false;
+    bool seededTraining = false;
+    uint64_t trainingSeed = 0;
+
+    /**
+     * @return The inference engine of the network, bound to the current layers. Predictions made through it read
+     * the parameter values directly and do not allocate any nodes.
+     */
+    BasicInferenceEngine<Scalar> &inferenceEngine() {
+        engine.bind(layerViews());
+        return engine;
+    }
 
 public:
-    Network() = default;
+    BasicNetwork() = default;
 
     /**
      * @brief Creates the default network with ReLU activation function
      *
      * @param networkSpecs - holds information about the size and type of each layer
      */
-    explicit Network(const std::vector<std::pair<int, Activation> > &networkSpecs) : networkSpecs(networkSpecs) {
+    explicit BasicNetwork(const std::vector<std::pair<int, Activation> > &networkSpecs) : networkSpecs(networkSpecs) {
         for (size_t i = 0; i < networkSpecs.size() - 1; i++) {
             layers.emplace_back(networkSpecs.at(i).first, networkSpecs.at(i + 1).first, networkSpecs.at(i + 1).second);
         }
     }
 
+    /**
+     * @return The number of features of a sample, which is the size of the input layer
+     */
+    size_t inputSize() const {
+        return networkSpecs.empty() ? 0 : static_cast<size_t>(networkSpecs.front().first);
+    }
+
     /**
      * @brief Performs the forward-passing functionality of the network
      *
      * @param inputVector
      * @return A vector of Node object pointers that point to the activations of the output layer
      */
-    virtual std::vector<Node *> operator()(const std::vector<Node *> &inputVector) {
-        std::vector<Node *> x = inputVector;
+    virtual std::vector<BasicNode<Scalar> *> operator()(const std::vector<BasicNode<Scalar> *> &inputVector) {
+        std::vector<BasicNode<Scalar> *> x = inputVector;
         for (auto &layer: layers) {
             // The output vector of a layer becomes the input vector of the other
             x = layer(x);
@@ -43,14 +71,70 @@ public:
         return x;
     }
 
+    /**
+     * @brief Performs the forward pass on tensors, so that every layer is evaluated with a handful of kernel calls
+     * instead of a graph of scalar nodes.
+     *
+     * @param inputBatch - A (batch x inputs) tensor holding one sample per row
+     * @return A (batch x outputs) tensor with the activations of the output layer
+     */
+    virtual BasicTensor<Scalar> *operator()(BasicTensor<Scalar> *inputBatch) {
+        BasicTensor<Scalar> *x = inputBatch;
+        for (auto &layer: layers) {
+            x = layer(x);
+        }
+        return x;
+    }
+
+    /**
+     * @brief Performs the forward pass but stops before the activation of the output layer, so that the loss can fuse
+     * that activation (sigmoid or softmax) with the cross-entropy.
+     *
+     * @param inputVector
+     * @return A vector of Node object pointers that point to the weighted sums of the output layer
+     */
+    std::vector<BasicNode<Scalar> *> logits(const std::vector<BasicNode<Scalar> *> &inputVector) {
+        std::vector<BasicNode<Scalar> *> x = inputVector;
+        for (size_t i = 0; i + 1 < layers.size(); ++i) {
+            x = layers.at(i)(x);
+        }
+        return layers.empty() ? x : layers.back().weightedSums(x);
+    }
+
+    /**
+     * @brief Performs the tensor forward pass but stops before the activation of the output layer.
+     *
+     * @param inputBatch - A (batch x inputs) tensor holding one sample per row
+     * @return A (batch x outputs) tensor with the weighted sums of the output layer
+     */
+    BasicTensor<Scalar> *logits(BasicTensor<Scalar> *inputBatch) {
+        BasicTensor<Scalar> *x = inputBatch;
+        for (size_t i = 0; i + 1 < layers.size(); ++i) {
+            x = layers.at(i)(x);
+        }
+        return layers.empty() ? x : layers.back().weightedSums(x);
+    }
+
+    /**
+     * @return A read-only view of every layer, in order, as consumed by the InferenceEngine
+     */
+    std::vector<BasicDenseLayerView<Scalar> > layerViews() const {
+        std::vector<BasicDenseLayerView<Scalar> > views;
+        views.reserve(layers.size());
+        for (const auto &layer: layers) {
+            views.push_back(layer.denseView());
+        }
+        return views;
+    }
+
     /**
      * @brief Flattens all the parameters of the network into a single one-dimensional vector.
      *
      * @return A vector of Node object pointers that point to the parameters of the network
      */
-    std::vector<Node *> parameters() override {
+    std::vector<BasicNode<Scalar> *> parameters() override {
         // Flattens all the parameters of a layer so that they are accessible through this vector
-        std::vector<Node *> params;
+        std::vector<BasicNode<Scalar> *> params;
         for (auto &layer: layers) {
             auto layerParameters = layer.parameters();
             params.insert(params.end(), layerParameters.begin(), layerParameters.end());
@@ -58,6 +142,24 @@ public:
         return params;
     }
 
+    /**
+     * @return The weight matrix and bias vector of every layer, in the same order as parameters()
+     */
+    std::vector<BasicParameterBlock<Scalar> > parameterBlocks() override {
+        std::vector<BasicParameterBlock<Scalar> > blocks;
+        for (auto &layer: layers) {
+            auto layerBlocks = layer.parameterBlocks();
+            blocks.insert(blocks.end(), layerBlocks.begin(), layerBlocks.end());
+        }
+        return blocks;
+    }
+
+    void clearGradients() override {
+        for (auto &layer: layers) {
+            layer.clearGradients();
+        }
+    }
+
     /**
      * @brief Returns a string that contains information about the types of the layers that
      * comprise the network along with the size of each layer.
@@ -73,6 +175,28 @@ public:
         return s + "]";
     }
 
+    /**
+     * @brief Sets the number of threads that train() uses, see Trainer::setWorkers. Zero uses every hardware thread.
+     */
+    void setTrainingWorkers(const int count) {
+        trainingWorkers = count;
+    }
+
+    /**
+     * @brief Makes train() keep double precision master weights and scale the loss, see Trainer::setMixedPrecision.
+     */
+    void setMixedPrecisionTraining(const bool enable) {
+        mixedPrecisionTraining = enable;
+    }
+
+    /**
+     * @brief Makes train() split the data and order the samples of every epoch reproducibly, see Trainer::setSeed.
+     */
+    void setTrainingSeed(const uint64_t seed) {
+        seededTraining = true;
+        trainingSeed = seed;
+    }
+
     /**
      * @brief Provides training logic
      *
@@ -81,8 +205,7 @@ public:
      * @param batchSize - The amount of samples processed before we have an optimizer step
      * @param dataset - The data that the network is going to use to train
      */
-    virtual void train(double learningRate, int epochs, int batchSize,
-                       std::vector<std::pair<std::vector<double>, double> > &dataset) = 0;
+    virtual void train(double learningRate, int epochs, int batchSize, const DataTable &dataset) = 0;
 
 
     /**
@@ -91,7 +214,49 @@ public:
      * @param input - The input vector tha goes into the model to make inferences
      * @return Returns the number of the predicted category
      */
-    virtual int predict(std::vector<double> &input) = 0;
+    virtual int predict(const std::vector<double> &input) = 0;
+
+    /**
+     * @brief Scores a whole matrix of samples in one batched pass over plain buffers, without building any graph.
+     *
+     * @param features - A (rows x inputs) row-major matrix with one sample per row
+     * @param rows - The number of samples
+     * @param probabilities - A (rows x outputs) row-major matrix that receives the output of the network for every
+     * sample. Networks whose output layer is not a probability already (like the logits of a MultiClassClassifier)
+     * turn it into one.
+     * @param pool - An optional thread pool that the rows are spread across
+     */
+    virtual void predictProbaBatch(const Scalar *features, const size_t rows, Scalar *probabilities,
+                                   ThreadPool *pool = nullptr) {
+        inferenceEngine().forwardBatch(features, rows, probabilities, pool);
+    }
+
+    /**
+     * @brief Predicts the class of every row of a feature matrix. Networks with a single output use a threshold of
+     * 0.5, networks with several outputs pick the largest one.
+     *
+     * @param features - A (rows x inputs) row-major matrix with one sample per row
+     * @param rows - The number of samples
+     * @param classes - Receives the predicted class of every sample
+     * @param pool - An optional thread pool that the rows are spread across
+     */
+    virtual void predictBatch(const Scalar *features, const size_t rows, int *classes, ThreadPool *pool = nullptr) {
+        const size_t outputs = inferenceEngine().outputSize();
+        const size_t tile = 4096;
+        std::vector<Scalar> scores(std::min(rows, tile) * outputs);
+
+        // The rows are scored a tile at a time, so the buffer of scores does not grow with the input
+        for (size_t begin = 0; begin < rows; begin += tile) {
+            const size_t count = std::min(tile, rows - begin);
+            engine.forwardBatch(features + begin * engine.inputSize(), count, scores.data(), pool);
+            for (size_t r = 0; r < count; ++r) {
+                const Scalar *row = scores.data() + r * outputs;
+                classes[begin + r] = outputs == 1
+                                         ? (row[0] >= 0.5 ? 1 : 0)
+                                         : static_cast<int>(std::max_element(row, row + outputs) - row);
+            }
+        }
+    }
 
     /**
      * @brief Provides sufficient information for the library to load a pre-trained model into memory
@@ -112,18 +277,26 @@ public:
      * inferences.
      *
      * @param filepath - Specifies that filepath where the binary file with the model specs will be saved
+     * @param format - The text format, or the binary one that can be mapped into memory, see MappedModel
      * @return returns True if the model was saved successfully and false otherwise.
      */
-    virtual bool saveModel(const std::string &filepath) {
-        const std::vector<Node *> params = this->parameters();
+    virtual bool saveModel(const std::string &filepath, const ModelFormat format = ModelFormat::TEXT) {
+        if (format == ModelFormat::BINARY) {
+            return binaryModel::save(layerViews(), filepath);
+        }
+
+        const std::vector<BasicNode<Scalar> *> params = this->parameters();
         const ModelMetadata metadata = getMetadata();
 
         return ModelSerializer::saveWithMetadata(params, metadata, filepath);
     }
 };
 
+using Network = BasicNetwork<double>;
+
 /// The overloading function of the operator << that calls the representation() method of the network for convenience
-inline std::ostream &operator<<(std::ostream &os, const Network &m) {
+template<typename Scalar>
+std::ostream &operator<<(std::ostream &os, const BasicNetwork<Scalar> &m) {
     return os << m.representation();
 }
 
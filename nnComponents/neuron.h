@@ -1,6 +1,7 @@
 #ifndef NEURON_H
 #define NEURON_H
 #include <random>
+#include <stdexcept>
 #include <nnComponents/module.h>
 #include <nnComponents/activations/sigmoidNode.h>
 #include "activations/relu.h"
@@ -15,24 +16,41 @@ enum class Activation {
     SOFTMAX
 };
 
+/**
+ * @return The name of the activation function, used when printing neurons and layers
+ */
+inline std::string activationName(const Activation activation) {
+    switch (activation) {
+        case Activation::RELU: return "ReLU";
+        case Activation::SIGMOID: return "Sigmoid";
+        case Activation::LINEAR: return "Linear";
+        case Activation::INPUT: return "Input";
+        case Activation::SOFTMAX: return "Softmax";
+    }
+    return "";
+}
+
 /**
  * Neurons get a set of inputs, they calculate the weighted sum and then run it through
  * an activation function to produce one of the elements of the output vector of a layer. They are the gears that
  * spin the mechanism of a Multi-Layered Perceptron. 
  */
-class Neuron final : public Module {
-    std::vector<Node *> weights;
-    Node *bias;
+template<typename Scalar>
+class BasicNeuron final : public BasicModule<Scalar> {
+    std::vector<BasicNode<Scalar> *> weights;
+    BasicNode<Scalar> *bias;
     Activation activation;
 
 public:
-    explicit Neuron(int numberOfInputs, const Activation act = Activation::RELU)
-        : bias(new Node(generate_bias())), activation(act) {
+    explicit BasicNeuron(int numberOfInputs, const Activation act = Activation::RELU)
+        : bias(nullptr), activation(act) {
+        // Parameters outlive every training step, so they never go into the arena of an open GraphScope
+        HeapScope heapScope;
         weights.reserve(numberOfInputs);
         for (int i = 0; i < numberOfInputs; ++i) {
-            weights.push_back(new Node(generate_weight(numberOfInputs)));
+            weights.push_back(new BasicNode<Scalar>(static_cast<Scalar>(generate_weight(numberOfInputs))));
         }
-        bias = new Node(0.0);
+        bias = new BasicNode<Scalar>(Scalar(0));
     }
 
     /**
@@ -41,12 +59,11 @@ public:
      * @param inputVector - The input Nodes that are connected to the neuron, which in our case consist of all the neurons from the previous layer
      * @return - Returns the activation
      */
-    Node *operator()(const std::vector<Node *> &inputVector) {
-        Node *weightedSum = bias;
-
-        for (size_t i = 0; i < weights.size(); ++i) {
-            weightedSum = (*weightedSum) + *((*weights.at(i)) * (*inputVector.at(i)));
+    BasicNode<Scalar> *operator()(const std::vector<BasicNode<Scalar> *> &inputVector) {
+        if (inputVector.size() < weights.size()) {
+            throw std::out_of_range("Neuron received fewer inputs than it has weights");
         }
+        BasicNode<Scalar> *weightedSum = BasicNode<Scalar>::weightedSum(weights, inputVector, bias);
 
         switch (activation) {
             case Activation::RELU:
@@ -62,33 +79,23 @@ public:
      * 
      * @return - Returns a list of parameters for a neuron which include all the weights and biases.
      */
-    std::vector<Node *> parameters() override {
-        std::vector<Node *> params = weights;
+    std::vector<BasicNode<Scalar> *> parameters() override {
+        std::vector<BasicNode<Scalar> *> params = weights;
         params.push_back(bias);
         return params;
     }
 
     std::string representation() const {
-        std::string act_str;
-        switch (activation) {
-            case Activation::RELU: act_str = "ReLU";
-                break;
-            case Activation::SIGMOID: act_str = "Sigmoid";
-                break;
-            case Activation::LINEAR: act_str = "Linear";
-                break;
-            case Activation::INPUT: act_str = "Input";
-                break;
-            case Activation::SOFTMAX: act_str = "Softmax";
-                break;
-        }
-        return act_str + "Neuron(" + std::to_string(weights.size()) + ")";
+        return activationName(activation) + "Neuron(" + std::to_string(weights.size()) + ")";
     }
 };
 
-inline std::ostream &operator<<(std::ostream &os, const Neuron &n) {
+template<typename Scalar>
+std::ostream &operator<<(std::ostream &os, const BasicNeuron<Scalar> &n) {
     return os << n.representation();
 }
 
+using Neuron = BasicNeuron<double>;
+
 
 #endif //NEURON_H
@@ -2,16 +2,21 @@
 #define SGD_H
 #include <vector>
 #include <autoGradEngine/node.h>
+#include <nnComponents/module.h>
 
 /**
  *  This function defines the methods that optimize the parameters of a model based on their partial derivatives to
  *  the loss function. This way we aim to minimize loss and gain accuracy so that we can put our model to use.
+ *
+ *  The optimizer works on the parameters of one scalar type, SGD on double ones. The learning rate is always a double
+ *  and is rounded to the scalar type when it is applied.
  */
-class SGD {
+template<typename Scalar>
+class BasicSGD {
     double learningRate;
 
 public:
-    explicit SGD(const double lr = 0.01) : learningRate(lr) {
+    explicit BasicSGD(const double lr = 0.01) : learningRate(lr) {
     }
 
     /**
@@ -20,15 +25,86 @@ public:
      *
      * @param parameters - The parameters of a model
      */
-    void step(std::vector<Node *> &parameters) const {
-        for (Node *param: parameters) {
+    void step(std::vector<BasicNode<Scalar> *> &parameters) const {
+        const Scalar rate = static_cast<Scalar>(learningRate);
+        for (BasicNode<Scalar> *param: parameters) {
             if (param) {
                 // Update: param = param - learning_rate * gradient
-                param->data -= learningRate * param->grad;
+                param->data -= rate * param->grad;
             }
         }
     }
 
+    /**
+     * @brief Same update as above, applied to dense parameter blocks with one flat loop per block.
+     *
+     * @param blocks - The parameter blocks of a model
+     */
+    void step(const std::vector<BasicParameterBlock<Scalar> > &blocks) const {
+        const Scalar rate = static_cast<Scalar>(learningRate);
+        for (const BasicParameterBlock<Scalar> &block: blocks) {
+            for (size_t i = 0; i < block.size; ++i) {
+                block.data[i] -= rate * block.grad[i];
+            }
+        }
+    }
+
+    /**
+     * @brief Mixed precision update. The step is applied to a master copy of the parameters in a higher precision,
+     * and the parameters become the rounded master weights, so updates that are too small to change a parameter in its
+     * own precision still add up over many steps.
+     *
+     * @param master - The master weights, laid out like @p blocks one after the other
+     * @param blocks - The parameter blocks of a model, whose values are overwritten
+     * @param gradientScale - A factor applied to every gradient, for example one over the loss scale
+     */
+    template<typename Master>
+    void step(Master *master, const std::vector<BasicParameterBlock<Scalar> > &blocks,
+              const double gradientScale) const {
+        const Master rate = static_cast<Master>(learningRate * gradientScale);
+        for (const BasicParameterBlock<Scalar> &block: blocks) {
+            for (size_t i = 0; i < block.size; ++i) {
+                master[i] -= rate * static_cast<Master>(block.grad[i]);
+                block.data[i] = static_cast<Scalar>(master[i]);
+            }
+            master += block.size;
+        }
+    }
+
+    /**
+     * @brief Lock-free update for asynchronous (Hogwild) training, where several threads update the same parameters at
+     * the same time. The update itself reads and writes every parameter with relaxed atomic operations on GCC and
+     * Clang; other compilers use plain accesses. The forward and backward passes of the other threads still read the
+     * parameters with plain loads, though, so this is the benign race of Hogwild and not race free in the sense of the
+     * C++ memory model: it relies on aligned loads and stores of a float or a double never tearing, as on x86, and a
+     * reader may see a value from before or after an update. Updates of different threads can also interleave, and one
+     * of them may occasionally be lost. Parameters with a zero gradient are not touched at all, which keeps threads
+     * that train on sparse inputs from writing to the same cache lines.
+     *
+     * @param blocks - The shared parameter blocks of a model
+     * @param gradients - The gradients of the calling thread, laid out like @p blocks one after the other
+     * @param scale - A factor applied to every gradient, for example one over the number of samples they sum up
+     */
+    void stepAsynchronous(const std::vector<BasicParameterBlock<Scalar> > &blocks, const Scalar *gradients,
+                          const double scale = 1.0) const {
+        const Scalar rate = static_cast<Scalar>(learningRate * scale);
+        for (const BasicParameterBlock<Scalar> &block: blocks) {
+            for (size_t i = 0; i < block.size; ++i) {
+                const Scalar gradient = gradients[i];
+                if (gradient == 0) continue;
+#if defined(__GNUC__) || defined(__clang__)
+                Scalar value;
+                __atomic_load(block.data + i, &value, __ATOMIC_RELAXED);
+                value -= rate * gradient;
+                __atomic_store(block.data + i, &value, __ATOMIC_RELAXED);
+#else
+                block.data[i] -= rate * gradient;
+#endif
+            }
+            gradients += block.size;
+        }
+    }
+
     // Getters and setters for the learning rate
     void setLearningRate(const double lr) {
         learningRate = lr;
@@ -39,4 +115,6 @@ public:
     }
 };
 
+using SGD = BasicSGD<double>;
+
 #endif //SGD_H
@@ -0,0 +1,81 @@
+#ifndef LOSSSCALER_H
+#define LOSSSCALER_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <nnComponents/module.h>
+
+/**
+ * Loss scaling for mixed precision training. Small gradients underflow to zero in a low precision, so the backward pass
+ * starts from the loss multiplied by a large scale, and the gradients are divided by it again before the update.
+ *
+ * With dynamic scaling, a step whose scaled gradients overflowed is skipped and the scale is halved, and after
+ * growthInterval finite steps in a row the scale is doubled again, so it stays close to the largest one that fits. A
+ * static scaler keeps its scale and only skips the steps that overflowed.
+ */
+class LossScaler {
+    double scale;
+    bool dynamic;
+    size_t growthInterval;
+    size_t finiteSteps;
+    size_t skippedSteps;
+
+public:
+    /**
+     * @param initialScale - The factor the loss is multiplied by. 1 disables the scaling.
+     * @param dynamic - Whether the scale adapts to overflows
+     * @param growthInterval - The number of finite steps in a row after which a dynamic scale is doubled
+     */
+    explicit LossScaler(const double initialScale = 65536.0, const bool dynamic = true,
+                        const size_t growthInterval = 2000)
+        : scale(initialScale), dynamic(dynamic), growthInterval(std::max<size_t>(1, growthInterval)), finiteSteps(0),
+          skippedSteps(0) {
+    }
+
+    double getScale() const {
+        return scale;
+    }
+
+    /**
+     * @return The number of steps that were skipped because their gradients overflowed
+     */
+    size_t getSkippedSteps() const {
+        return skippedSteps;
+    }
+
+    /**
+     * @brief Records the outcome of a step and adapts the scale of the next one.
+     *
+     * @param finite - Whether every scaled gradient of the step was finite
+     * @return - Whether the step can be applied
+     */
+    bool update(const bool finite) {
+        if (!finite) {
+            ++skippedSteps;
+            finiteSteps = 0;
+            if (dynamic) scale = std::max(1.0, scale * 0.5);
+            return false;
+        }
+        if (dynamic && ++finiteSteps == growthInterval) {
+            scale *= 2.0;
+            finiteSteps = 0;
+        }
+        return true;
+    }
+
+    /**
+     * @return Whether every gradient of @p blocks is finite
+     */
+    template<typename Scalar>
+    static bool gradientsFinite(const std::vector<BasicParameterBlock<Scalar> > &blocks) {
+        for (const BasicParameterBlock<Scalar> &block: blocks) {
+            for (size_t i = 0; i < block.size; ++i) {
+                if (!std::isfinite(block.grad[i])) return false;
+            }
+        }
+        return true;
+    }
+};
+
+#endif //LOSSSCALER_H
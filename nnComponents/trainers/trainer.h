@@ -6,17 +6,63 @@
 #include <vector>
 #include <functional>
 #include <autoGradEngine/node.h>
+#include <autoGradEngine/tensor.h>
+#include <autoGradEngine/compiledGraph.h>
 #include <nnComponents/optimizers/SGD.h>
+#include <nnComponents/optimizers/lossScaler.h>
 #include "utils/helperFunctions.h"
 #include <matplot/matplot.h>
 #include <array>
-
-using DatasetFormat = std::vector<std::pair<std::vector<double>, double> >;
-
-class Trainer {
-    Network *network;
-    std::function<Node*(const std::vector<Node *> &, double)> lossFunction;
-    SGD optimizer;
+#include <stdexcept>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <numeric>
+#include <random>
+#include <utils/threadPool.h>
+#include <utils/alignedAllocator.h>
+#include <utils/datasets/dataTable.h>
+#include <utils/datasets/streamingDataset.h>
+#include <utils/datasets/batchProducer.h>
+
+template<typename Scalar>
+using BasicTensorLossFunction = std::function<BasicTensor<Scalar>*(BasicTensor<Scalar> *, const std::vector<double> &)>;
+using TensorLossFunction = BasicTensorLossFunction<double>;
+
+template<typename Scalar>
+class BasicNetwork;
+
+/**
+ * The training driver of a network. It is a template over the scalar type of the network it trains, and Trainer is
+ * the double precision one. Datasets always hold double features, which are rounded to the scalar type of the network
+ * when a sample or a batch enters the graph.
+ *
+ * The trainer never copies the samples of a dataset: the splits and the mini-batches are DatasetViews of the table
+ * passed to train().
+ */
+template<typename Scalar>
+class BasicTrainer {
+    BasicNetwork<Scalar> *network;
+    std::function<BasicNode<Scalar>*(const std::vector<BasicNode<Scalar> *> &, double)> lossFunction;
+    BasicTensorLossFunction<Scalar> tensorLossFunction;
+    BasicSGD<Scalar> optimizer;
+    GraphArena graphArena;
+    bool compileSteps;
+    bool lossOnLogits;
+    int workers;
+    bool asynchronous;
+    size_t maxStaleness;
+    size_t staleUpdates;
+    std::unique_ptr<ThreadPool> pool;
+    std::vector<AlignedVector<Scalar> > workerGradients;
+    std::map<double, BasicCompiledGraph<Scalar> > compiledSteps;
+    bool mixedPrecision;
+    LossScaler lossScaler;
+    std::vector<double> masterWeights;
+    uint64_t seed;
+    bool reshuffle;
+    size_t prefetchDepth;
+    std::unique_ptr<BasicBatchProducer<Scalar> > batchProducer;
     int epochs;
     int batchSize;
     int printEvery;
@@ -32,18 +78,28 @@ public:
      * @param loss_fn - loss function that computes loss given predictions and target
      * @param learningRate - learning rate for SGD optimizer
      * @param epochsNum - number of training epochs
-     * @param batchSize - batch size for gradient accumulation
+     * @param batchSize - number of samples per optimizer step (and per forward pass in batched mode)
      * @param printFrequency - print loss every N epochs (default: epochs/10)
      */
-    Trainer(Network *net,
-            const std::function<Node*(const std::vector<Node *> &, double)> &loss_fn,
-            const double learningRate = 0.01,
-            const int epochsNum = 100,
-            const int batchSize = 32,
-            const int printFrequency = -1)
+    BasicTrainer(BasicNetwork<Scalar> *net,
+                 const std::function<BasicNode<Scalar>*(const std::vector<BasicNode<Scalar> *> &, double)> &loss_fn,
+                 const double learningRate = 0.01,
+                 const int epochsNum = 100,
+                 const int batchSize = 32,
+                 const int printFrequency = -1)
         : network(net),
           lossFunction(loss_fn),
           optimizer(learningRate),
+          compileSteps(false),
+          lossOnLogits(false),
+          workers(1),
+          asynchronous(false),
+          maxStaleness(0),
+          staleUpdates(0),
+          mixedPrecision(false),
+          seed(std::random_device()()),
+          reshuffle(true),
+          prefetchDepth(3),
           epochs(epochsNum),
           batchSize(batchSize),
           verbose(true) {
@@ -80,6 +136,40 @@ public:
         batchSize = std::max(1, size);
     }
 
+    /**
+     * @brief Sets the seed of the split into training, validation and test data and of the order of the samples in
+     * every epoch, so that a run can be reproduced. Without it, the seed is drawn from std::random_device.
+     */
+    void setSeed(const uint64_t value) {
+        seed = value;
+    }
+
+    /**
+     * @return The seed of the next call to train()
+     */
+    uint64_t getSeed() const {
+        return seed;
+    }
+
+    /**
+     * @brief Enables or disables a fresh random order of the training samples for every epoch (enabled by default).
+     * Only a list of row indices is shuffled, the samples are never moved.
+     */
+    void setReshuffle(const bool enable) {
+        reshuffle = enable;
+    }
+
+    /**
+     * @brief Sets the number of mini-batches in flight in batched and data-parallel mode. A producer thread gathers
+     * the next batches into a ring of @p depth buffers (at least 2) while the current one trains, so assembling a
+     * batch is not part of the training step. The default of 3 is triple buffering; 0 gathers every batch on the
+     * training thread instead.
+     */
+    void setBatchPrefetch(const size_t depth) {
+        prefetchDepth = depth;
+        batchProducer.reset();
+    }
+
     /**
      * @brief Enable or disable verbose output
      */
@@ -88,25 +178,127 @@ public:
     }
 
     /**
-     * @brief Computes the average accuracy of the model based on its predictions for the Training Set.
+     * @brief Switches the trainer to batched mode, where every mini-batch goes through the network as one
+     * (batch x features) tensor. The loss function receives the output tensor of the network and the targets of the
+     * samples it contains, and must return a 1x1 tensor holding the mean loss of the batch. Without it, the trainer
+     * builds a graph of scalar nodes for every sample.
+     */
+    void setTensorLossFunction(const BasicTensorLossFunction<Scalar> &loss_fn) {
+        tensorLossFunction = loss_fn;
+    }
+
+    /**
+     * @brief Sets the number of threads that train in data-parallel mode. Every mini-batch is split into one shard per
+     * worker; each worker runs the forward and backward pass of its shard into a gradient buffer of its own, the
+     * buffers are summed and a single optimizer step is applied. One worker (the default) trains on the calling thread
+     * only, and zero uses every hardware thread. Compiled steps always run on the calling thread.
+     */
+    void setWorkers(const int count) {
+        pool.reset();
+        workerGradients.clear();
+        workers = count == 0 ? static_cast<int>(std::max(1u, std::thread::hardware_concurrency())) : std::max(1, count);
+    }
+
+    /**
+     * @brief Switches the workers to asynchronous, Hogwild-style training. Instead of meeting after every mini-batch,
+     * each worker keeps pulling the next batchSize samples of the epoch, computes their gradients and immediately
+     * applies them to the shared parameters with SGD::stepAsynchronous, without any locks. Batch sizes of 1 give the
+     * classic Hogwild algorithm.
      *
-     * @param subset - The training set
-     * @return - The accuracy measure which is in the interval (0, 1)
+     * Staleness bound: every update takes the next value of a shared version counter right before it is applied. A
+     * worker remembers the version when it starts reading the parameters for a batch, and takes the next one with a
+     * compare-and-swap that fails once more than @p staleness other updates took theirs in between, in which case its
+     * gradients are dropped instead of applied (see getStaleUpdates()). So an applied gradient was computed on
+     * parameters that are at most @p staleness updates old. Zero picks twice the number of workers.
+     *
+     * @param enable - Whether the workers train asynchronously, it only has an effect with more than one worker
+     * @param staleness - The maximum number of updates a gradient may lag behind when it is applied
      */
-    double computeAccuracy(const DatasetFormat &subset) {
+    void setAsynchronous(const bool enable, const size_t staleness = 0) {
+        asynchronous = enable;
+        maxStaleness = staleness;
+    }
 
-        if (subset.empty()) return 0.0;
+    /**
+     * @return The number of asynchronous updates that were dropped for exceeding the staleness bound during the last
+     * call to train()
+     */
+    size_t getStaleUpdates() const {
+        return staleUpdates;
+    }
 
-        int correct = 0;
+    /**
+     * @brief Makes both loss functions receive the output of the network before the activation of its output layer
+     * (see Network::logits), for losses that fuse that activation, like BinaryCrossEntropyLoss::fromLogits.
+     */
+    void setLossOnLogits(const bool enable) {
+        lossOnLogits = enable;
+        compiledSteps.clear();
+    }
 
-        for (auto sample: subset) {
-            auto &inputs = sample.first;
-            double target = sample.second;
+    /**
+     * @brief Enables compiled training steps in per-sample mode. The forward pass, the loss and the backward pass are
+     * traced once and frozen into a CompiledGraph, which is then replayed for every sample without building a graph.
+     * Since the target is a constant of the traced loss, one program is compiled for every distinct target value.
+     * Compiled steps take precedence over the batched mode of setTensorLossFunction().
+     */
+    void setCompiled(const bool enable) {
+        compileSteps = enable;
+        compiledSteps.clear();
+    }
 
-            auto predictedClass = network->predict(inputs);
+    /**
+     * @brief Switches to mixed precision training. The forward and backward passes run in the scalar type of the
+     * network, typically float, while the optimizer updates a double precision master copy of the parameters and
+     * rounds the result back into the network. The backward pass starts from the loss multiplied by the scale of
+     * @p scaler so that small gradients do not underflow, and steps whose gradients overflowed are skipped. It applies
+     * to the synchronous modes only: asynchronous workers keep updating the shared parameters directly.
+     *
+     * @param enable - Whether to train in mixed precision
+     * @param scaler - The loss scaling, LossScaler(1.0, false) turns it off
+     */
+    void setMixedPrecision(const bool enable, const LossScaler &scaler = LossScaler()) {
+        mixedPrecision = enable;
+        lossScaler = scaler;
+        masterWeights.clear();
+    }
 
-            if (predictedClass == static_cast<int>(target)) {
-                correct++;
+    /**
+     * @return The loss scaler of the mixed precision mode, with its current scale and the number of skipped steps
+     */
+    const LossScaler &getLossScaler() const {
+        return lossScaler;
+    }
+
+    /**
+     * @brief Computes the average accuracy of the model based on its predictions for the Training Set. The samples
+     * are scored a tile at a time with Network::predictBatch, in place when the view is a contiguous block of the
+     * table.
+     *
+     * @param subset - The training set
+     * @return - The accuracy measure which is in the interval (0, 1)
+     * @throws std::invalid_argument - If the samples do not have as many features as the input layer
+     */
+    double computeAccuracy(const DatasetView &subset) {
+
+        if (subset.empty()) return 0.0;
+        if (subset.featureCount() != network->inputSize()) {
+            throw std::invalid_argument("The samples do not have as many features as the input layer");
+        }
+
+        const size_t tile = 4096;
+        AlignedVector<Scalar> buffer;
+        std::vector<int> predictedClasses(std::min(tile, subset.size()));
+        size_t correct = 0;
+
+        for (size_t begin = 0; begin < subset.size(); begin += tile) {
+            const size_t end = std::min(subset.size(), begin + tile);
+            network->predictBatch(helper::scalarRows(subset, begin, end, buffer), end - begin,
+                                  predictedClasses.data(), pool.get());
+            for (size_t i = begin; i < end; ++i) {
+                if (predictedClasses[i - begin] == static_cast<int>(subset.label(i))) {
+                    correct++;
+                }
             }
         }
 
@@ -114,22 +306,22 @@ public:
     }
 
     /*
-     * Splits the data into training data, validation data and test data.
+     * Splits the data into training data, validation data and test data. The splits are views of one permutation of
+     * the row indices, drawn from @p generator, so no sample is copied and a seed always gives the same split.
      ***/
-    static std::tuple<DatasetFormat, DatasetFormat, DatasetFormat> splitData(const DatasetFormat &dataset) {
-        DatasetFormat datasetCopy = dataset;
+    static std::tuple<DatasetView, DatasetView, DatasetView> splitData(const DataTable &dataset,
+                                                                       std::mt19937_64 &generator) {
         int trainingDatasetSize, validationDatasetSize;
         int datasetSize = static_cast<int>(dataset.size());
-        // We shuffle the dataset to make sure everything is random
-        std::random_device rd;
-        std::mt19937 g(rd());
-        std::shuffle(datasetCopy.begin(), datasetCopy.end(), g);
 
         if(datasetSize < 5) {
-            auto data = std::make_tuple(dataset, dataset, dataset);
+            auto data = std::make_tuple(DatasetView(dataset), DatasetView(dataset), DatasetView(dataset));
             return data;
         }
 
+        // We shuffle the row indices to make sure everything is random
+        const DatasetView shuffled = DatasetView(dataset).shuffled(generator);
+
         if (datasetSize < 100) {
             //Ratios 60%-20%-20%
             trainingDatasetSize = static_cast<int>(datasetSize * 0.6);
@@ -144,10 +336,11 @@ public:
             validationDatasetSize = static_cast<int>(datasetSize * 0.01);
         }
 
-        DatasetFormat trainingDataset(datasetCopy.begin() + 0, datasetCopy.begin() + trainingDatasetSize);
-        DatasetFormat validationDataset(datasetCopy.begin() + trainingDatasetSize,
-                                        datasetCopy.begin() + trainingDatasetSize + validationDatasetSize);
-        DatasetFormat testDataset(datasetCopy.begin() + trainingDatasetSize + validationDatasetSize, datasetCopy.end());
+        const size_t trainingEnd = static_cast<size_t>(trainingDatasetSize);
+        const size_t validationEnd = trainingEnd + static_cast<size_t>(validationDatasetSize);
+        DatasetView trainingDataset = shuffled.slice(0, trainingEnd);
+        DatasetView validationDataset = shuffled.slice(trainingEnd, validationEnd);
+        DatasetView testDataset = shuffled.slice(validationEnd, shuffled.size());
 
         auto data = std::make_tuple(trainingDataset, validationDataset, testDataset);
 
@@ -157,10 +350,10 @@ public:
     /**
      * @brief Train the network on the provided dataset
      *
-     * @param dataset - vector of (input_vector, target_label) pairs
+     * @param dataset - the samples, which must outlive the call
      * @return average loss after training
      */
-    void train(const DatasetFormat &dataset) {
+    void train(const DataTable &dataset) {
         if (dataset.empty()) {
             std::cout<<"Dataset cannot be empty";
         }
@@ -169,10 +362,15 @@ public:
             std::cout<<"Network pointer is null";
         }
 
-        const auto datasets = splitData(dataset);
-        const auto trainingDataset = std::get<0>(datasets);
-        const auto validationDataset = std::get<1>(datasets);
-        const auto testDataset = std::get<2>(datasets);
+        // The programs are traced against the current network and loss function
+        compiledSteps.clear();
+        staleUpdates = 0;
+
+        std::mt19937_64 generator(seed);
+        const auto datasets = splitData(dataset, generator);
+        const DatasetView &trainingDataset = std::get<0>(datasets);
+        const DatasetView &validationDataset = std::get<1>(datasets);
+        const DatasetView &testDataset = std::get<2>(datasets);
 
         std::vector<double> lossHistory;
         std::vector<double> accuracyHistory;
@@ -183,60 +381,16 @@ public:
             std::cout << "Training Data: " << trainingDataset.size()
                     << " | Validation Data: " << validationDataset.size()
                     << " | Test Data: " << testDataset.size() << std::endl;
-            std::cout << "Batch size: " << batchSize << std::endl;
+            std::cout << "Batch size: " << batchSize << " | Seed: " << seed << std::endl;
             std::cout << "------------------------------------------------" << std::endl;
         }
 
         double finalTrainingLoss = 0.0;
 
         for (int epoch = 0; epoch < epochs; ++epoch) {
-            double epochLoss = 0.0;
-            int sampleCount = 0;
-
-            // Accumulator for gradient averaging within a batch
-            std::vector<double> accumulatedGradients(network->parameters().size(), 0.0);
-
-            for (const auto &sample: trainingDataset) {
-                const auto &inputs = sample.first;
-                const double target = sample.second;
-
-                auto inputNodes = helper::createInputNodes(inputs);
-
-                // Forward pass
-                std::vector<Node *> predictions = (*network)(inputNodes);
-
-                // Compute loss
-                Node *loss = lossFunction(predictions, target);
-                epochLoss += loss->data;
-
-                // Backward pass
-                network->clearGradients();
-                loss->backward();
-
-                // Accumulate gradients
-                auto params = network->parameters();
-                for (size_t i = 0; i < params.size(); ++i) {
-                    accumulatedGradients.at(i) += params.at(i)->grad;
-                }
-
-                ++sampleCount;
-
-                // Update parameters when batch is full or at end of the training dataset
-                if (sampleCount % batchSize == 0 || sampleCount == static_cast<int>(trainingDataset.size())) {
-                    int batchSizeUsed = (sampleCount % batchSize == 0) ? batchSize : (sampleCount % batchSize);
-                    for (size_t i = 0; i < params.size(); ++i) {
-                        params.at(i)->grad = accumulatedGradients.at(i) / batchSizeUsed;
-                    }
-
-                    // Optimizer step
-                    optimizer.step(params);
-
-                    // Reset accumulator
-                    accumulatedGradients.assign(params.size(), 0.0);
-                }
-
-                helper::deleteInputNodes(inputNodes);
-            }
+            // Every epoch visits the training samples in a new order, which is a permutation of their row indices
+            const DatasetView epochDataset = reshuffle ? trainingDataset.shuffled(generator) : trainingDataset;
+            const double epochLoss = trainEpoch(epochDataset);
 
             finalTrainingLoss = epochLoss / static_cast<double>(trainingDataset.size());
             lossHistory.push_back(finalTrainingLoss);
@@ -267,6 +421,510 @@ public:
         printTrainingGraphs();
     }
 
+    /**
+     * @brief Trains the network on a dataset that is streamed from disk. Every epoch reads the stream once, and every
+     * chunk goes through the network batch by batch, in the same mode as in train(), while the next chunks are read in
+     * the background. A stream can not be split, so the held-out samples are passed separately.
+     *
+     * @param stream - The training samples. The seed of the trainer seeds the order of the samples within its chunks
+     * @param validation - Samples on which the accuracy is measured when progress is printed, may be empty
+     */
+    void train(StreamingDataset &stream, const DataTable &validation = DataTable()) {
+        if (!network) {
+            std::cout<<"Network pointer is null";
+        }
+
+        compiledSteps.clear();
+        staleUpdates = 0;
+        stream.setSeed(seed);
+        stream.setShuffle(reshuffle);
+
+        std::vector<double> lossHistory;
+
+        if (verbose) {
+            std::cout << "Training for " << epochs << " epochs on a stream..." << std::endl;
+            std::cout << "Chunk size: " << stream.chunkRows() << " | Buffers: " << stream.bufferCount()
+                    << " | Validation Data: " << validation.size() << std::endl;
+            std::cout << "Batch size: " << batchSize << " | Seed: " << seed << std::endl;
+            std::cout << "------------------------------------------------" << std::endl;
+        }
+
+        for (int epoch = 0; epoch < epochs; ++epoch) {
+            stream.startEpoch();
+            double epochLoss = 0.0;
+            size_t sampleCount = 0;
+            DatasetView chunk;
+            while (stream.nextChunk(chunk)) {
+                epochLoss += trainEpoch(chunk);
+                sampleCount += chunk.size();
+            }
+
+            const double finalTrainingLoss = sampleCount > 0 ? epochLoss / static_cast<double>(sampleCount) : 0.0;
+            lossHistory.push_back(finalTrainingLoss);
+
+            if (verbose && (epoch + 1) % printEvery == 0) {
+                std::cout << "Epoch " << std::setw(4) << (epoch + 1)
+                        << " | Loss: " << std::fixed << std::setprecision(6) << finalTrainingLoss;
+                if (!validation.empty()) {
+                    const double accuracy = computeAccuracy(validation);
+                    this->accuracyHistory.push_back(accuracy);
+                    std::cout << " | Accuracy: " << std::setprecision(2) << (accuracy * 100.0) << "%";
+                }
+                std::cout << std::endl;
+            }
+        }
+
+        if (verbose) {
+            std::cout << "\nTraining complete!" << std::endl;
+        }
+
+        this->lossHistory = lossHistory;
+        printTrainingGraphs();
+    }
+
+    /**
+     * @return The mean training loss of every epoch of the last call to train()
+     */
+    const std::vector<double> &getLossHistory() const {
+        return lossHistory;
+    }
+
+    /**
+     * @brief Runs one epoch over @p samples in the mode that the settings of the trainer select: asynchronous or
+     * data-parallel with several workers, batched with a tensor loss function, per sample otherwise.
+     *
+     * @return - The sum of the losses of all the samples
+     */
+    double trainEpoch(const DatasetView &samples) {
+        if (workers > 1 && !compileSteps && asynchronous) {
+            return trainEpochAsynchronous(samples);
+        }
+        if (workers > 1 && !compileSteps) {
+            return trainEpochParallel(samples);
+        }
+        if (tensorLossFunction && !compileSteps) {
+            return trainEpochBatched(samples);
+        }
+        return trainEpochPerSample(samples);
+    }
+
+    /**
+     * @brief Runs one epoch in batched mode: every mini-batch is gathered into a (batch x features) tensor, ahead of
+     * time by the batch producer (see setBatchPrefetch()), and goes through the network in a single forward and a
+     * single backward pass. The loss function averages over the batch, so the gradients that reach the parameters
+     * are already the batch average.
+     *
+     * @param trainingDataset - The samples of the epoch, in the order in which they are visited
+     * @return - The sum of the losses of all the samples
+     */
+    double trainEpochBatched(const DatasetView &trainingDataset) {
+        const std::vector<BasicParameterBlock<Scalar> > blocks = network->parameterBlocks();
+        if (mixedPrecision) syncMasterWeights(blocks);
+        BasicBatchProducer<Scalar> &batches = startBatches(trainingDataset);
+        double epochLoss = 0.0;
+
+        // The producer gathers the next batches while this one trains
+        while (BasicPreparedBatch<Scalar> *batch = batches.next()) {
+            // The whole graph of the batch lives in the arena and is released when the scope closes
+            GraphScope graphScope(graphArena);
+
+            // Forward pass, loss and backward pass
+            network->clearGradients();
+            BasicTensor<Scalar> *loss = tensorLossFunction(forward(batchTensor(*batch, 0, batch->rows)),
+                                                           batch->targets);
+            loss->backward(lossSeed());
+
+            // Optimizer step
+            optimizerStep(blocks);
+
+            epochLoss += loss->item() * static_cast<double>(batch->rows);
+        }
+
+        return epochLoss;
+    }
+
+    /**
+     * @brief Runs one epoch in per-sample mode: every sample builds its own graph of scalar nodes, and the gradients
+     * are accumulated until the batch is full.
+     *
+     * @param trainingDataset - The samples of the epoch, in the order in which they are visited
+     * @return - The sum of the losses of all the samples
+     */
+    double trainEpochPerSample(const DatasetView &trainingDataset) {
+        double epochLoss = 0.0;
+        int sampleCount = 0;
+
+        // Accumulator for gradient averaging within a batch, laid out like the parameter blocks of the network
+        const std::vector<BasicParameterBlock<Scalar> > blocks = network->parameterBlocks();
+        size_t parameterCount = 0;
+        for (const BasicParameterBlock<Scalar> &block: blocks) {
+            parameterCount += block.size;
+        }
+        std::vector<Scalar> accumulatedGradients(parameterCount, Scalar(0));
+        if (mixedPrecision) syncMasterWeights(blocks);
+        std::vector<double> inputs;
+
+        for (size_t sample = 0; sample < trainingDataset.size(); ++sample) {
+            inputs.assign(trainingDataset.features(sample),
+                          trainingDataset.features(sample) + trainingDataset.featureCount());
+            const double target = trainingDataset.label(sample);
+
+            network->clearGradients();
+            if (compileSteps) {
+                // Forward pass, loss and backward pass are a replay of the program for this target
+                epochLoss += compiledStepFor(inputs, target).run(inputs, lossSeed());
+            } else {
+                epochLoss += sampleStep(inputs, target, graphArena, lossSeed());
+            }
+
+            // Accumulate gradients
+            Scalar *accumulated = accumulatedGradients.data();
+            for (const BasicParameterBlock<Scalar> &block: blocks) {
+                for (size_t i = 0; i < block.size; ++i) {
+                    accumulated[i] += block.grad[i];
+                }
+                accumulated += block.size;
+            }
+
+            ++sampleCount;
+
+            // Update parameters when batch is full or at end of the training dataset
+            if (sampleCount % batchSize == 0 || sampleCount == static_cast<int>(trainingDataset.size())) {
+                int batchSizeUsed = (sampleCount % batchSize == 0) ? batchSize : (sampleCount % batchSize);
+                accumulated = accumulatedGradients.data();
+                for (const BasicParameterBlock<Scalar> &block: blocks) {
+                    for (size_t i = 0; i < block.size; ++i) {
+                        block.grad[i] = accumulated[i] / static_cast<Scalar>(batchSizeUsed);
+                    }
+                    accumulated += block.size;
+                }
+
+                // Optimizer step
+                optimizerStep(blocks);
+
+                // Reset accumulator
+                accumulatedGradients.assign(parameterCount, Scalar(0));
+            }
+        }
+
+        return epochLoss;
+    }
+
+    /**
+     * @brief Runs one epoch in data-parallel mode. Every mini-batch is split into contiguous shards, one per worker.
+     * A worker redirects the gradients of the network into its own buffer and runs its shard either as one tensor
+     * (batched mode) or sample by sample. The buffers are then summed, weighted so that the result is the average over
+     * the whole batch, and a single optimizer step is applied.
+     *
+     * @param trainingDataset - The samples of the epoch, in the order in which they are visited
+     * @return - The sum of the losses of all the samples
+     */
+    double trainEpochParallel(const DatasetView &trainingDataset) {
+        const std::vector<BasicParameterBlock<Scalar> > blocks = network->parameterBlocks();
+        const size_t parameterCount = prepareWorkers(blocks);
+        const size_t shardCount = pool->size();
+        const double lossGradientSeed = lossSeed();
+        if (mixedPrecision) syncMasterWeights(blocks);
+
+        const size_t datasetSize = trainingDataset.size();
+        const size_t batch = static_cast<size_t>(std::max(1, batchSize));
+        std::vector<double> shardLoss(shardCount);
+        std::vector<double> shardWeight(shardCount);
+        BasicBatchProducer<Scalar> *batches = tensorLossFunction ? &startBatches(trainingDataset) : nullptr;
+        double epochLoss = 0.0;
+
+        for (size_t begin = 0; begin < datasetSize; begin += batch) {
+            const size_t end = std::min(datasetSize, begin + batch);
+            const size_t rows = end - begin;
+            const size_t shards = std::min(shardCount, rows);
+            // In batched mode the shards are views of a batch that was gathered while the previous one trained
+            BasicPreparedBatch<Scalar> *prepared = batches ? batches->next() : nullptr;
+
+            pool->parallelFor(shards, [&](const size_t k) {
+                const size_t shardBegin = begin + k * rows / shards;
+                const size_t shardEnd = begin + (k + 1) * rows / shards;
+                Scalar *buffer = workerGradients.at(k).data();
+                std::fill(buffer, buffer + parameterCount, Scalar(0));
+
+                // The shard is weighted by its share of the batch
+                BasicGradientRedirect<Scalar> redirect(blocks, buffer);
+                double meanScale;
+                shardLoss.at(k) = shardStep(trainingDataset, shardBegin, shardEnd, lossGradientSeed, meanScale,
+                                            prepared);
+                shardWeight.at(k) = meanScale * static_cast<double>(shardEnd - shardBegin) / static_cast<double>(rows);
+            });
+
+            // Reduce the buffers into the gradients of the network, every worker summing a slice of the parameters
+            const size_t slice = (parameterCount + shardCount - 1) / shardCount;
+            pool->parallelFor(shardCount, [&](const size_t part) {
+                const size_t first = part * slice;
+                const size_t last = std::min(parameterCount, first + slice);
+                size_t offset = 0;
+                for (const BasicParameterBlock<Scalar> &block: blocks) {
+                    const size_t from = std::max(first, offset), to = std::min(last, offset + block.size);
+                    for (size_t i = from; i < to; ++i) {
+                        double sum = 0.0;
+                        for (size_t k = 0; k < shards; ++k) {
+                            sum += workerGradients[k][i] * shardWeight[k];
+                        }
+                        block.grad[i - offset] = static_cast<Scalar>(sum);
+                    }
+                    offset += block.size;
+                }
+            });
+
+            optimizerStep(blocks);
+
+            for (size_t k = 0; k < shards; ++k) {
+                epochLoss += shardLoss.at(k);
+            }
+        }
+
+        return epochLoss;
+    }
+
+    /**
+     * @brief Runs one epoch in asynchronous mode, see setAsynchronous(). The order in which the workers apply their
+     * updates depends on scheduling, so two runs with the same seed are not bitwise identical.
+     *
+     * @param trainingDataset - The samples of the epoch, in the order in which they are handed out
+     * @return - The sum of the losses of all the samples
+     */
+    double trainEpochAsynchronous(const DatasetView &trainingDataset) {
+        const std::vector<BasicParameterBlock<Scalar> > blocks = network->parameterBlocks();
+        const size_t parameterCount = prepareWorkers(blocks);
+        const size_t workerCount = pool->size();
+        const size_t datasetSize = trainingDataset.size();
+        const size_t batch = static_cast<size_t>(std::max(1, batchSize));
+        const size_t staleness = maxStaleness > 0 ? maxStaleness : 2 * workerCount;
+
+        std::atomic<size_t> nextSample(0);
+        std::atomic<size_t> version(0);
+        std::atomic<size_t> dropped(0);
+        std::vector<double> workerLoss(workerCount, 0.0);
+
+        pool->parallelFor(workerCount, [&](const size_t k) {
+            Scalar *buffer = workerGradients.at(k).data();
+            BasicGradientRedirect<Scalar> redirect(blocks, buffer);
+
+            for (size_t begin = nextSample.fetch_add(batch); begin < datasetSize; begin = nextSample.fetch_add(batch)) {
+                const size_t end = std::min(datasetSize, begin + batch);
+                std::fill(buffer, buffer + parameterCount, Scalar(0));
+
+                const size_t readVersion = version.load(std::memory_order_relaxed);
+                double meanScale;
+                workerLoss.at(k) += shardStep(trainingDataset, begin, end, 1.0, meanScale);
+
+                // Claim the next version before applying, and only while it is within the bound, so that two
+                // workers can not both pass the check and push the lag of one of them past it
+                size_t current = version.load(std::memory_order_relaxed);
+                bool claimed = false;
+                while (!claimed && current - readVersion <= staleness) {
+                    claimed = version.compare_exchange_weak(current, current + 1, std::memory_order_relaxed);
+                }
+                if (!claimed) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                optimizer.stepAsynchronous(blocks, buffer, meanScale);
+            }
+        });
+
+        staleUpdates += dropped.load();
+        double epochLoss = 0.0;
+        for (const double loss: workerLoss) {
+            epochLoss += loss;
+        }
+        return epochLoss;
+    }
+
+    /**
+     * @brief Starts the thread pool if needed and gives every worker a gradient buffer laid out like @p blocks.
+     *
+     * @return - The number of parameters in @p blocks
+     */
+    size_t prepareWorkers(const std::vector<BasicParameterBlock<Scalar> > &blocks) {
+        size_t parameterCount = 0;
+        for (const BasicParameterBlock<Scalar> &block: blocks) {
+            parameterCount += block.size;
+        }
+
+        if (!pool) pool.reset(new ThreadPool(static_cast<size_t>(workers)));
+        workerGradients.resize(pool->size());
+        for (auto &buffer: workerGradients) buffer.resize(parameterCount);
+        return parameterCount;
+    }
+
+    /**
+     * @brief Runs the forward and backward pass of the samples [begin, end) on the calling thread, as one tensor in
+     * batched mode or sample by sample otherwise. The gradients are added to the parameters, or to the buffer of the
+     * active GradientRedirect.
+     *
+     * @param dataset - The samples
+     * @param begin - The first sample of the shard
+     * @param end - One past the last sample of the shard
+     * @param lossGradientSeed - The gradient every loss starts its backward pass with, see lossSeed()
+     * @param meanScale - Receives the factor that turns the accumulated gradients into the mean over the shard
+     * @param prepared - The batch that holds the shard already gathered, if any
+     * @return - The sum of the losses of the samples
+     */
+    double shardStep(const DatasetView &dataset, const size_t begin, const size_t end, const double lossGradientSeed,
+                     double &meanScale, BasicPreparedBatch<Scalar> *prepared = nullptr) {
+        GraphArena &arena = GraphArena::forThread();
+        const size_t rows = end - begin;
+        if (tensorLossFunction) {
+            // The tensor loss already is the mean over the shard
+            GraphScope graphScope(arena);
+            std::vector<double> targets;
+            BasicTensor<Scalar> *inputs;
+            if (prepared) {
+                inputs = batchTensor(*prepared, begin - prepared->first, end - prepared->first);
+                targets.assign(prepared->targets.begin() + static_cast<std::ptrdiff_t>(begin - prepared->first),
+                               prepared->targets.begin() + static_cast<std::ptrdiff_t>(end - prepared->first));
+            } else {
+                inputs = gatherBatch(dataset, begin, end, targets);
+            }
+            BasicTensor<Scalar> *loss = tensorLossFunction(forward(inputs), targets);
+            loss->backward(lossGradientSeed);
+            meanScale = 1.0;
+            return loss->item() * static_cast<double>(rows);
+        }
+
+        double loss = 0.0;
+        std::vector<double> inputs;
+        for (size_t i = begin; i < end; ++i) {
+            inputs.assign(dataset.features(i), dataset.features(i) + dataset.featureCount());
+            loss += sampleStep(inputs, dataset.label(i), arena, lossGradientSeed);
+        }
+        meanScale = 1.0 / static_cast<double>(rows);
+        return loss;
+    }
+
+    /**
+     * @brief Starts preparing the mini-batches of @p samples, see setBatchPrefetch().
+     */
+    BasicBatchProducer<Scalar> &startBatches(const DatasetView &samples) {
+        if (!batchProducer) batchProducer.reset(new BasicBatchProducer<Scalar>(prefetchDepth));
+        batchProducer->start(samples, static_cast<size_t>(std::max(1, batchSize)));
+        return *batchProducer;
+    }
+
+    /**
+     * @brief A (rows x features) tensor over the rows [begin, end) of a prepared batch, without copying them.
+     */
+    static BasicTensor<Scalar> *batchTensor(BasicPreparedBatch<Scalar> &batch, const size_t begin, const size_t end) {
+        const size_t offset = begin * batch.cols;
+        return BasicTensor<Scalar>::view(end - begin, batch.cols, batch.features.data() + offset,
+                                         batch.gradients.data() + offset);
+    }
+
+    /**
+     * @brief Copies the samples [begin, end) into a (rows x features) tensor and their targets into @p targets.
+     */
+    static BasicTensor<Scalar> *gatherBatch(const DatasetView &dataset, const size_t begin, const size_t end,
+                                            std::vector<double> &targets) {
+        const size_t rows = end - begin;
+        auto inputBatch = new BasicTensor<Scalar>(rows, dataset.featureCount());
+        dataset.gather(begin, end, inputBatch->data);
+        targets.resize(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            targets[i] = dataset.label(begin + i);
+        }
+        return inputBatch;
+    }
+
+    /**
+     * @brief Builds the graph of a single sample, runs its backward pass and returns its loss. The gradients are added
+     * to whatever the parameters (or the active GradientRedirect) already hold, multiplied by @p lossGradientSeed.
+     */
+    double sampleStep(const std::vector<double> &inputs, const double target, GraphArena &arena,
+                      const double lossGradientSeed = 1.0) {
+        // Every node of this sample's graph lives in the arena and is released when the scope closes. The scope
+        // records the graph on a tape, so the backward pass replays it instead of sorting it
+        GraphScope graphScope(arena, true);
+        auto inputNodes = helper::createInputNodes<Scalar>(inputs);
+
+        // Forward pass
+        std::vector<BasicNode<Scalar> *> predictions = forward(inputNodes);
+
+        // Compute loss
+        BasicNode<Scalar> *loss = lossFunction(predictions, target);
+
+        // Backward pass
+        loss->backward(lossGradientSeed);
+        return loss->data;
+    }
+
+    /**
+     * @return The gradient the backward passes start from: the loss scale in mixed precision mode, 1 otherwise
+     */
+    double lossSeed() const {
+        return mixedPrecision ? lossScaler.getScale() : 1.0;
+    }
+
+    /**
+     * @brief Applies the optimizer to the gradients that @p blocks hold. In mixed precision mode the gradients are
+     * unscaled and the step goes through the master weights, or is skipped if the gradients overflowed.
+     */
+    void optimizerStep(const std::vector<BasicParameterBlock<Scalar> > &blocks) {
+        if (!mixedPrecision) {
+            optimizer.step(blocks);
+            return;
+        }
+        const double scale = lossScaler.getScale();
+        if (lossScaler.update(LossScaler::gradientsFinite(blocks))) {
+            optimizer.step(masterWeights.data(), blocks, 1.0 / scale);
+        }
+    }
+
+    /**
+     * @brief Brings the master weights in line with the parameters of @p blocks. A master weight that still rounds to
+     * its parameter keeps its extra precision, the others (on the first call, or after the parameters were changed
+     * outside of the trainer) are copied from the parameter.
+     */
+    void syncMasterWeights(const std::vector<BasicParameterBlock<Scalar> > &blocks) {
+        size_t parameterCount = 0;
+        for (const BasicParameterBlock<Scalar> &block: blocks) {
+            parameterCount += block.size;
+        }
+        if (masterWeights.size() != parameterCount) masterWeights.assign(parameterCount, 0.0);
+
+        double *master = masterWeights.data();
+        for (const BasicParameterBlock<Scalar> &block: blocks) {
+            for (size_t i = 0; i < block.size; ++i) {
+                if (static_cast<Scalar>(master[i]) != block.data[i]) master[i] = block.data[i];
+            }
+            master += block.size;
+        }
+    }
+
+    /**
+     * @brief The forward pass whose output is handed to the loss function
+     */
+    std::vector<BasicNode<Scalar> *> forward(const std::vector<BasicNode<Scalar> *> &inputNodes) {
+        return lossOnLogits ? network->logits(inputNodes) : (*network)(inputNodes);
+    }
+
+    BasicTensor<Scalar> *forward(BasicTensor<Scalar> *inputBatch) {
+        return lossOnLogits ? network->logits(inputBatch) : (*network)(inputBatch);
+    }
+
+    /**
+     * @brief Returns the compiled training step for @p target, tracing it with @p inputs as example on first use.
+     */
+    BasicCompiledGraph<Scalar> &compiledStepFor(const std::vector<double> &inputs, const double target) {
+        auto step = compiledSteps.find(target);
+        if (step == compiledSteps.end()) {
+            using Inputs = std::vector<BasicNode<Scalar> *>;
+            BasicCompiledGraph<Scalar> program = BasicCompiledGraph<Scalar>::trace(
+                inputs, [this, target](const Inputs &inputNodes) {
+                    return lossFunction(forward(inputNodes), target);
+                });
+            step = compiledSteps.emplace(target, std::move(program)).first;
+        }
+        return step->second;
+    }
+
     void printTrainingGraphs() {
         // Create a vector for the epoch numbers (1 to EPOCHS)
         std::vector<double> epochsVector;
@@ -306,4 +964,6 @@ public:
     }
 };
 
+using Trainer = BasicTrainer<double>;
+
 #endif //TRAINER_H
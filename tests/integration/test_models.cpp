@@ -1,7 +1,16 @@
 #include <gtest/gtest.h>
 #include <models/binaryClassifier.h>
 #include <models/multiClassClassifier.h>
+#include <models/quantizedClassifier.h>
 #include <utils/datasets/xorDataset.h>
+#include <autoGradEngine/compiledGraph.h>
+#include <fstream>
+#include <iterator>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <set>
+#include <functional>
 
 TEST(BinaryClassifier, InitializationStructure) {
     //Given
@@ -93,3 +102,649 @@ TEST(Serialization, SaveAndLoadPreservesMetadata) {
     delete loaded;
     std::remove(filename.c_str());
 }
+
+TEST(Trainer, BatchGradientIsTheAverageOfSampleGradients) {
+    //Given
+    GraphScope scope;
+    BinaryClassifier model(2, {4});
+    const std::vector<double> features = {0.0, 1.0, 1.0, 0.0, 0.3, 0.8};
+    const std::vector<double> targets = {1.0, 1.0, 0.0};
+
+    std::vector<double> averaged(model.parameters().size(), 0.0);
+    for (size_t i = 0; i < targets.size(); ++i) {
+        model.clearGradients();
+        auto sample = new Tensor(1, 2, {features.at(2 * i), features.at(2 * i + 1)});
+        BinaryCrossEntropyLoss::compute(model(sample), {targets.at(i)})->backward();
+        auto params = model.parameters();
+        for (size_t p = 0; p < params.size(); ++p) averaged.at(p) += params.at(p)->grad / targets.size();
+    }
+
+    //When
+    model.clearGradients();
+    BinaryCrossEntropyLoss::compute(model(new Tensor(3, 2, features)), targets)->backward();
+
+    //Then
+    auto params = model.parameters();
+    for (size_t p = 0; p < params.size(); ++p) {
+        EXPECT_NEAR(params.at(p)->grad, averaged.at(p), 1e-12);
+    }
+}
+
+TEST(InferenceEngine, MatchesTheTensorForwardPass) {
+    //Given
+    GraphScope scope;
+    MultiClassClassifier model(3, {5, 4}, 3);
+    const std::vector<double> input = {0.4, -0.1, 0.7};
+    InferenceEngine engine(model.layerViews());
+
+    //When
+    const double *output = engine.forward(input.data());
+    Tensor *logits = model(new Tensor(1, 3, input));
+
+    //Then
+    ASSERT_EQ(engine.outputSize(), 3u);
+    for (size_t i = 0; i < engine.outputSize(); ++i) {
+        EXPECT_NEAR(output[i], logits->data[i], 1e-12);
+    }
+}
+
+TEST(InferenceEngine, SeesParameterUpdates) {
+    //Given
+    BinaryClassifier model(2, {2});
+    std::vector<double> input = {1.0, 1.0};
+    auto params = model.parameters();
+
+    //When
+    // Zero every weight and push the output bias far below zero, then far above it
+    for (Node *p: params) p->data = 0.0;
+    params.back()->data = -10.0;
+    const int low = model.predict(input);
+    params.back()->data = 10.0;
+    const int high = model.predict(input);
+
+    //Then
+    EXPECT_EQ(low, 0);
+    EXPECT_EQ(high, 1);
+}
+
+TEST(CompiledGraph, ReplayMatchesTheNodeGraph) {
+    //Given
+    MultiClassClassifier model(3, {5, 4}, 3);
+    const std::vector<double> traceInput = {0.1, 0.2, 0.3};
+    const std::vector<double> input = {0.4, -0.1, 0.7};
+    const int target = 2;
+    auto build = [&model, target](const std::vector<Node *> &inputNodes) {
+        return CategoricalCrossEntropyLoss::compute(softmax(model(inputNodes)), target);
+    };
+    CompiledGraph program = CompiledGraph::trace(traceInput, build);
+
+    std::vector<double> expected;
+    double expectedLoss;
+    {
+        GraphScope scope;
+        model.clearGradients();
+        Node *loss = build(helper::createInputNodes(input));
+        loss->backward();
+        expectedLoss = loss->data;
+        for (Node *p: model.parameters()) expected.push_back(p->grad);
+    }
+
+    //When
+    model.clearGradients();
+    const double loss = program.run(input);
+
+    //Then
+    EXPECT_NEAR(loss, expectedLoss, 1e-12);
+    auto params = model.parameters();
+    for (size_t p = 0; p < params.size(); ++p) {
+        EXPECT_NEAR(params.at(p)->grad, expected.at(p), 1e-12);
+    }
+}
+
+TEST(CompiledGraph, EveryOperationReplaysLikeTheNodeGraph) {
+    //Given
+    const std::vector<double> traceInput = {0.5, 0.9, -0.3};
+    const std::vector<double> input = {0.8, -0.4, 1.7};
+    const std::vector<double> rowWeights = {0.3, -0.6, 0.9};
+    const double rowBias = 0.2;
+    std::vector<double> rowWeightGradients(3, 0.0);
+    double rowBiasGradient = 0.0;
+    using Build = std::function<Node *(const std::vector<Node *> &)>;
+    const std::vector<Build> builds = {
+        [](const std::vector<Node *> &x) { return *x[0] + *x[1]; },
+        [](const std::vector<Node *> &x) { return *x[0] + 0.5; },
+        [](const std::vector<Node *> &x) { return *x[0] * *x[1]; },
+        [](const std::vector<Node *> &x) { return *x[0] * 1.5; },
+        [](const std::vector<Node *> &x) { return *x[0] / *x[1]; },
+        [](const std::vector<Node *> &x) { return *x[0] / 4.0; },
+        [](const std::vector<Node *> &x) { return 2.0 / *x[1]; },
+        [](const std::vector<Node *> &x) { return x[0]->pow(3.0); },
+        [](const std::vector<Node *> &x) { return Node::logNode(x[0]); },
+        [](const std::vector<Node *> &x) { return Node::weightedSum({x[0], x[1]}, {x[2], x[0]}, x[1]); },
+        [&](const std::vector<Node *> &x) {
+            return Node::weightedSum(rowWeights.data(), rowWeightGradients.data(), &rowBias, &rowBiasGradient, x, 3);
+        },
+        [](const std::vector<Node *> &x) { return relu(x[0]); },
+        [](const std::vector<Node *> &x) { return sigmoid(x[1]); },
+        [](const std::vector<Node *> &x) { return softmax(x).at(1); },
+        [](const std::vector<Node *> &x) { return CategoricalCrossEntropyLoss::fromLogits(x, 2); },
+        [](const std::vector<Node *> &x) { return BinaryCrossEntropyLoss::fromLogits(x[2], 1.0); },
+    };
+
+    //When
+    std::set<NodeOp> covered;
+    for (const Build &build: builds) {
+        CompiledGraph program = CompiledGraph::trace(traceInput, build);
+        const double replayed = program.run(input);
+
+        //Then
+        GraphScope scope;
+        std::vector<Node *> inputNodes = helper::createInputNodes(input);
+        Node *output = build(inputNodes);
+        output->backward();
+        covered.insert(output->opcode());
+        EXPECT_NEAR(replayed, output->data, 1e-12) << nodeOpName(output->opcode());
+        for (size_t i = 0; i < input.size(); ++i) {
+            EXPECT_NEAR(program.inputGradient(i), inputNodes.at(i)->grad, 1e-12) << nodeOpName(output->opcode());
+        }
+    }
+    for (int op = static_cast<int>(NodeOp::ADD); op <= static_cast<int>(NodeOp::SIGMOID_CROSS_ENTROPY); ++op) {
+        EXPECT_EQ(covered.count(static_cast<NodeOp>(op)), 1u) << nodeOpName(static_cast<NodeOp>(op));
+    }
+}
+
+TEST(CompiledGraph, ReplaysFusedLosses) {
+    //Given
+    BinaryClassifier model(2, {3});
+    const std::vector<double> input = {0.9, -0.4};
+    auto build = [&model](const std::vector<Node *> &inputNodes) {
+        return BinaryCrossEntropyLoss::fromLogits(model.logits(inputNodes).at(0), 1.0);
+    };
+    CompiledGraph program = CompiledGraph::trace({0.0, 0.0}, build);
+
+    std::vector<double> expected;
+    double expectedLoss;
+    {
+        GraphScope scope;
+        model.clearGradients();
+        Node *loss = build(helper::createInputNodes(input));
+        loss->backward();
+        expectedLoss = loss->data;
+        for (Node *p: model.parameters()) expected.push_back(p->grad);
+    }
+
+    //When
+    model.clearGradients();
+    const double loss = program.run(input);
+
+    //Then
+    EXPECT_NEAR(loss, expectedLoss, 1e-12);
+    auto params = model.parameters();
+    for (size_t p = 0; p < params.size(); ++p) {
+        EXPECT_NEAR(params.at(p)->grad, expected.at(p), 1e-12);
+    }
+}
+
+TEST(Trainer, DataParallelStepMatchesSingleThreadedStep) {
+    //Given
+    MultiClassClassifier single(2, {6}, 3), parallel(2, {6}, 3);
+    auto singleParams = single.parameters(), parallelParams = parallel.parameters();
+    for (size_t p = 0; p < singleParams.size(); ++p) parallelParams.at(p)->data = singleParams.at(p)->data;
+
+    const DatasetFormat batch = {{{0.1, 0.9}, 0}, {{0.4, -0.3}, 1}, {{-0.8, 0.2}, 2},
+                                 {{0.5, 0.5}, 1}, {{-0.2, -0.7}, 0}, {{0.9, 0.0}, 2}, {{0.3, 0.1}, 1}};
+    auto loss = [](const std::vector<Node *> &logits, const double target) -> Node *{
+        return CategoricalCrossEntropyLoss::fromLogits(logits, static_cast<int>(target));
+    };
+    auto tensorLoss = [](Tensor *logits, const std::vector<double> &targets) -> Tensor *{
+        return CategoricalCrossEntropyLoss::fromLogits(logits, targets);
+    };
+    const int batchSize = static_cast<int>(batch.size());
+    Trainer singleTrainer(&single, loss, 0.1, 1, batchSize), parallelTrainer(&parallel, loss, 0.1, 1, batchSize);
+    singleTrainer.setTensorLossFunction(tensorLoss);
+    parallelTrainer.setTensorLossFunction(tensorLoss);
+    parallelTrainer.setWorkers(3);
+
+    //When
+    const double singleLoss = singleTrainer.trainEpochBatched(DataTable(batch));
+    const double parallelLoss = parallelTrainer.trainEpochParallel(DataTable(batch));
+
+    //Then
+    EXPECT_NEAR(parallelLoss, singleLoss, 1e-9);
+    for (size_t p = 0; p < singleParams.size(); ++p) {
+        EXPECT_NEAR(parallelParams.at(p)->data, singleParams.at(p)->data, 1e-12);
+    }
+}
+
+TEST(Trainer, PrefetchedBatchesTrainLikeInlineBatches) {
+    //Given
+    MultiClassClassifier inlineModel(2, {6}, 3), prefetchedModel(2, {6}, 3);
+    auto inlineParams = inlineModel.parameters(), prefetchedParams = prefetchedModel.parameters();
+    for (size_t p = 0; p < inlineParams.size(); ++p) prefetchedParams.at(p)->data = inlineParams.at(p)->data;
+
+    DataTable table(2);
+    for (int i = 0; i < 50; ++i) {
+        const double x = std::sin(static_cast<double>(i)), y = std::cos(0.7 * static_cast<double>(i));
+        table.addSample({x, y}, static_cast<double>(i % 3));
+    }
+    auto loss = [](const std::vector<Node *> &logits, const double target) -> Node *{
+        return CategoricalCrossEntropyLoss::fromLogits(logits, static_cast<int>(target));
+    };
+    auto tensorLoss = [](Tensor *logits, const std::vector<double> &targets) -> Tensor *{
+        return CategoricalCrossEntropyLoss::fromLogits(logits, targets);
+    };
+    Trainer inlineTrainer(&inlineModel, loss, 0.1, 1, 8), prefetchedTrainer(&prefetchedModel, loss, 0.1, 1, 8);
+    inlineTrainer.setTensorLossFunction(tensorLoss);
+    prefetchedTrainer.setTensorLossFunction(tensorLoss);
+    inlineTrainer.setBatchPrefetch(0);
+    prefetchedTrainer.setBatchPrefetch(2);
+
+    //When
+    double inlineLoss = 0.0, prefetchedLoss = 0.0;
+    for (int epoch = 0; epoch < 3; ++epoch) {
+        inlineLoss = inlineTrainer.trainEpochBatched(table);
+        prefetchedLoss = prefetchedTrainer.trainEpochBatched(table);
+    }
+
+    //Then
+    EXPECT_EQ(prefetchedLoss, inlineLoss);
+    for (size_t p = 0; p < inlineParams.size(); ++p) {
+        EXPECT_EQ(prefetchedParams.at(p)->data, inlineParams.at(p)->data);
+    }
+}
+
+TEST(Trainer, AsynchronousTrainingLearnsXor) {
+    //Given
+    MultiClassClassifier model(2, {8}, 2);
+    XORDataset xor_data;
+    DataTable dataset;
+    for (int i = 0; i < 50; ++i) {
+        dataset.append(xor_data.getData());
+    }
+    auto loss = [](const std::vector<Node *> &logits, const double target) -> Node *{
+        return CategoricalCrossEntropyLoss::fromLogits(logits, static_cast<int>(target));
+    };
+    Trainer trainer(&model, loss, 0.1, 1, 1);
+    trainer.setWorkers(3);
+    trainer.setAsynchronous(true);
+
+    //When
+    double firstLoss = trainer.trainEpochAsynchronous(dataset);
+    double lastLoss = firstLoss;
+    for (int epoch = 0; epoch < 30; ++epoch) lastLoss = trainer.trainEpochAsynchronous(dataset);
+
+    //Then
+    EXPECT_LT(lastLoss, firstLoss);
+}
+
+TEST(InferenceEngine, PredictBatchMatchesPredict) {
+    //Given
+    MultiClassClassifier model(3, {7, 5}, 4);
+    const size_t rows = 150;
+    std::vector<double> features(rows * 3);
+    for (size_t i = 0; i < features.size(); ++i) features.at(i) = std::sin(static_cast<double>(i));
+    ThreadPool pool(3);
+
+    //When
+    std::vector<int> classes(rows), pooledClasses(rows);
+    std::vector<double> probabilities(rows * 4);
+    model.predictBatch(features.data(), rows, classes.data());
+    model.predictBatch(features.data(), rows, pooledClasses.data(), &pool);
+    model.predictProbaBatch(features.data(), rows, probabilities.data(), &pool);
+
+    //Then
+    for (size_t r = 0; r < rows; ++r) {
+        const std::vector<double> sample(features.begin() + r * 3, features.begin() + (r + 1) * 3);
+        EXPECT_EQ(classes.at(r), model.predict(sample));
+        EXPECT_EQ(pooledClasses.at(r), classes.at(r));
+
+        double total = 0.0;
+        for (size_t c = 0; c < 4; ++c) total += probabilities.at(r * 4 + c);
+        EXPECT_NEAR(total, 1.0, 1e-12);
+        EXPECT_EQ(std::max_element(probabilities.begin() + r * 4, probabilities.begin() + (r + 1) * 4)
+                  - (probabilities.begin() + r * 4), classes.at(r));
+    }
+}
+
+TEST(SinglePrecision, FloatModelMatchesTheDoubleModel) {
+    //Given
+    MultiClassClassifier reference(3, {6, 5}, 3);
+    BasicMultiClassClassifier<float> model(3, {6, 5}, 3);
+    auto referenceParams = reference.parameters();
+    auto params = model.parameters();
+    ASSERT_EQ(params.size(), referenceParams.size());
+    for (size_t p = 0; p < params.size(); ++p) params.at(p)->data = static_cast<float>(referenceParams.at(p)->data);
+
+    const size_t rows = 20;
+    std::vector<double> features(rows * 3);
+    for (size_t i = 0; i < features.size(); ++i) features.at(i) = std::cos(static_cast<double>(i));
+    const std::vector<float> floatFeatures(features.begin(), features.end());
+
+    //When
+    std::vector<double> expected(rows * 3);
+    std::vector<float> actual(rows * 3);
+    reference.predictProbaBatch(features.data(), rows, expected.data());
+    model.predictProbaBatch(floatFeatures.data(), rows, actual.data());
+
+    //Then
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_NEAR(actual.at(i), expected.at(i), 1e-5);
+    }
+}
+
+TEST(SinglePrecision, FloatModelTrainsAndRoundTrips) {
+    //Given
+    std::string filename = "test_float_model.txt";
+    BasicBinaryClassifier<float> model(2, {8});
+    XORDataset xor_data;
+    DataTable dataset;
+    for (int i = 0; i < 50; ++i) {
+        dataset.append(xor_data.getData());
+    }
+    auto params = model.parameters();
+    const std::vector<float> initialWeights = [&params] {
+        std::vector<float> weights;
+        for (auto *p: params) weights.push_back(p->data);
+        return weights;
+    }();
+
+    //When
+    model.train(0.1, 2, 4, dataset);
+    model.saveModel(filename);
+    BasicBinaryClassifier<float> *loaded = BasicBinaryClassifier<float>::loadFromFile(filename);
+
+    //Then
+    ASSERT_NE(loaded, nullptr);
+    auto loadedParams = loaded->parameters();
+    bool parametersChanged = false;
+    for (size_t p = 0; p < params.size(); ++p) {
+        parametersChanged = parametersChanged || params.at(p)->data != initialWeights.at(p);
+        EXPECT_EQ(loadedParams.at(p)->data, params.at(p)->data);
+    }
+    EXPECT_TRUE(parametersChanged);
+
+    // Cleanup
+    delete loaded;
+    std::remove(filename.c_str());
+}
+
+TEST(Trainer, MixedPrecisionStepMatchesTheDoubleStep) {
+    //Given
+    MultiClassClassifier reference(2, {6}, 3);
+    BasicMultiClassClassifier<float> model(2, {6}, 3);
+    auto referenceParams = reference.parameters();
+    auto params = model.parameters();
+    for (size_t p = 0; p < params.size(); ++p) {
+        referenceParams.at(p)->data = static_cast<float>(referenceParams.at(p)->data);
+        params.at(p)->data = static_cast<float>(referenceParams.at(p)->data);
+    }
+
+    const DatasetFormat batch = {{{0.1, 0.9}, 0}, {{0.4, -0.3}, 1}, {{-0.8, 0.2}, 2}, {{0.5, 0.5}, 1}};
+    auto loss = [](const std::vector<Node *> &logits, const double target) -> Node *{
+        return CategoricalCrossEntropyLoss::fromLogits(logits, static_cast<int>(target));
+    };
+    auto floatLoss = [](const std::vector<BasicNode<float> *> &logits, const double target) -> BasicNode<float> *{
+        return BasicCategoricalCrossEntropyLoss<float>::fromLogits(logits, static_cast<int>(target));
+    };
+    Trainer referenceTrainer(&reference, loss, 0.1, 1, 2);
+    BasicTrainer<float> trainer(&model, floatLoss, 0.1, 1, 2);
+    trainer.setMixedPrecision(true, LossScaler(1024.0));
+
+    //When
+    const double referenceLoss = referenceTrainer.trainEpochPerSample(DataTable(batch));
+    const double mixedLoss = trainer.trainEpochPerSample(DataTable(batch));
+
+    //Then
+    EXPECT_NEAR(mixedLoss, referenceLoss, 1e-5);
+    EXPECT_EQ(trainer.getLossScaler().getSkippedSteps(), 0u);
+    for (size_t p = 0; p < params.size(); ++p) {
+        EXPECT_NEAR(params.at(p)->data, referenceParams.at(p)->data, 1e-5);
+    }
+}
+
+TEST(Trainer, MixedPrecisionSkipsStepsThatOverflow) {
+    //Given
+    BasicBinaryClassifier<float> model(2, {4});
+    std::vector<float> initialWeights;
+    for (auto *p: model.parameters()) initialWeights.push_back(p->data);
+
+    const DatasetFormat batch = {{{0.1, 0.9}, 0}, {{0.4, -0.3}, 1}};
+    auto loss = [](const std::vector<BasicNode<float> *> &logits, const double target) -> BasicNode<float> *{
+        return BasicBinaryCrossEntropyLoss<float>::fromLogits(logits.at(0), target);
+    };
+    BasicTrainer<float> trainer(&model, loss, 0.1, 1, 1);
+    trainer.setMixedPrecision(true, LossScaler(1e300));
+
+    //When
+    trainer.trainEpochPerSample(DataTable(batch));
+
+    //Then
+    EXPECT_EQ(trainer.getLossScaler().getSkippedSteps(), 2u);
+    EXPECT_DOUBLE_EQ(trainer.getLossScaler().getScale(), 0.25e300);
+    auto params = model.parameters();
+    for (size_t p = 0; p < params.size(); ++p) {
+        EXPECT_EQ(params.at(p)->data, initialWeights.at(p));
+    }
+}
+
+TEST(Quantization, Int8OutputsFollowTheFullPrecisionModel) {
+    //Given
+    MultiClassClassifier model(4, {16, 8}, 3);
+    DatasetFormat samples;
+    for (int i = 0; i < 200; ++i) {
+        const double t = static_cast<double>(i);
+        samples.push_back({{std::sin(t), std::cos(1.3 * t), std::sin(0.7 * t), std::cos(0.3 * t)}, 0.0});
+    }
+    for (auto &sample: samples) sample.second = model.predict(sample.first);
+
+    //When
+    QuantizedClassifier quantized(model, samples, samples);
+    InferenceEngine reference(model.layerViews());
+    std::vector<float> output(3);
+    double largestError = 0.0, largestLogit = 0.0;
+    for (const auto &sample: samples) {
+        const std::vector<float> input(sample.first.begin(), sample.first.end());
+        quantized.inferenceEngine().forward(input.data(), output.data());
+        const double *expected = reference.forward(sample.first.data());
+        for (size_t c = 0; c < 3; ++c) {
+            largestError = std::max(largestError, std::fabs(output[c] - expected[c]));
+            largestLogit = std::max(largestLogit, std::fabs(expected[c]));
+        }
+    }
+
+    //Then
+    const QuantizationReport &report = quantized.getReport();
+    EXPECT_DOUBLE_EQ(report.referenceAccuracy, 1.0);
+    EXPECT_GT(report.quantizedAccuracy, 0.9);
+    EXPECT_LT(largestError, 0.05 * largestLogit);
+    EXPECT_EQ(report.quantizedBytes, (4 * 16 + 16 * 8 + 8 * 3) + 4 * (16 + 8 + 3));
+    EXPECT_EQ(report.referenceBytes, 8 * ((4 * 16 + 16 * 8 + 8 * 3) + (16 + 8 + 3)));
+}
+
+TEST(Quantization, LoadsASavedModel) {
+    //Given
+    std::string filename = "test_quantized_model.txt";
+    BinaryClassifier model(2, {4});
+    model.saveModel(filename);
+    const DatasetFormat samples = {{{0.0, 0.0}, 0}, {{0.0, 1.0}, 1}, {{1.0, 0.0}, 1}, {{1.0, 1.0}, 0}};
+
+    //When
+    QuantizedClassifier quantized = QuantizedClassifier::fromFile<BinaryClassifier>(filename, samples, {});
+    std::vector<int> classes(samples.size());
+    const std::vector<float> features = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f, 1.0f};
+    quantized.predictBatch(features.data(), samples.size(), classes.data());
+
+    //Then
+    EXPECT_EQ(quantized.inferenceEngine().inputSize(), 2u);
+    EXPECT_EQ(quantized.inferenceEngine().outputSize(), 1u);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        EXPECT_EQ(classes.at(i), quantized.predict(samples.at(i).first));
+    }
+    EXPECT_THROW(QuantizedClassifier::fromFile<BinaryClassifier>("missing_model.txt", samples, {}),
+                 std::runtime_error);
+
+    // Cleanup
+    std::remove(filename.c_str());
+}
+
+TEST(Quantization, RejectsSamplesOfTheWrongWidth) {
+    //Given
+    BinaryClassifier model(2, {4});
+    const DatasetFormat samples = {{{0.0, 0.0}, 0}, {{1.0, 1.0}, 0}};
+    const DatasetFormat wider = {{{0.0, 0.0, 1.0}, 0}, {{1.0, 1.0, 0.0}, 0}};
+
+    //When, Then
+    EXPECT_THROW(QuantizedClassifier(model, wider, samples), std::invalid_argument);
+    EXPECT_THROW(QuantizedClassifier(model, samples, wider), std::invalid_argument);
+    EXPECT_NO_THROW(QuantizedClassifier(model, samples, samples));
+}
+
+TEST(Serialization, BinaryFormatRoundTripsExactly) {
+    //Given
+    std::string filename = "test_model_binary.bin";
+    MultiClassClassifier original(4, {5, 3}, 3);
+    const std::vector<double> input = {0.2, -0.4, 0.9, 0.1};
+
+    //When
+    ASSERT_TRUE(original.saveModel(filename, ModelFormat::BINARY));
+    std::unique_ptr<MultiClassClassifier> loaded(MultiClassClassifier::loadFromFile(filename));
+    std::unique_ptr<BinaryClassifier> wrongModel(BinaryClassifier::loadFromFile(filename));
+
+    //Then
+    ASSERT_NE(loaded, nullptr);
+    EXPECT_EQ(wrongModel, nullptr);
+    auto originalParams = original.parameters(), loadedParams = loaded->parameters();
+    ASSERT_EQ(loadedParams.size(), originalParams.size());
+    for (size_t p = 0; p < originalParams.size(); ++p) {
+        EXPECT_EQ(loadedParams.at(p)->data, originalParams.at(p)->data);
+    }
+    EXPECT_EQ(loaded->predict(input), original.predict(input));
+
+    // Cleanup
+    std::remove(filename.c_str());
+}
+
+TEST(Serialization, MappedModelServesItsWeightsInPlace) {
+    //Given
+    std::string filename = "test_model_mapped.bin";
+    BasicBinaryClassifier<float> model(3, {6});
+    const std::vector<float> input = {0.5f, -1.0f, 0.25f};
+    ASSERT_TRUE(model.saveModel(filename, ModelFormat::BINARY));
+
+    //When
+    MappedModel mapped(filename);
+    const std::vector<BasicDenseLayerView<float> > views = mapped.layerViews<float>();
+    BasicInferenceEngine<float> engine(views);
+    const float mappedOutput = engine.forward(input.data())[0];
+    float modelOutput = 0.0f;
+    model.predictProbaBatch(input.data(), 1, &modelOutput);
+
+    //Then
+    ASSERT_EQ(views.size(), 2u);
+    EXPECT_EQ(mapped.inputSize(), 3);
+    EXPECT_EQ(mapped.layerSizes(), std::vector<int>({6, 1}));
+    EXPECT_EQ(mapped.activation(1), Activation::SIGMOID);
+    for (const auto &view: views) {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(view.weights) % 64, 0u);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(view.biases) % 64, 0u);
+    }
+    EXPECT_FLOAT_EQ(mappedOutput, modelOutput);
+    EXPECT_THROW(mapped.layerViews<double>(), std::runtime_error);
+
+    // Cleanup
+    std::remove(filename.c_str());
+}
+
+TEST(Serialization, MappedInferenceModelMatchesTheLoadedClassifier) {
+    //Given
+    std::string filename = "test_model_mapped_classifier.bin";
+    MultiClassClassifier model(3, {5}, 4);
+    const std::vector<double> input = {0.3, -0.6, 1.2};
+    ASSERT_TRUE(model.saveModel(filename, ModelFormat::BINARY));
+
+    //When
+    std::unique_ptr<MultiClassClassifier> loaded(MultiClassClassifier::loadFromFile(filename));
+    std::unique_ptr<BasicMappedInferenceModel<double> > mapped = MultiClassClassifier::loadForInference(filename);
+
+    //Then
+    ASSERT_NE(loaded, nullptr);
+    EXPECT_EQ(mapped->engine().argmax(input.data()), loaded->predict(input));
+    EXPECT_EQ(mapped->engine().argmax(input.data()), model.predict(input));
+
+    // Cleanup
+    std::remove(filename.c_str());
+}
+
+TEST(Serialization, BinaryFormatRejectsAnotherArchitecture) {
+    //Given
+    std::string filename = "test_model_architecture.bin";
+    std::string emptyFilename = "test_model_no_layers.bin";
+    MultiClassClassifier multiClass(2, {4}, 1);
+    ASSERT_TRUE(multiClass.saveModel(filename, ModelFormat::BINARY));
+    binaryModel::Header header{};
+    std::memcpy(header.magic, binaryModel::magic, sizeof(header.magic));
+    header.version = binaryModel::version;
+    header.byteOrder = binaryModel::byteOrderMark;
+    header.scalarType = binaryModel::float64;
+    header.fileSize = sizeof(header);
+    {
+        std::ofstream file(emptyFilename, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    }
+
+    //When
+    BinaryClassifier *binary = BinaryClassifier::loadFromFile(filename);
+
+    //Then
+    // A one-class output layer has the width of a binary classifier, but not its sigmoid activation
+    EXPECT_EQ(binary, nullptr);
+    EXPECT_THROW(BinaryClassifier::loadForInference(filename), std::runtime_error);
+    EXPECT_THROW(MappedModel mapped(emptyFilename, false), std::runtime_error);
+    EXPECT_EQ(MultiClassClassifier::loadFromFile(emptyFilename), nullptr);
+
+    // Cleanup
+    delete binary;
+    std::remove(filename.c_str());
+    std::remove(emptyFilename.c_str());
+}
+
+TEST(Serialization, BinaryFormatRejectsCorruptedFiles) {
+    //Given
+    std::string filename = "test_model_corrupted.bin";
+    BinaryClassifier model(2, {4});
+    ASSERT_TRUE(model.saveModel(filename, ModelFormat::BINARY));
+    std::string bytes;
+    {
+        std::ifstream file(filename, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    auto rewrite = [&filename](const std::string &content) {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    };
+
+    //When
+    std::string flipped = bytes;
+    flipped.at(flipped.size() - 70) ^= 0x40;
+    rewrite(flipped);
+    bool checksumRejected = false;
+    try {
+        MappedModel mapped(filename);
+    } catch (const std::runtime_error &) {
+        checksumRejected = true;
+    }
+    const bool loadsWithoutVerification = [&filename] {
+        MappedModel mapped(filename, false);
+        return mapped.layerCount() == 2;
+    }();
+    rewrite(bytes.substr(0, bytes.size() - 8));
+
+    //Then
+    EXPECT_TRUE(checksumRejected);
+    EXPECT_TRUE(loadsWithoutVerification);
+    EXPECT_THROW(MappedModel mapped(filename), std::runtime_error);
+    EXPECT_EQ(BinaryClassifier::loadFromFile(filename), nullptr);
+
+    // Cleanup
+    std::remove(filename.c_str());
+}
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include <autoGradEngine/node.h>
+#include <nnComponents/activations/softmax.h>
+#include <nnComponents/activations/sigmoidNode.h>
 #include <cmath>
 
 TEST(AutoGradEngine, AdditionForward) {
@@ -152,4 +154,259 @@ TEST(AutoGradEngine, ChainRuleComplex) {
 
     delete u;
     delete f;
-}
\ No newline at end of file
+}
+
+TEST(GraphArena, NodesInsideScopeAreArenaOwned) {
+    //Given
+    GraphArena arena;
+    Node x(3.0);
+
+    //When
+    GraphScope scope(arena);
+    Node *f = x * 2.0;
+    f->backward();
+
+    //Then
+    EXPECT_TRUE(Node::isArenaAllocated(f));
+    EXPECT_TRUE(arena.owns(f));
+    EXPECT_DOUBLE_EQ(x.grad, 2.0);
+}
+
+TEST(GraphArena, NodesOutsideScopeGoToTheHeap) {
+    //Given
+    Node x(3.0);
+
+    //When
+    Node *f = x * 2.0;
+
+    //Then
+    EXPECT_FALSE(Node::isArenaAllocated(f));
+    delete f;
+}
+
+TEST(GraphArena, ClosingScopeReusesMemory) {
+    //Given
+    GraphArena arena;
+    Node x(1.5);
+    Node *first;
+    {
+        GraphScope scope(arena);
+        first = x * x;
+        for (int i = 0; i < 1000; ++i) {
+            first = (*first) + 1.0;
+        }
+    }
+    const size_t warmCapacity = arena.capacity();
+
+    //When
+    Node *last = nullptr;
+    for (int step = 0; step < 10; ++step) {
+        GraphScope scope(arena);
+        last = x * x;
+        for (int i = 0; i < 1000; ++i) {
+            last = (*last) + 1.0;
+        }
+    }
+
+    //Then
+    // Every step builds the same graph into the same memory, so the arena never grows after the first one
+    EXPECT_EQ(arena.capacity(), warmCapacity);
+    EXPECT_EQ(first, last);
+}
+
+TEST(GraphArena, NestedScopesOnlyReleaseTheirOwnNodes) {
+    //Given
+    GraphArena arena;
+    Node x(2.0);
+    GraphScope outer(arena);
+    Node *kept = x * 3.0;
+    const auto marker = arena.mark();
+
+    //When
+    {
+        GraphScope inner(arena);
+        Node *discarded = (*kept) + 1.0;
+        EXPECT_DOUBLE_EQ(discarded->data, 7.0);
+    }
+
+    //Then
+    EXPECT_EQ(arena.mark().offset, marker.offset);
+    EXPECT_DOUBLE_EQ(kept->data, 6.0);
+}
+
+// Allocated like a Tensor, with a finalizer registered in the arena, and counts how often it is destroyed
+struct CountedArenaObject : ArenaAllocated<CountedArenaObject> {
+    static int destroyed;
+
+    ~CountedArenaObject() {
+        ++destroyed;
+    }
+};
+
+int CountedArenaObject::destroyed = 0;
+
+TEST(GraphArena, DeletingAnArenaObjectRunsItsDestructorOnce) {
+    //Given
+    CountedArenaObject::destroyed = 0;
+    GraphArena arena;
+
+    //When
+    {
+        GraphScope scope(arena);
+        delete new CountedArenaObject();
+        new CountedArenaObject();
+    }
+
+    //Then
+    // Closing the scope finalizes the object that was not deleted, but not the deleted one a second time
+    EXPECT_EQ(CountedArenaObject::destroyed, 2);
+}
+
+TEST(AutoGradEngine, WeightedSumForwardAndBackward) {
+    //Given
+    Node w0(2.0), w1(-1.0), x0(3.0), x1(5.0), b(0.5);
+
+    //When
+    Node *f = Node::weightedSum({&w0, &w1}, {&x0, &x1}, &b);
+    f->backward();
+
+    //Then
+    EXPECT_DOUBLE_EQ(f->data, 2.0 * 3.0 - 1.0 * 5.0 + 0.5);
+    EXPECT_DOUBLE_EQ(w0.grad, 3.0);
+    EXPECT_DOUBLE_EQ(w1.grad, 5.0);
+    EXPECT_DOUBLE_EQ(x0.grad, 2.0);
+    EXPECT_DOUBLE_EQ(x1.grad, -1.0);
+    EXPECT_DOUBLE_EQ(b.grad, 1.0);
+    delete f;
+}
+
+TEST(AutoGradEngine, NodesRecordTheirOperation) {
+    //Given
+    Node a(2.0), b(3.0);
+
+    //When
+    Node *sum = a + b;
+    Node *scaled = a * 4.0;
+    Node *leaf = new Node(1.0);
+
+    //Then
+    EXPECT_EQ(sum->opcode(), NodeOp::ADD);
+    EXPECT_STREQ(sum->operation(), "+");
+    EXPECT_EQ(sum->parentCount(), 2u);
+    EXPECT_EQ(sum->parent(0), &a);
+    EXPECT_EQ(sum->parent(1), &b);
+    EXPECT_EQ(scaled->opcode(), NodeOp::MUL_CONSTANT);
+    EXPECT_EQ(scaled->parentCount(), 1u);
+    EXPECT_EQ(leaf->parentCount(), 0u);
+    delete sum;
+    delete scaled;
+    delete leaf;
+}
+
+TEST(AutoGradEngine, SoftmaxBackwardMatchesJacobian) {
+    //Given
+    Node l0(1.0), l1(2.0), l2(0.5);
+    std::vector<Node *> logits = {&l0, &l1, &l2};
+
+    //When
+    GraphScope scope;
+    std::vector<Node *> probabilities = softmax(logits);
+    probabilities.at(1)->backward();
+
+    //Then
+    const double p0 = probabilities.at(0)->data;
+    const double p1 = probabilities.at(1)->data;
+    const double p2 = probabilities.at(2)->data;
+    EXPECT_NEAR(p0 + p1 + p2, 1.0, 1e-12);
+    EXPECT_NEAR(l0.grad, -p1 * p0, 1e-12);
+    EXPECT_NEAR(l1.grad, p1 * (1.0 - p1), 1e-12);
+    EXPECT_NEAR(l2.grad, -p1 * p2, 1e-12);
+}
+
+TEST(GraphArena, TapeBackwardMatchesTopologicalBackward) {
+    //Given
+    Node x1(0.7), y1(-1.3), x2(0.7), y2(-1.3);
+    GraphArena arena;
+
+    //When
+    {
+        GraphScope scope(arena);
+        Node *f = *(*(*(&x1) * y1) + *(x1.pow(2.0))) / *sigmoid(&y1);
+        f->backward();
+    }
+    {
+        GraphScope scope(arena, true);
+        Node *f = *(*(*(&x2) * y2) + *(x2.pow(2.0))) / *sigmoid(&y2);
+        EXPECT_EQ(arena.tape().back(), f);
+        f->backward();
+    }
+
+    //Then
+    EXPECT_DOUBLE_EQ(x1.grad, x2.grad);
+    EXPECT_DOUBLE_EQ(y1.grad, y2.grad);
+    EXPECT_TRUE(arena.tape().empty());
+}
+
+TEST(GraphArena, SecondBackwardInARecordingScopeMatchesTopologicalBackward) {
+    //Given
+    Node x1(1.0), x2(1.0);
+    GraphArena arena;
+
+    //When
+    {
+        Node *a = x1 * 2.0;
+        a->backward();
+        Node *b = x1 * 3.0;
+        b->backward();
+        delete a;
+        delete b;
+    }
+    {
+        GraphScope scope(arena, true);
+        Node *a = x2 * 2.0;
+        a->backward();
+        Node *b = x2 * 3.0;
+        b->backward();
+    }
+
+    //Then
+    EXPECT_DOUBLE_EQ(x1.grad, 5.0);
+    EXPECT_DOUBLE_EQ(x2.grad, 5.0);
+}
+
+TEST(GraphArena, TapeReplaySkipsNodesTheRootDoesNotDependOn) {
+    //Given
+    Node w(2.0), z(0.0);
+    GraphArena arena;
+
+    //When
+    {
+        GraphScope scope(arena, true);
+        w / z;
+        z.pow(0.5);
+        Node *loss = w * w;
+        loss->backward();
+    }
+
+    //Then
+    EXPECT_DOUBLE_EQ(w.grad, 4.0);
+    EXPECT_DOUBLE_EQ(z.grad, 0.0);
+}
+
+TEST(GraphArena, TapeHandlesDeepGraphs) {
+    //Given
+    Node x(1.0);
+    GraphArena arena;
+    GraphScope scope(arena, true);
+
+    //When
+    Node *chain = &x;
+    for (int i = 0; i < 200000; ++i) {
+        chain = *chain + 1.0;
+    }
+    chain->backward();
+
+    //Then
+    EXPECT_DOUBLE_EQ(chain->data, 200001.0);
+    EXPECT_DOUBLE_EQ(x.grad, 1.0);
+}
@@ -0,0 +1,443 @@
+#include <gtest/gtest.h>
+#include <utils/datasets/dataTable.h>
+#include <utils/datasets/csvReader.h>
+#include <utils/datasets/irisDataset.h>
+#include <utils/datasets/streamingDataset.h>
+#include <utils/datasets/batchProducer.h>
+#include <nnComponents/trainers/trainer.h>
+#include <models/multiClassClassifier.h>
+#include <vector>
+#include <set>
+#include <cmath>
+#include <random>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <algorithm>
+
+TEST(DataTable, StoresTheSamplesInOneMatrix) {
+    //Given
+    const DatasetFormat samples = {{{1.0, 2.0}, 0.0}, {{3.0, 4.0}, 1.0}, {{5.0, 6.0}, 2.0}};
+
+    //When
+    const DataTable table(samples);
+
+    //Then
+    ASSERT_EQ(table.size(), 3u);
+    EXPECT_EQ(table.featureCount(), 2u);
+    const std::vector<double> matrix(table.data(), table.data() + 6);
+    EXPECT_EQ(matrix, (std::vector<double>{1.0, 2.0, 3.0, 4.0, 5.0, 6.0}));
+    EXPECT_EQ(table.labels(), (std::vector<double>{0.0, 1.0, 2.0}));
+    EXPECT_EQ(table.features(1), table.data() + 2);
+    EXPECT_THROW(DataTable(DatasetFormat{{{1.0}, 0.0}, {{1.0, 2.0}, 1.0}}), std::invalid_argument);
+}
+
+TEST(DatasetView, SlicesShareTheRowsOfTheTable) {
+    //Given
+    DataTable table(1);
+    for (int i = 0; i < 10; ++i) table.addSample({static_cast<double>(i)}, static_cast<double>(i % 2));
+
+    //When
+    const DatasetView range(table, 2, 8);
+    const DatasetView batch = range.slice(1, 4);
+    const DatasetView permuted(table, std::vector<size_t>{9, 3, 5, 0});
+    const DatasetView tail = permuted.slice(2, 4);
+    std::vector<float> gathered(2);
+    tail.gather(0, 2, gathered.data());
+
+    //Then
+    ASSERT_EQ(batch.size(), 3u);
+    EXPECT_TRUE(batch.contiguous());
+    EXPECT_EQ(batch.features(0), table.features(3));
+    EXPECT_EQ(batch.rows(), table.features(3));
+    EXPECT_EQ(batch.label(1), 0.0);
+    EXPECT_FALSE(tail.contiguous());
+    EXPECT_EQ(tail.row(0), 5u);
+    EXPECT_EQ(tail.features(1), table.features(0));
+    EXPECT_EQ(gathered, (std::vector<float>{5.0f, 0.0f}));
+    EXPECT_THROW(range.slice(4, 7), std::out_of_range);
+    EXPECT_THROW(DatasetView(table, std::vector<size_t>{10}), std::out_of_range);
+}
+
+TEST(Trainer, SplitsAreDisjointViewsOfTheDataset) {
+    //Given
+    DataTable table(1);
+    for (int i = 0; i < 50; ++i) table.addSample({static_cast<double>(i)}, 0.0);
+
+    //When
+    std::mt19937_64 generator(7);
+    const auto splits = Trainer::splitData(table, generator);
+
+    //Then
+    std::set<size_t> rows;
+    for (const DatasetView &split: {std::get<0>(splits), std::get<1>(splits), std::get<2>(splits)}) {
+        for (size_t i = 0; i < split.size(); ++i) {
+            EXPECT_EQ(split.features(i), table.features(split.row(i)));
+            rows.insert(split.row(i));
+        }
+    }
+    EXPECT_EQ(std::get<0>(splits).size(), 30u);
+    EXPECT_EQ(std::get<1>(splits).size(), 10u);
+    EXPECT_EQ(rows.size(), 50u);
+}
+
+TEST(Trainer, AccuracyScoresViewsInBatches) {
+    //Given
+    DataTable table(2);
+    for (int i = 0; i < 60; ++i) {
+        const double x = std::sin(static_cast<double>(i)), y = std::cos(1.3 * static_cast<double>(i));
+        table.addSample({x, y}, static_cast<double>(i % 3));
+    }
+    MultiClassClassifier model(2, {5}, 3);
+    auto loss = [](const std::vector<Node *> &logits, const double target) -> Node *{
+        return CategoricalCrossEntropyLoss::fromLogits(logits, static_cast<int>(target));
+    };
+    Trainer trainer(&model, loss);
+    std::mt19937_64 generator(3);
+    const DatasetView shuffled = DatasetView(table).shuffled(generator);
+
+    //When
+    const double contiguousAccuracy = trainer.computeAccuracy(DatasetView(table, 10, 50));
+    const double shuffledAccuracy = trainer.computeAccuracy(shuffled);
+
+    //Then
+    int contiguousCorrect = 0, shuffledCorrect = 0;
+    for (size_t i = 10; i < 50; ++i) {
+        const std::vector<double> input(table.features(i), table.features(i) + 2);
+        if (model.predict(input) == static_cast<int>(table.label(i))) ++contiguousCorrect;
+    }
+    for (size_t i = 0; i < shuffled.size(); ++i) {
+        const std::vector<double> input(shuffled.features(i), shuffled.features(i) + 2);
+        if (model.predict(input) == static_cast<int>(shuffled.label(i))) ++shuffledCorrect;
+    }
+    EXPECT_DOUBLE_EQ(contiguousAccuracy, contiguousCorrect / 40.0);
+    EXPECT_DOUBLE_EQ(shuffledAccuracy, shuffledCorrect / 60.0);
+    EXPECT_THROW(trainer.computeAccuracy(DataTable({{{1.0, 2.0, 3.0}, 0.0}})), std::invalid_argument);
+}
+
+TEST(DatasetView, ShuffledIsASeededPermutationOfTheRows) {
+    //Given
+    DataTable table(1);
+    for (int i = 0; i < 100; ++i) table.addSample({static_cast<double>(i)}, 0.0);
+    const DatasetView view(table, 10, 90);
+    std::mt19937_64 generator(42), sameSeed(42);
+
+    //When
+    const DatasetView first = view.shuffled(generator);
+    const DatasetView second = view.shuffled(generator);
+    const DatasetView replay = view.shuffled(sameSeed);
+
+    //Then
+    std::set<size_t> rows;
+    bool reordered = false;
+    for (size_t i = 0; i < first.size(); ++i) {
+        rows.insert(first.row(i));
+        EXPECT_EQ(replay.row(i), first.row(i));
+        reordered = reordered || first.row(i) != second.row(i);
+    }
+    EXPECT_EQ(rows.size(), 80u);
+    EXPECT_EQ(*rows.begin(), 10u);
+    EXPECT_EQ(*rows.rbegin(), 89u);
+    EXPECT_TRUE(reordered);
+}
+
+TEST(BatchProducer, PrefetchedBatchesMatchTheInlineOnes) {
+    //Given
+    DataTable table(3);
+    for (int i = 0; i < 103; ++i) {
+        table.addSample({static_cast<double>(i), 0.5 * i, -1.0 * i}, static_cast<double>(i % 7));
+    }
+    std::mt19937_64 generator(7);
+    const DatasetView view = DatasetView(table).shuffled(generator);
+    BasicBatchProducer<float> prefetching(3), inlineProducer(0);
+
+    //When
+    prefetching.start(view, 10);
+    inlineProducer.start(view, 10);
+
+    //Then
+    size_t covered = 0;
+    while (BasicPreparedBatch<float> *batch = prefetching.next()) {
+        const BasicPreparedBatch<float> *expected = inlineProducer.next();
+        ASSERT_NE(expected, nullptr);
+        EXPECT_EQ(batch->first, covered);
+        EXPECT_EQ(batch->rows, expected->rows);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(batch->features.data()) % 64, 0u);
+        for (size_t i = 0; i < batch->rows; ++i) {
+            EXPECT_EQ(batch->targets.at(i), view.label(covered + i));
+            for (size_t j = 0; j < 3; ++j) {
+                EXPECT_EQ(batch->features.at(i * 3 + j), static_cast<float>(view.features(covered + i)[j]));
+                EXPECT_EQ(batch->features.at(i * 3 + j), expected->features.at(i * 3 + j));
+                EXPECT_EQ(batch->gradients.at(i * 3 + j), 0.0f);
+            }
+        }
+        covered += batch->rows;
+    }
+    EXPECT_EQ(covered, table.size());
+    EXPECT_EQ(inlineProducer.next(), nullptr);
+}
+
+TEST(Trainer, TheSameSeedReproducesTraining) {
+    //Given
+    DataTable table(2);
+    for (int i = 0; i < 40; ++i) {
+        const double x = std::sin(static_cast<double>(i)), y = std::cos(1.7 * static_cast<double>(i));
+        table.addSample({x, y}, x * y > 0.0 ? 1.0 : 0.0);
+    }
+    MultiClassClassifier first(2, {4}, 2), second(2, {4}, 2);
+    auto firstParams = first.parameters(), secondParams = second.parameters();
+    for (size_t p = 0; p < firstParams.size(); ++p) secondParams.at(p)->data = firstParams.at(p)->data;
+    first.setTrainingSeed(123);
+    second.setTrainingSeed(123);
+
+    //When
+    first.train(0.1, 3, 4, table);
+    second.train(0.1, 3, 4, table);
+
+    //Then
+    for (size_t p = 0; p < firstParams.size(); ++p) {
+        EXPECT_EQ(secondParams.at(p)->data, firstParams.at(p)->data);
+    }
+}
+
+TEST(Csv, ParsesNumbersInPlace) {
+    //Given
+    const std::vector<std::string> numbers = {"3.25", "-0.5e-3", " 42 ", "0.1", "1e22", "123456789.123456789",
+                                              "2.2250738585072014e-308", "1e400", "+7.", ".5"};
+
+    //When
+    //Then
+    for (const std::string &number: numbers) {
+        double value = 0.0;
+        EXPECT_TRUE(csv::parseDouble(number.data(), number.data() + number.size(), value)) << number;
+        EXPECT_EQ(value, std::strtod(number.c_str(), nullptr)) << number;
+    }
+    for (const std::string &text: std::vector<std::string>{"", "abc", "1.5x", "1e", "-", "1,5"}) {
+        double value = 0.0;
+        EXPECT_FALSE(csv::parseDouble(text.data(), text.data() + text.size(), value)) << text;
+    }
+}
+
+TEST(Csv, ParallelChunksReadTheSameTableAsOneThread) {
+    //Given
+    const std::string filename = "test_dataset.csv";
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file << "x,y,label\r\n";
+        for (int i = 0; i < 200000; ++i) {
+            file << i << ".25," << -i << "," << i % 3 << (i % 2 ? "\r\n" : "\n");
+            if (i % 1000 == 0) file << "\n";
+        }
+    }
+    auto parseRow = [](const std::vector<CsvField> &row, double *features, double &label) {
+        csv::parseDouble(row[0], features[0]);
+        csv::parseDouble(row[1], features[1]);
+        csv::parseDouble(row[2], label);
+    };
+    ThreadPool pool(4);
+
+    //When
+    const CsvReader reader(filename);
+    const DataTable sequential = reader.readTable(2, parseRow);
+    const DataTable parallel = reader.readTable(2, parseRow, &pool);
+
+    //Then
+    ASSERT_EQ(reader.header().size(), 3u);
+    EXPECT_TRUE(reader.header()[2] == "label");
+    ASSERT_EQ(sequential.size(), 200000u);
+    ASSERT_EQ(parallel.size(), sequential.size());
+    for (size_t i = 0; i < sequential.size(); ++i) {
+        ASSERT_EQ(parallel.features(i)[0], static_cast<double>(i) + 0.25);
+        ASSERT_EQ(parallel.features(i)[1], sequential.features(i)[1]);
+        ASSERT_EQ(parallel.label(i), static_cast<double>(i % 3));
+    }
+
+    // Cleanup
+    std::remove(filename.c_str());
+}
+
+TEST(Csv, RejectsRowsWithMissingFields) {
+    //Given
+    const std::string filename = "test_malformed.csv";
+    {
+        std::ofstream file(filename);
+        file << "Id,a,b,Species\n1,0.5,0.25,Iris-setosa\n2,0.5,Iris-virginica\n";
+    }
+
+    //When
+    //Then
+    EXPECT_THROW(IrisDataset dataset(filename), std::runtime_error);
+    EXPECT_THROW(IrisDataset dataset("missing_dataset.csv"), std::runtime_error);
+    {
+        std::ofstream file(filename);
+        file << "a,b,label\n1,2,0\n\n3,4,1\n5,1\n";
+    }
+    std::string message;
+    try {
+        CsvReader(filename).readTable(2, [](const std::vector<CsvField> &, double *, double &) {});
+    } catch (const std::runtime_error &error) {
+        message = error.what();
+    }
+    EXPECT_NE(message.find("line 5 "), std::string::npos) << message;
+    std::string streamedMessage;
+    try {
+        CsvChunkSource source(filename, 2, [](const std::vector<CsvField> &, double *, double &) {});
+        DataTable chunk(2);
+        source.read(chunk, 16);
+    } catch (const std::runtime_error &error) {
+        streamedMessage = error.what();
+    }
+    EXPECT_EQ(streamedMessage, message);
+
+    // Cleanup
+    std::remove(filename.c_str());
+}
+
+TEST(DatasetCache, LaterLoadsReadTheCacheUntilTheSourceChanges) {
+    //Given
+    const std::string filename = "test_iris.csv";
+    const std::string cachePath = datasetCache::pathFor(filename);
+    auto writeSource = [&filename](const double lastLength) {
+        std::ofstream file(filename);
+        file << "Id,SepalLength,SepalWidth,Species\n1,5.1,3.5,Iris-setosa\n2,7.0,3.2,Iris-versicolor\n"
+             << "3," << lastLength << ",3.3,Iris-virginica\n";
+    };
+    writeSource(6.3);
+
+    //When
+    const IrisDataset parsed(filename);
+    std::ifstream cacheFile(cachePath);
+    const bool cacheWritten = cacheFile.good();
+    cacheFile.close();
+    const IrisDataset cached(filename);
+    writeSource(9.9);
+    const IrisDataset reparsed(filename);
+
+    //Then
+    EXPECT_TRUE(cacheWritten);
+    const DataTable &expected = parsed.getData(), &actual = cached.getData();
+    ASSERT_EQ(actual.size(), 3u);
+    ASSERT_EQ(actual.featureCount(), 2u);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(actual.label(i), expected.label(i));
+        EXPECT_EQ(actual.features(i)[0], expected.features(i)[0]);
+        EXPECT_EQ(actual.features(i)[1], expected.features(i)[1]);
+    }
+    EXPECT_EQ(expected.features(1)[0], 1.0);  // 7.0 is the largest value before the source changes
+    EXPECT_EQ(reparsed.getData().features(2)[0], 1.0);
+    EXPECT_LT(reparsed.getData().features(1)[0], 1.0);
+
+    // Cleanup
+    std::remove(filename.c_str());
+    std::remove(cachePath.c_str());
+}
+
+TEST(StreamingDataset, EveryEpochHandsOutEverySampleOnceInBoundedChunks) {
+    //Given
+    const std::string cachePath = "test_stream.needlecache";
+    DataTable table(2);
+    for (int i = 0; i < 1000; ++i) table.addSample({static_cast<double>(i), -static_cast<double>(i)}, i % 2);
+    ASSERT_TRUE(datasetCache::save(cachePath, table, 0, 0, 0, 0.0, 1.0));
+    std::unique_ptr<StreamingDataset> stream = StreamingDataset::fromCache(cachePath, 64, 3);
+    stream->setSeed(5);
+
+    //When
+    std::vector<std::vector<double> > epochs(2);
+    size_t largestChunk = 0;
+    for (auto &order: epochs) {
+        stream->startEpoch();
+        DatasetView chunk;
+        while (stream->nextChunk(chunk)) {
+            largestChunk = std::max(largestChunk, chunk.size());
+            for (size_t i = 0; i < chunk.size(); ++i) {
+                ASSERT_EQ(chunk.features(i)[1], -chunk.features(i)[0]);
+                ASSERT_EQ(chunk.label(i), static_cast<double>(static_cast<int>(chunk.features(i)[0]) % 2));
+                order.push_back(chunk.features(i)[0]);
+            }
+        }
+    }
+
+    //Then
+    EXPECT_EQ(largestChunk, 64u);
+    EXPECT_NE(epochs[0], epochs[1]);
+    for (auto &order: epochs) {
+        ASSERT_EQ(order.size(), 1000u);
+        std::sort(order.begin(), order.end());
+        for (size_t i = 0; i < order.size(); ++i) EXPECT_EQ(order[i], static_cast<double>(i));
+    }
+
+    // Cleanup
+    std::remove(cachePath.c_str());
+}
+
+TEST(StreamingDataset, StreamsACsvFileLikeTheReader) {
+    //Given
+    const std::string filename = "test_stream.csv";
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file << "x,label\n";
+        for (int i = 0; i < 50000; ++i) file << i << ".5," << i % 4 << (i % 3 ? "\n" : "\r\n");
+        file << "50000.5,0";  // no line break at the end of the file
+    }
+    auto parseRow = [](const std::vector<CsvField> &row, double *features, double &label) {
+        csv::parseDouble(row[0], features[0]);
+        csv::parseDouble(row[1], label);
+    };
+    std::unique_ptr<StreamingDataset> stream = StreamingDataset::fromCsv(filename, 1, parseRow, 4096, 2);
+    stream->setShuffle(false);
+
+    //When
+    const DataTable expected = CsvReader(filename).readTable(1, parseRow);
+    std::vector<double> streamed, labels;
+    stream->startEpoch();
+    DatasetView chunk;
+    while (stream->nextChunk(chunk)) {
+        for (size_t i = 0; i < chunk.size(); ++i) {
+            streamed.push_back(chunk.features(i)[0]);
+            labels.push_back(chunk.label(i));
+        }
+    }
+
+    //Then
+    ASSERT_EQ(streamed.size(), 50001u);
+    EXPECT_EQ(labels, expected.labels());
+    EXPECT_EQ(streamed, std::vector<double>(expected.data(), expected.data() + expected.size()));
+
+    // Cleanup
+    std::remove(filename.c_str());
+}
+
+TEST(Trainer, TrainsOnAStream) {
+    //Given
+    const std::string cachePath = "test_stream_training.needlecache";
+    DataTable table(2);
+    for (int i = 0; i < 400; ++i) {
+        const double x = std::sin(static_cast<double>(i)), y = std::cos(1.7 * static_cast<double>(i));
+        table.addSample({x, y}, x + y > 0.0 ? 1.0 : 0.0);
+    }
+    ASSERT_TRUE(datasetCache::save(cachePath, table, 0, 0, 0, 0.0, 1.0));
+    std::unique_ptr<StreamingDataset> stream = StreamingDataset::fromCache(cachePath, 64, 2);
+    MultiClassClassifier model(2, {8}, 2);
+    auto loss = [](const std::vector<Node *> &logits, const double target) -> Node *{
+        return CategoricalCrossEntropyLoss::fromLogits(logits, static_cast<int>(target));
+    };
+    Trainer trainer(&model, loss, 0.1, 20, 8);
+    trainer.setTensorLossFunction([](Tensor *logits, const std::vector<double> &targets) -> Tensor *{
+        return CategoricalCrossEntropyLoss::fromLogits(logits, targets);
+    });
+    trainer.setVerbose(false);
+
+    //When
+    trainer.train(*stream, table);
+
+    //Then
+    const std::vector<double> &losses = trainer.getLossHistory();
+    ASSERT_EQ(losses.size(), 20u);
+    EXPECT_LT(losses.back(), 0.5 * losses.front());
+
+    // Cleanup
+    std::remove(cachePath.c_str());
+}
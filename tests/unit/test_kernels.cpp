@@ -0,0 +1,258 @@
+#include <gtest/gtest.h>
+#include <autoGradEngine/kernels/kernels.h>
+#include <autoGradEngine/kernels/gemm.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+    std::vector<double> randomValues(const size_t n, const double low, const double high, const unsigned seed) {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<double> distribution(low, high);
+        std::vector<double> values(n);
+        for (double &value: values) value = distribution(generator);
+        return values;
+    }
+
+    // Covers the empty input, every tail length of the widest vectors and a long run
+    std::vector<size_t> testSizes() {
+        std::vector<size_t> sizes;
+        for (size_t n = 0; n <= 37; ++n) sizes.push_back(n);
+        sizes.push_back(1000);
+        return sizes;
+    }
+}
+
+TEST(Kernels, ScalarTableIsAlwaysAvailable) {
+    //Given
+    const auto &tables = kernels::available();
+
+    //When
+    const kernels::KernelTable &active = kernels::active();
+
+    //Then
+    ASSERT_FALSE(tables.empty());
+    EXPECT_STREQ(tables.front()->name, "scalar");
+    EXPECT_NE(std::find(tables.begin(), tables.end(), &active), tables.end());
+}
+
+TEST(Kernels, EveryVariantMatchesTheScalarReference) {
+    const kernels::KernelTable &reference = kernels::scalarTable();
+
+    for (const kernels::KernelTable *table: kernels::available()) {
+        for (const size_t n: testSizes()) {
+            SCOPED_TRACE(std::string(table->name) + ", n = " + std::to_string(n));
+            //Given
+            const std::vector<double> a = randomValues(n, -3.0, 3.0, 1);
+            const std::vector<double> b = randomValues(n, -3.0, 3.0, 2);
+            const std::vector<double> start = randomValues(n, -1.0, 1.0, 3);
+
+            //When
+            std::vector<double> axpyExpected = start, axpyActual = start;
+            reference.axpy(0.75, a.data(), axpyExpected.data(), n);
+            table->axpy(0.75, a.data(), axpyActual.data(), n);
+
+            std::vector<double> addExpected = start, addActual = start;
+            reference.add(a.data(), addExpected.data(), n);
+            table->add(a.data(), addActual.data(), n);
+
+            std::vector<double> reluExpected(n), reluActual(n);
+            reference.relu(a.data(), reluExpected.data(), n);
+            table->relu(a.data(), reluActual.data(), n);
+
+            std::vector<double> backwardExpected = start, backwardActual = start;
+            reference.reluBackward(reluExpected.data(), b.data(), backwardExpected.data(), n);
+            table->reluBackward(reluExpected.data(), b.data(), backwardActual.data(), n);
+
+            std::vector<double> expExpected(n), expActual(n);
+            reference.exp(a.data(), expExpected.data(), n);
+            table->exp(a.data(), expActual.data(), n);
+
+            std::vector<double> sigmoidExpected(n), sigmoidActual(n);
+            reference.sigmoid(a.data(), sigmoidExpected.data(), n);
+            table->sigmoid(a.data(), sigmoidActual.data(), n);
+
+            //Then
+            const double dotExpected = reference.dot(a.data(), b.data(), n);
+            EXPECT_NEAR(table->dot(a.data(), b.data(), n), dotExpected, 1e-12 * (1.0 + static_cast<double>(n)));
+            for (size_t i = 0; i < n; ++i) {
+                EXPECT_NEAR(axpyActual[i], axpyExpected[i], 1e-14);
+                EXPECT_DOUBLE_EQ(addActual[i], addExpected[i]);
+                EXPECT_DOUBLE_EQ(reluActual[i], reluExpected[i]);
+                EXPECT_DOUBLE_EQ(backwardActual[i], backwardExpected[i]);
+                EXPECT_NEAR(expActual[i], expExpected[i], 1e-14 * expExpected[i]);
+                EXPECT_NEAR(sigmoidActual[i], sigmoidExpected[i], 1e-14);
+            }
+        }
+    }
+}
+
+TEST(Kernels, ExpStaysFiniteAtTheEdgesOfItsRange) {
+    //Given
+    const std::vector<double> x{-800.0, -708.0, -50.0, 0.0, 1e-300, 50.0, 700.0, 709.0};
+
+    for (const kernels::KernelTable *table: kernels::available()) {
+        SCOPED_TRACE(table->name);
+        std::vector<double> y(x.size());
+
+        //When
+        table->exp(x.data(), y.data(), x.size());
+
+        //Then
+        for (size_t i = 0; i < x.size(); ++i) {
+            EXPECT_TRUE(std::isfinite(y[i]));
+            EXPECT_GE(y[i], 0.0);
+        }
+        EXPECT_DOUBLE_EQ(y[3], 1.0);
+        EXPECT_NEAR(y[5], std::exp(50.0), 1e-13 * std::exp(50.0));
+        EXPECT_NEAR(y[6], std::exp(700.0), 1e-13 * std::exp(700.0));
+    }
+}
+
+TEST(Kernels, GemmMatchesTheNaiveProduct) {
+    using kernels::MatrixView;
+    struct Shape {
+        size_t m, n, k;
+    };
+    // Small products take the unblocked path, the others cover partial tiles, several depth blocks and row blocks
+    const std::vector<Shape> shapes{{3, 5, 7}, {17, 19, 23}, {97, 33, 300}, {200, 130, 64}, {1, 1100, 20}};
+    ThreadPool pool(3);
+    const kernels::KernelTable &initial = kernels::active();
+
+    for (const kernels::KernelTable *table: kernels::available()) {
+        kernels::use(*table);
+        for (const Shape &shape: shapes) {
+            for (const bool transposeB: {false, true}) {
+                for (ThreadPool *threads: {static_cast<ThreadPool *>(nullptr), &pool}) {
+                    SCOPED_TRACE(std::string(table->name) + " " + std::to_string(shape.m) + "x" +
+                        std::to_string(shape.n) + "x" + std::to_string(shape.k));
+                    //Given
+                    const std::vector<double> a = randomValues(shape.m * shape.k, -1.0, 1.0, 4);
+                    const std::vector<double> b = randomValues(shape.k * shape.n, -1.0, 1.0, 5);
+                    const MatrixView viewB = transposeB
+                                                 ? MatrixView::rowMajor(b.data(), shape.k).transposed()
+                                                 : MatrixView::rowMajor(b.data(), shape.n);
+                    std::vector<double> expected = randomValues(shape.m * shape.n, -1.0, 1.0, 6);
+                    std::vector<double> actual = expected;
+                    for (size_t i = 0; i < shape.m; ++i) {
+                        for (size_t j = 0; j < shape.n; ++j) {
+                            for (size_t p = 0; p < shape.k; ++p) {
+                                expected[i * shape.n + j] += 0.5 * a[i * shape.k + p] * viewB(p, j);
+                            }
+                        }
+                    }
+
+                    //When
+                    kernels::gemm(shape.m, shape.n, shape.k, 0.5, MatrixView::rowMajor(a.data(), shape.k), viewB,
+                                  actual.data(), shape.n, threads);
+
+                    //Then
+                    for (size_t i = 0; i < expected.size(); ++i) {
+                        ASSERT_NEAR(actual[i], expected[i], 1e-11) << "at " << i;
+                    }
+                }
+            }
+        }
+    }
+    kernels::use(initial);
+}
+
+TEST(Kernels, EveryFloatVariantMatchesTheScalarReference) {
+    const kernels::BasicKernelTable<float> &reference = kernels::scalarTable<float>();
+
+    for (const kernels::BasicKernelTable<float> *table: kernels::available<float>()) {
+        for (const size_t n: testSizes()) {
+            SCOPED_TRACE(std::string(table->name) + ", n = " + std::to_string(n));
+            //Given
+            const std::vector<double> a64 = randomValues(n, -3.0, 3.0, 1);
+            const std::vector<double> b64 = randomValues(n, -3.0, 3.0, 2);
+            const std::vector<float> a(a64.begin(), a64.end()), b(b64.begin(), b64.end());
+
+            //When
+            std::vector<float> axpyExpected(n, 0.5f), axpyActual(n, 0.5f);
+            reference.axpy(0.75f, a.data(), axpyExpected.data(), n);
+            table->axpy(0.75f, a.data(), axpyActual.data(), n);
+
+            std::vector<float> reluExpected(n), reluActual(n);
+            reference.relu(a.data(), reluExpected.data(), n);
+            table->relu(a.data(), reluActual.data(), n);
+
+            std::vector<float> expExpected(n), expActual(n);
+            reference.exp(a.data(), expExpected.data(), n);
+            table->exp(a.data(), expActual.data(), n);
+
+            std::vector<float> sigmoidExpected(n), sigmoidActual(n);
+            reference.sigmoid(a.data(), sigmoidExpected.data(), n);
+            table->sigmoid(a.data(), sigmoidActual.data(), n);
+
+            //Then
+            const float dotExpected = reference.dot(a.data(), b.data(), n);
+            EXPECT_NEAR(table->dot(a.data(), b.data(), n), dotExpected, 1e-5f * (1.0f + static_cast<float>(n)));
+            for (size_t i = 0; i < n; ++i) {
+                EXPECT_NEAR(axpyActual[i], axpyExpected[i], 1e-6f);
+                EXPECT_FLOAT_EQ(reluActual[i], reluExpected[i]);
+                EXPECT_NEAR(expActual[i], expExpected[i], 1e-6f * expExpected[i]);
+                EXPECT_NEAR(sigmoidActual[i], sigmoidExpected[i], 1e-6f);
+            }
+        }
+    }
+}
+
+TEST(Kernels, FloatGemmMatchesTheDoubleProduct) {
+    using FloatView = kernels::BasicMatrixView<float>;
+    const size_t m = 45, n = 70, k = 300;
+    const kernels::BasicKernelTable<float> &initial = kernels::active<float>();
+
+    for (const kernels::BasicKernelTable<float> *table: kernels::available<float>()) {
+        SCOPED_TRACE(table->name);
+        kernels::use(*table);
+        //Given
+        const std::vector<double> a = randomValues(m * k, -1.0, 1.0, 4);
+        const std::vector<double> b = randomValues(k * n, -1.0, 1.0, 5);
+        const std::vector<float> a32(a.begin(), a.end()), b32(b.begin(), b.end());
+        std::vector<double> expected(m * n, 0.0);
+        std::vector<float> actual(m * n, 0.0f);
+        kernels::gemm(m, n, k, 1.0, kernels::MatrixView::rowMajor(a.data(), k),
+                      kernels::MatrixView::rowMajor(b.data(), n), expected.data(), n, nullptr);
+
+        //When
+        kernels::gemm(m, n, k, 1.0, FloatView::rowMajor(a32.data(), k), FloatView::rowMajor(b32.data(), n),
+                      actual.data(), n, nullptr);
+
+        //Then
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_NEAR(actual[i], expected[i], 1e-4) << "at " << i;
+        }
+    }
+    kernels::use(initial);
+}
+
+TEST(Kernels, Int8DotMatchesTheScalarReference) {
+    for (const kernels::KernelTable *table: kernels::available()) {
+        for (const size_t n: testSizes()) {
+            SCOPED_TRACE(std::string(table->name) + ", n = " + std::to_string(n));
+            //Given
+            const std::vector<double> a64 = randomValues(n, -127.0, 127.0, 7);
+            const std::vector<double> b64 = randomValues(n, -127.0, 127.0, 8);
+            std::vector<int8_t> a(n), b(n);
+            for (size_t i = 0; i < n; ++i) {
+                a[i] = static_cast<int8_t>(a64[i]);
+                b[i] = static_cast<int8_t>(b64[i]);
+            }
+            // The extremes of the quantized range
+            if (n > 2) {
+                a[0] = 127;
+                b[0] = 127;
+                a[1] = -127;
+                b[1] = 127;
+            }
+
+            //When
+            const int32_t actual = table->dotInt8(a.data(), b.data(), n);
+
+            //Then
+            EXPECT_EQ(actual, kernels::scalar::dotInt8(a.data(), b.data(), n));
+        }
+    }
+}
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <nnComponents/lossFunctions/binaryCrossEntropy.h>
 #include <nnComponents/lossFunctions/categoricalCrossEntropy.h>
+#include <nnComponents/activations/softmax.h>
+#include <nnComponents/activations/sigmoidNode.h>
 #include <vector>
 
 TEST(LossFunctions, BCELossPerfectPrediction) {
@@ -74,3 +76,74 @@ TEST(LossFunctions, BCELossGradientDirection) {
     EXPECT_LT(pred.grad, 0.0);
     delete loss;
 }
+
+TEST(LossFunctions, FusedSoftmaxCrossEntropyMatchesUnfused) {
+    //Given
+    GraphScope scope;
+    Node a0(1.5), a1(-0.3), a2(0.8), b0(1.5), b1(-0.3), b2(0.8);
+    const int target = 2;
+
+    //When
+    Node *unfused = CategoricalCrossEntropyLoss::compute(softmax({&a0, &a1, &a2}), target);
+    unfused->backward();
+    Node *fused = CategoricalCrossEntropyLoss::fromLogits({&b0, &b1, &b2}, target);
+    fused->backward();
+
+    //Then
+    EXPECT_NEAR(fused->data, unfused->data, 1e-9);
+    EXPECT_NEAR(b0.grad, a0.grad, 1e-9);
+    EXPECT_NEAR(b1.grad, a1.grad, 1e-9);
+    EXPECT_NEAR(b2.grad, a2.grad, 1e-9);
+}
+
+TEST(LossFunctions, FusedSigmoidCrossEntropyMatchesUnfused) {
+    //Given
+    GraphScope scope;
+    Node a(0.7), b(0.7);
+    const double target = 0.0;
+
+    //When
+    Node *unfused = BinaryCrossEntropyLoss::compute(sigmoid(&a), target);
+    unfused->backward();
+    Node *fused = BinaryCrossEntropyLoss::fromLogits(&b, target);
+    fused->backward();
+
+    //Then
+    EXPECT_NEAR(fused->data, unfused->data, 1e-9);
+    EXPECT_NEAR(b.grad, a.grad, 1e-9);
+}
+
+TEST(LossFunctions, FusedTensorLossesMatchUnfused) {
+    //Given
+    GraphScope scope;
+    const std::vector<double> logits = {0.2, -1.0, 2.0, 1.1, 0.0, -0.4};
+    auto multiA = new Tensor(2, 3, logits), multiB = new Tensor(2, 3, logits);
+    auto binaryA = new Tensor(3, 1, {-2.0, 0.1, 3.0}), binaryB = new Tensor(3, 1, {-2.0, 0.1, 3.0});
+
+    //When
+    Tensor *cceUnfused = CategoricalCrossEntropyLoss::compute(softmax(multiA), {2, 0});
+    Tensor *cceFused = CategoricalCrossEntropyLoss::fromLogits(multiB, {2, 0});
+    Tensor *bceUnfused = BinaryCrossEntropyLoss::compute(sigmoid(binaryA), {0, 1, 1});
+    Tensor *bceFused = BinaryCrossEntropyLoss::fromLogits(binaryB, {0, 1, 1});
+    cceUnfused->backward();
+    cceFused->backward();
+    bceUnfused->backward();
+    bceFused->backward();
+
+    //Then
+    EXPECT_NEAR(cceFused->item(), cceUnfused->item(), 1e-9);
+    EXPECT_NEAR(bceFused->item(), bceUnfused->item(), 1e-9);
+    for (size_t i = 0; i < multiA->size(); ++i) EXPECT_NEAR(multiB->grad[i], multiA->grad[i], 1e-9);
+    for (size_t i = 0; i < binaryA->size(); ++i) EXPECT_NEAR(binaryB->grad[i], binaryA->grad[i], 1e-9);
+}
+
+TEST(LossFunctions, CCETensorLossRejectsBadTargets) {
+    //Given
+    GraphScope scope;
+    auto predictions = new Tensor(2, 3, {0.2, 0.5, 0.3, 0.1, 0.1, 0.8});
+
+    //When, Then
+    EXPECT_THROW(CategoricalCrossEntropyLoss::compute(predictions, {0, 3}), std::invalid_argument);
+    EXPECT_THROW(CategoricalCrossEntropyLoss::compute(predictions, {-1, 0}), std::invalid_argument);
+    EXPECT_THROW(CategoricalCrossEntropyLoss::compute(predictions, {0}), std::invalid_argument);
+}
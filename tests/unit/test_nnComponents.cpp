@@ -3,6 +3,7 @@
 #include <nnComponents/layer.h>
 #include <nnComponents/activations/relu.h>
 #include <nnComponents/activations/sigmoidNode.h>
+#include <utils/helperFunctions.h>
 #include <vector>
 
 TEST(Activations, ReLUZeroesNegative) {
@@ -88,3 +89,46 @@ TEST(Layer, ForwardPassDimensions) {
     for (auto *node: inputs) delete node;
     for (auto *node: outputs) delete node;
 }
+
+TEST(Layer, ParametersAreViewsOfDenseStorage) {
+    //Given
+    Layer l(3, 2, Activation::LINEAR);
+    std::vector<Node *> params = l.parameters();
+    std::vector<ParameterBlock> blocks = l.parameterBlocks();
+
+    //When
+    params.at(4)->data = 42.0; // neuron 1, weight 0
+    params.at(7)->data = -1.0; // neuron 1, bias
+
+    //Then
+    ASSERT_EQ(params.size(), 8u);
+    ASSERT_EQ(blocks.size(), 2u);
+    EXPECT_EQ(blocks.at(0).size, 6u);
+    EXPECT_EQ(blocks.at(1).size, 2u);
+    EXPECT_DOUBLE_EQ(l.getWeights()[3], 42.0);
+    EXPECT_DOUBLE_EQ(l.getBiases()[1], -1.0);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(l.getWeights()) % 64, 0u);
+}
+
+TEST(Layer, ScalarAndTensorGradientsAgree) {
+    //Given
+    GraphScope scope;
+    Layer l(3, 2, Activation::SIGMOID);
+    const std::vector<double> input = {0.3, -0.2, 0.9};
+
+    //When
+    l.clearGradients();
+    std::vector<Node *> outputs = l(helper::createInputNodes(input));
+    (*outputs.at(0) + *outputs.at(1))->backward();
+    std::vector<double> scalarGradients;
+    for (Node *p: l.parameters()) scalarGradients.push_back(p->grad);
+
+    l.clearGradients();
+    sum(l(new Tensor(1, 3, input)))->backward();
+
+    //Then
+    std::vector<Node *> params = l.parameters();
+    for (size_t i = 0; i < params.size(); ++i) {
+        EXPECT_NEAR(params.at(i)->grad, scalarGradients.at(i), 1e-12);
+    }
+}
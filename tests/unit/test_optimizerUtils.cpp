@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <nnComponents/optimizers/SGD.h>
+#include <nnComponents/optimizers/lossScaler.h>
 #include <nnComponents/module.h>
 #include <autoGradEngine/node.h>
 #include <vector>
@@ -66,3 +67,62 @@ TEST(SGD, LearningRateAccessors) {
     //Then
     EXPECT_DOUBLE_EQ(optimizer.getLearningRate(), 0.05);
 }
+
+TEST(SGD, AsynchronousStepScalesPrivateGradients) {
+    //Given
+    std::vector<double> weights = {1.0, 2.0, 3.0};
+    std::vector<double> sharedGradients(3, 0.0);
+    const std::vector<ParameterBlock> blocks = {{weights.data(), sharedGradients.data(), 2},
+                                                {weights.data() + 2, sharedGradients.data() + 2, 1}};
+    const std::vector<double> privateGradients = {4.0, 0.0, -2.0};
+    SGD optimizer(0.1);
+
+    //When
+    optimizer.stepAsynchronous(blocks, privateGradients.data(), 0.5);
+
+    //Then
+    EXPECT_DOUBLE_EQ(weights.at(0), 0.8);
+    EXPECT_DOUBLE_EQ(weights.at(1), 2.0);
+    EXPECT_DOUBLE_EQ(weights.at(2), 3.1);
+}
+
+TEST(SGD, MasterWeightsKeepUpdatesBelowTheFloatPrecision) {
+    //Given
+    std::vector<float> weights = {1.0f}, gradients = {1.0f};
+    std::vector<float> directWeights = {1.0f};
+    std::vector<double> master = {1.0};
+    const std::vector<BasicParameterBlock<float> > blocks = {{weights.data(), gradients.data(), 1}};
+    const std::vector<BasicParameterBlock<float> > directBlocks = {{directWeights.data(), gradients.data(), 1}};
+    BasicSGD<float> optimizer(1e-8);
+
+    //When
+    for (int i = 0; i < 10000; ++i) {
+        optimizer.step(master.data(), blocks, 1.0);
+        optimizer.step(directBlocks);
+    }
+
+    //Then
+    EXPECT_FLOAT_EQ(directWeights.at(0), 1.0f);
+    EXPECT_NEAR(master.at(0), 1.0 - 1e-4, 1e-12);
+    EXPECT_EQ(weights.at(0), static_cast<float>(master.at(0)));
+}
+
+TEST(LossScaler, BacksOffOnOverflowAndGrowsAfterFiniteSteps) {
+    //Given
+    LossScaler dynamic(1024.0, true, 2), fixed(1024.0, false);
+
+    //When
+    const bool overflowApplied = dynamic.update(false);
+    fixed.update(false);
+    const double afterOverflow = dynamic.getScale();
+    dynamic.update(true);
+    dynamic.update(true);
+
+    //Then
+    EXPECT_FALSE(overflowApplied);
+    EXPECT_DOUBLE_EQ(afterOverflow, 512.0);
+    EXPECT_DOUBLE_EQ(dynamic.getScale(), 1024.0);
+    EXPECT_EQ(dynamic.getSkippedSteps(), 1u);
+    EXPECT_DOUBLE_EQ(fixed.getScale(), 1024.0);
+    EXPECT_EQ(fixed.getSkippedSteps(), 1u);
+}
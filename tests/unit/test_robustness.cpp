@@ -2,6 +2,7 @@
 #include <autoGradEngine/node.h>
 #include <nnComponents/activations/softmax.h>
 #include <utils/serialization/modelSerializer.h>
+#include <utils/threadPool.h>
 
 TEST(Robustness, LogNodeHandlesZeroInput) {
     //Given
@@ -40,3 +41,18 @@ TEST(Robustness, LoadModelInvalidFile) {
     //Then
     EXPECT_FALSE(success);
 }
+
+TEST(Robustness, ThreadPoolRunsEveryIterationAndRethrows) {
+    //Given
+    ThreadPool pool(4);
+    std::vector<int> visits(1000, 0);
+
+    //When
+    pool.parallelFor(visits.size(), [&visits](const size_t i) { visits.at(i) += 1; });
+
+    //Then
+    for (const int count: visits) EXPECT_EQ(count, 1);
+    EXPECT_THROW(pool.parallelFor(8, [](const size_t i) {
+        if (i == 5) throw std::runtime_error("failed iteration");
+    }), std::runtime_error);
+}
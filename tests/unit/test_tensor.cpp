@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include <autoGradEngine/tensor.h>
+#include <nnComponents/layer.h>
+#include <nnComponents/activations/softmax.h>
+#include <nnComponents/lossFunctions/binaryCrossEntropy.h>
+#include <nnComponents/lossFunctions/categoricalCrossEntropy.h>
+#include <utils/helperFunctions.h>
+#include <vector>
+
+TEST(Tensor, MatmulForward) {
+    //Given
+    GraphScope scope;
+    Tensor a(2, 3, std::vector<double>{1, 2, 3, 4, 5, 6});
+    Tensor b(3, 2, std::vector<double>{7, 8, 9, 10, 11, 12});
+
+    //When
+    Tensor *c = matmul(&a, &b);
+
+    //Then
+    EXPECT_DOUBLE_EQ(c->at(0, 0), 58.0);
+    EXPECT_DOUBLE_EQ(c->at(0, 1), 64.0);
+    EXPECT_DOUBLE_EQ(c->at(1, 0), 139.0);
+    EXPECT_DOUBLE_EQ(c->at(1, 1), 154.0);
+}
+
+TEST(Tensor, MatmulBackward) {
+    //Given
+    GraphScope scope;
+    Tensor a(1, 2, std::vector<double>{3, 4});
+    Tensor b(2, 1, std::vector<double>{5, 6});
+
+    //When
+    sum(matmul(&a, &b))->backward();
+
+    //Then
+    EXPECT_DOUBLE_EQ(a.grad[0], 5.0);
+    EXPECT_DOUBLE_EQ(a.grad[1], 6.0);
+    EXPECT_DOUBLE_EQ(b.grad[0], 3.0);
+    EXPECT_DOUBLE_EQ(b.grad[1], 4.0);
+}
+
+TEST(Tensor, BiasIsBroadcastOverRows) {
+    //Given
+    GraphScope scope;
+    Tensor x(2, 2, std::vector<double>{1, 2, 3, 4});
+    Tensor bias(1, 2, std::vector<double>{10, 20});
+
+    //When
+    Tensor *y = addBias(&x, &bias);
+    sum(y)->backward();
+
+    //Then
+    EXPECT_DOUBLE_EQ(y->at(1, 1), 24.0);
+    EXPECT_DOUBLE_EQ(bias.grad[0], 2.0);
+    EXPECT_DOUBLE_EQ(x.grad[3], 1.0);
+}
+
+TEST(Tensor, MeanBackwardAveragesGradient) {
+    //Given
+    GraphScope scope;
+    Tensor x(1, 4, std::vector<double>{1, 2, 3, 6});
+
+    //When
+    Tensor *m = mean(&x);
+    m->backward();
+
+    //Then
+    EXPECT_DOUBLE_EQ(m->item(), 3.0);
+    EXPECT_DOUBLE_EQ(x.grad[2], 0.25);
+}
+
+TEST(Tensor, SoftmaxMatchesScalarEngine) {
+    //Given
+    GraphScope scope;
+    const std::vector<double> values = {0.5, -1.0, 2.0};
+    Tensor logits(1, 3, values);
+    std::vector<Node *> logitNodes = helper::createInputNodes(values);
+
+    //When
+    Tensor *probabilities = softmax(&logits);
+    Tensor::logTensor(selectColumns(probabilities, {1}))->backward();
+    std::vector<Node *> probabilityNodes = softmax(logitNodes);
+    Node::logNode(probabilityNodes.at(1))->backward();
+
+    //Then
+    for (size_t i = 0; i < values.size(); ++i) {
+        EXPECT_NEAR(probabilities->data[i], probabilityNodes.at(i)->data, 1e-12);
+        EXPECT_NEAR(logits.grad[i], logitNodes.at(i)->grad, 1e-12);
+    }
+}
+
+TEST(Tensor, LayerForwardMatchesScalarEngine) {
+    //Given
+    GraphScope scope;
+    Layer layer(3, 4, Activation::SIGMOID);
+    const std::vector<double> input = {0.2, -0.7, 1.3};
+
+    //When
+    std::vector<Node *> nodeOutputs = layer(helper::createInputNodes(input));
+    Tensor *tensorOutputs = layer(new Tensor(1, 3, input));
+
+    //Then
+    ASSERT_EQ(tensorOutputs->cols, nodeOutputs.size());
+    for (size_t i = 0; i < nodeOutputs.size(); ++i) {
+        EXPECT_NEAR(tensorOutputs->data[i], nodeOutputs.at(i)->data, 1e-12);
+    }
+}
+
+TEST(Tensor, LayerBackwardReachesParameters) {
+    //Given
+    GraphScope scope;
+    Layer layer(2, 3, Activation::LINEAR);
+    layer.clearGradients();
+
+    //When
+    sum(layer(new Tensor(2, 2, std::vector<double>{1.0, 2.0, 3.0, 4.0})))->backward();
+
+    //Then
+    // Every neuron sees both samples: dL/dw_j = sum of x_j, dL/db = batch size
+    auto params = layer.parameters();
+    EXPECT_DOUBLE_EQ(params.at(0)->grad, 4.0);
+    EXPECT_DOUBLE_EQ(params.at(1)->grad, 6.0);
+    EXPECT_DOUBLE_EQ(params.at(2)->grad, 2.0);
+}
+
+TEST(Tensor, BatchedLossesAverageOverSamples) {
+    //Given
+    GraphScope scope;
+    Tensor predictions(2, 1, std::vector<double>{0.9, 0.2});
+    Tensor distributions(2, 3, std::vector<double>{0.1, 0.8, 0.1, 0.5, 0.25, 0.25});
+
+    //When
+    Tensor *bce = BinaryCrossEntropyLoss::compute(&predictions, {1.0, 0.0});
+    Tensor *cce = CategoricalCrossEntropyLoss::compute(&distributions, {1.0, 0.0});
+
+    //Then
+    EXPECT_NEAR(bce->item(), -(std::log(0.9) + std::log(0.8)) / 2.0, 1e-9);
+    EXPECT_NEAR(cce->item(), -(std::log(0.8) + std::log(0.5)) / 2.0, 1e-9);
+}
+
+TEST(Tensor, OperationsRejectIncompatibleShapes) {
+    //Given
+    GraphScope scope;
+    Tensor a(2, 3, std::vector<double>{1, 2, 3, 4, 5, 6});
+    Tensor b(2, 2, std::vector<double>{1, 2, 3, 4});
+    Tensor bias(1, 3, std::vector<double>{1, 2, 3});
+
+    //When, Then
+    EXPECT_THROW(matmul(&a, &a), std::invalid_argument);
+    EXPECT_THROW(linear(&a, &b, &bias), std::invalid_argument);
+    EXPECT_THROW(linear(&a, &a, &bias), std::invalid_argument);
+    EXPECT_THROW(addBias(&b, &bias), std::invalid_argument);
+    EXPECT_THROW(a + b, std::invalid_argument);
+    EXPECT_THROW(a * b, std::invalid_argument);
+    EXPECT_THROW(Tensor(2, 2, std::vector<double>{1, 2, 3}), std::invalid_argument);
+    EXPECT_NO_THROW(addBias(&a, &bias));
+}
@@ -0,0 +1,63 @@
+#ifndef ALIGNEDALLOCATOR_H
+#define ALIGNEDALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+/**
+ * An allocator for std::vector that aligns the first element to @p Alignment bytes. Dense parameter matrices and
+ * activation buffers use it so that every row starts on a cache line and can be loaded with aligned vector instructions.
+ *
+ * @tparam T - The element type
+ * @tparam Alignment - The alignment in bytes, a power of two (64 is the size of a cache line)
+ */
+template<typename T, std::size_t Alignment = 64>
+class AlignedAllocator {
+public:
+    using value_type = T;
+
+    template<typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {
+    }
+
+    T *allocate(const std::size_t n) {
+        // Over-allocate, align by hand and remember the original pointer right before the aligned block
+        const std::size_t bytes = n * sizeof(T) + Alignment + sizeof(void *);
+        void *raw = ::operator new(bytes);
+        const auto start = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void *);
+        const std::uintptr_t aligned = (start + Alignment - 1) & ~static_cast<std::uintptr_t>(Alignment - 1);
+        reinterpret_cast<void **>(aligned)[-1] = raw;
+        return reinterpret_cast<T *>(aligned);
+    }
+
+    void deallocate(T *pointer, std::size_t) noexcept {
+        if (pointer) {
+            ::operator delete(reinterpret_cast<void **>(pointer)[-1]);
+        }
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment> &) const noexcept {
+        return true;
+    }
+
+    template<typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment> &) const noexcept {
+        return false;
+    }
+};
+
+template<typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T> >;
+
+#endif //ALIGNEDALLOCATOR_H
@@ -1,55 +1,93 @@
 #ifndef DATASET_H
 #define DATASET_H
 #include "nnComponents/trainers/trainer.h"
+#include <utils/io/mappedFile.h>
+#include <utils/datasets/datasetCache.h>
 
 /**
  * The following file should serve as an interface for the dataset objects, so that every dataset loader function
- * operates under the same API.
+ * operates under the same API. The samples are kept in a DataTable, which loaders fill row by row.
  */
 class Dataset {
 protected:
-    DatasetFormat data;
+    DataTable data;
     double min;
     double max;
 
 public:
     virtual ~Dataset() = default;
 
-    explicit Dataset(const DatasetFormat& data) {
-        this->data = data;
+    explicit Dataset(DataTable data) : data(std::move(data)), min(0.0), max(0.0) {
     }
-    virtual DatasetFormat loadData(std::string filepath) = 0;
+
+    /**
+     * @brief Loads @p filepath with loadData() and normalizes it, going through the binary cache of the file (see
+     * datasetCache) when @p useCache is set: a cache that matches the content of the file is read instead of the
+     * file, and otherwise the file is parsed and a new cache is written next to it.
+     *
+     * @param filepath - The source file of the dataset
+     * @param loaderName - Tells the caches of different loaders of the same file apart
+     * @param useCache - Whether to read and write the cache
+     */
+    void loadNormalized(const std::string &filepath, const std::string &loaderName, const bool useCache) {
+        if (!useCache) {
+            data = loadData(filepath);
+            minMaxNormalization(data);
+            return;
+        }
+
+        uint64_t sourceSize, sourceHash;
+        {
+            const MappedFile source(filepath);
+            sourceSize = source.size();
+            sourceHash = datasetCache::hashContents(source.data(), source.size());
+        }
+        const std::string cachePath = datasetCache::pathFor(filepath);
+        const uint64_t loaderTag = datasetCache::hashContents(loaderName);
+        if (datasetCache::load(cachePath, sourceSize, sourceHash, loaderTag, data, min, max)) {
+            return;
+        }
+
+        data = loadData(filepath);
+        minMaxNormalization(data);
+        // The cache only saves time, so a directory that can not be written to is not an error
+        datasetCache::save(cachePath, data, sourceSize, sourceHash, loaderTag, min, max);
+    }
+    virtual DataTable loadData(std::string filepath) = 0;
     virtual int getNumClasses() = 0;
 
 
-    DatasetFormat getData() {
+    /**
+     * @return The samples, which live as long as the dataset object
+     */
+    const DataTable &getData() const {
         return data;
     }
 
     int getNumFeatures() {
-        return static_cast<int>(this->data.at(0).first.size());
+        return static_cast<int>(this->data.featureCount());
     };
 
-    void minMaxNormalization(DatasetFormat &dataset) {
+    void minMaxNormalization(DataTable &dataset) {
+        if (dataset.empty()) return;
+
         // We are going to apply min-max normalization (rescaling) in the interval [0, 1]
-        // Step 1: Find the min and max elements
-        double min = dataset.at(0).first[0];
-        double max = dataset.at(0).first[0];
-
-        for (const auto& sample: dataset) {
-            for(auto i: sample.first) {
-                min = std::min(min, i);
-                max = std::max(max, i);
-            }
+        // Step 1: Find the min and max elements, in a single pass over the contiguous feature matrix
+        double *values = dataset.data();
+        const size_t count = dataset.size() * dataset.featureCount();
+        double min = values[0];
+        double max = values[0];
+
+        for (size_t i = 0; i < count; ++i) {
+            min = std::min(min, values[i]);
+            max = std::max(max, values[i]);
         }
 
         this->min = min;
         this->max = max;
 
-        for (auto& sample: dataset) {
-            for(auto& i: sample.first) {
-                i = (i - min) / (max - min);
-            }
+        for (size_t i = 0; i < count; ++i) {
+            values[i] = (values[i] - min) / (max - min);
         }
     }
 };
@@ -0,0 +1,115 @@
+#ifndef BATCHPRODUCER_H
+#define BATCHPRODUCER_H
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <utils/alignedAllocator.h>
+#include <utils/producerRing.h>
+#include <utils/datasets/dataTable.h>
+
+/**
+ * A mini-batch that is ready to enter the network: its features gathered into one contiguous, aligned (rows x
+ * features) block in the scalar type of the network, a zeroed block of the same shape for the gradient that the
+ * backward pass leaves on the inputs, and the targets.
+ */
+template<typename Scalar>
+struct BasicPreparedBatch {
+    size_t first = 0; // the position of the first sample of the batch in the view it was taken from
+    size_t rows = 0;
+    size_t cols = 0;
+    AlignedVector<Scalar> features;
+    AlignedVector<Scalar> gradients;
+    std::vector<double> targets;
+
+    /**
+     * @brief Gathers the samples [begin, end) of @p samples into this batch. The buffers only grow, so a batch that is
+     * refilled with batches of the same size does not allocate.
+     */
+    void fill(const DatasetView &samples, const size_t begin, const size_t end) {
+        first = begin;
+        rows = end - begin;
+        cols = samples.featureCount();
+        features.resize(std::max(features.size(), rows * cols));
+        gradients.resize(std::max(gradients.size(), rows * cols));
+        samples.gather(begin, end, features.data());
+        std::fill(gradients.begin(), gradients.begin() + rows * cols, Scalar(0));
+        targets.resize(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            targets[i] = samples.label(begin + i);
+        }
+    }
+};
+
+/**
+ * Cuts the samples of an epoch into mini-batches and prepares them ahead of the training step. With a depth of two or
+ * more, a producer thread gathers the next batches into a ring of that many buffers (double or triple buffering)
+ * while the current one trains, so the gathering of the shuffled rows is off the critical path of the step. With a
+ * depth of zero, every batch is gathered by next() on the calling thread.
+ */
+template<typename Scalar>
+class BasicBatchProducer {
+    std::unique_ptr<ProducerRing<BasicPreparedBatch<Scalar> > > ring;
+    BasicPreparedBatch<Scalar> inlineBatch;
+    DatasetView samples;
+    size_t batchSize;
+    size_t position;
+
+public:
+    /**
+     * @param depth - The number of batches in flight, 0 to prepare them on the calling thread
+     */
+    explicit BasicBatchProducer(const size_t depth = 3) : batchSize(1), position(0) {
+        if (depth > 0) ring.reset(new ProducerRing<BasicPreparedBatch<Scalar> >(depth));
+    }
+
+    /**
+     * @return The number of batches in flight, 0 if they are prepared on the calling thread
+     */
+    size_t depth() const {
+        return ring ? ring->depth() : 0;
+    }
+
+    /**
+     * @brief Starts cutting @p view into batches of @p size samples. The previous epoch is abandoned, and the table of
+     * @p view must outlive the epoch.
+     */
+    void start(const DatasetView &view, const size_t size) {
+        if (ring) ring->stop();
+        samples = view;
+        batchSize = std::max<size_t>(1, size);
+        position = 0;
+        if (ring) {
+            ring->start([this](BasicPreparedBatch<Scalar> &batch) {
+                if (position >= samples.size()) return false;
+                const size_t end = std::min(samples.size(), position + batchSize);
+                batch.fill(samples, position, end);
+                position = end;
+                return true;
+            });
+        }
+    }
+
+    /**
+     * @brief Hands out the next batch of the epoch, waiting for it if it is not ready yet.
+     *
+     * @return - The batch, valid until the next call, or nullptr at the end of the epoch
+     */
+    BasicPreparedBatch<Scalar> *next() {
+        if (ring) return ring->next();
+        if (position >= samples.size()) return nullptr;
+        const size_t end = std::min(samples.size(), position + batchSize);
+        inlineBatch.fill(samples, position, end);
+        position = end;
+        return &inlineBatch;
+    }
+
+    /**
+     * @brief Stops preparing batches, for example when an epoch is abandoned.
+     */
+    void stop() {
+        if (ring) ring->stop();
+    }
+};
+
+#endif //BATCHPRODUCER_H
@@ -0,0 +1,338 @@
+#ifndef CSVREADER_H
+#define CSVREADER_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <stdexcept>
+#include <algorithm>
+#include <utils/io/mappedFile.h>
+#include <utils/threadPool.h>
+#include <utils/datasets/dataTable.h>
+
+/**
+ * A field of a CSV row: a range of characters inside the mapped file, which is never copied into a string.
+ */
+struct CsvField {
+    const char *begin;
+    const char *end;
+
+    size_t size() const {
+        return static_cast<size_t>(end - begin);
+    }
+
+    bool empty() const {
+        return begin == end;
+    }
+
+    /**
+     * @return The first character of the field, or '\0' for an empty field
+     */
+    char front() const {
+        return empty() ? '\0' : *begin;
+    }
+
+    bool operator==(const char *text) const {
+        const size_t length = std::strlen(text);
+        return size() == length && std::memcmp(begin, text, length) == 0;
+    }
+
+    bool operator!=(const char *text) const {
+        return !(*this == text);
+    }
+
+    std::string str() const {
+        return std::string(begin, end);
+    }
+};
+
+namespace csv {
+    /**
+     * @brief Parses a decimal number that spans the whole of [begin, end), surrounding blanks aside. Numbers with up
+     * to 15 significant digits and a decimal exponent of at most 22 (which covers the values of nearly every dataset)
+     * are converted with a single exact multiplication or division, so the result is correctly rounded. Anything else,
+     * including "inf" and "nan", goes through std::strtod.
+     *
+     * @return - Whether the field held a number
+     */
+    inline bool parseDouble(const char *begin, const char *end, double &value) {
+        static const double powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                             1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        while (begin < end && (*begin == ' ' || *begin == '\t')) ++begin;
+        while (end > begin && (end[-1] == ' ' || end[-1] == '\t')) --end;
+
+        const char *p = begin;
+        const bool negative = p < end && *p == '-';
+        if (p < end && (*p == '-' || *p == '+')) ++p;
+
+        uint64_t mantissa = 0;
+        int significantDigits = 0, exponent = 0;
+        bool anyDigit = false, exact = true;
+        auto addDigit = [&](const int digit, const bool fraction) {
+            anyDigit = true;
+            if (significantDigits >= 15) {
+                // Rounding the remaining digits correctly is left to strtod
+                exact = exact && digit == 0;
+                if (!fraction) ++exponent;
+                return;
+            }
+            mantissa = mantissa * 10 + static_cast<uint64_t>(digit);
+            if (mantissa > 0) ++significantDigits;
+            if (fraction) --exponent;
+        };
+        for (; p < end && *p >= '0' && *p <= '9'; ++p) addDigit(*p - '0', false);
+        if (p < end && *p == '.') {
+            for (++p; p < end && *p >= '0' && *p <= '9'; ++p) addDigit(*p - '0', true);
+        }
+        if (anyDigit && p < end && (*p == 'e' || *p == 'E')) {
+            ++p;
+            const bool negativeExponent = p < end && *p == '-';
+            if (p < end && (*p == '-' || *p == '+')) ++p;
+            int written = 0;
+            bool exponentDigit = false;
+            for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+                exponentDigit = true;
+                written = std::min(written * 10 + (*p - '0'), 100000);
+            }
+            anyDigit = exponentDigit;
+            exponent += negativeExponent ? -written : written;
+        }
+
+        if (anyDigit && p == end && exact && exponent >= -22 && exponent <= 22) {
+            const double magnitude = static_cast<double>(mantissa);
+            value = exponent < 0 ? magnitude / powersOfTen[-exponent] : magnitude * powersOfTen[exponent];
+            if (negative) value = -value;
+            return true;
+        }
+
+        // The slow path needs a terminated copy, since the field is followed by the rest of the file
+        if (begin == end) return false;
+        const std::string text(begin, end);
+        char *parsedEnd = nullptr;
+        value = std::strtod(text.c_str(), &parsedEnd);
+        return parsedEnd == text.c_str() + text.size();
+    }
+
+    inline bool parseDouble(const CsvField &field, double &value) {
+        return parseDouble(field.begin, field.end, value);
+    }
+
+    /**
+     * @brief Splits the line [begin, end) into @p fields at every @p delimiter.
+     */
+    inline void splitFields(const char *begin, const char *end, const char delimiter, std::vector<CsvField> &fields) {
+        fields.clear();
+        const char *start = begin;
+        for (const char *p = begin; p < end; ++p) {
+            if (*p == delimiter) {
+                fields.push_back(CsvField{start, p});
+                start = p + 1;
+            }
+        }
+        fields.push_back(CsvField{start, end});
+    }
+}
+
+/**
+ * Turns the fields of a CSV row into a sample: parseRow(fields, features, label) fills the features and the label.
+ */
+using CsvRowParser = std::function<void(const std::vector<CsvField> &, double *, double &)>;
+
+/**
+ * A reader for large CSV files. The file is mapped into memory and every row is split into CsvFields that point into
+ * the mapping, so reading a row allocates nothing. Numbers are parsed in place with csv::parseDouble.
+ *
+ * readTable() cuts the file into chunks at line boundaries and parses them on several threads, straight into the rows
+ * of a DataTable. Fields are separated by a single delimiter character and can not be quoted. Lines may end with
+ * "\n" or "\r\n", and empty lines are skipped.
+ */
+class CsvReader {
+    MappedFile file;
+    char delimiter;
+    const char *bodyBegin; // the first character after the header line
+    const char *bodyEnd;
+    std::vector<CsvField> headerFields;
+
+    // Files smaller than this are parsed on the calling thread, unless a pool is given
+    static constexpr size_t parallelThreshold = 16 * 1024 * 1024;
+    // The smallest chunk that is worth handing to a thread
+    static constexpr size_t minimumChunk = 1024 * 1024;
+
+    /**
+     * @return The end of the line that starts at @p line, before its line break
+     */
+    const char *lineEnd(const char *line) const {
+        const void *newline = std::memchr(line, '\n', static_cast<size_t>(bodyEnd - line));
+        const char *end = newline ? static_cast<const char *>(newline) : bodyEnd;
+        return end > line && end[-1] == '\r' ? end - 1 : end;
+    }
+
+    /**
+     * @return The start of the line that follows the line break after @p position, or the end of the file
+     */
+    const char *nextLine(const char *position) const {
+        const void *newline = std::memchr(position, '\n', static_cast<size_t>(bodyEnd - position));
+        return newline ? static_cast<const char *>(newline) + 1 : bodyEnd;
+    }
+
+    /**
+     * @return The 1-based number of the line of the file that starts at @p line, counting the header and blank lines.
+     * It counts the line breaks before the line, so it is only meant for error messages.
+     */
+    size_t lineNumber(const char *line) const {
+        return 1 + static_cast<size_t>(std::count(reinterpret_cast<const char *>(file.data()), line, '\n'));
+    }
+
+    void split(const char *begin, const char *end, std::vector<CsvField> &fields) const {
+        csv::splitFields(begin, end, delimiter, fields);
+    }
+
+    /**
+     * @return The boundaries of @p count chunks of the body, each of them starting at the beginning of a line
+     */
+    std::vector<const char *> chunkBoundaries(const size_t count) const {
+        std::vector<const char *> boundaries(1, bodyBegin);
+        const size_t length = static_cast<size_t>(bodyEnd - bodyBegin);
+        for (size_t k = 1; k < count; ++k) {
+            const char *cut = std::max(boundaries.back(), bodyBegin + length * k / count);
+            // A cut at the previous boundary or right after a line break already is the start of a line
+            boundaries.push_back(cut == boundaries.back() || cut[-1] == '\n' ? cut : nextLine(cut));
+        }
+        boundaries.push_back(bodyEnd);
+        return boundaries;
+    }
+
+public:
+    /**
+     * @param filepath - The CSV file
+     * @param delimiter - The character between two fields
+     * @param hasHeader - Whether the first line names the columns instead of holding a row
+     * @throws std::runtime_error - If the file can not be opened
+     */
+    explicit CsvReader(const std::string &filepath, const char delimiter = ',', const bool hasHeader = true)
+        : file(filepath), delimiter(delimiter) {
+        bodyBegin = reinterpret_cast<const char *>(file.data());
+        bodyEnd = bodyBegin + file.size();
+        if (hasHeader && bodyBegin != bodyEnd) {
+            split(bodyBegin, lineEnd(bodyBegin), headerFields);
+            bodyBegin = nextLine(bodyBegin);
+        }
+    }
+
+    /**
+     * @return The fields of the header line, empty for files without one
+     */
+    const std::vector<CsvField> &header() const {
+        return headerFields;
+    }
+
+    /**
+     * @return The number of fields of the first row, or of the header if there are no rows
+     */
+    size_t columnCount() const {
+        std::vector<CsvField> fields;
+        for (const char *line = bodyBegin; line < bodyEnd; line = nextLine(line)) {
+            const char *end = lineEnd(line);
+            if (end == line) continue;
+            split(line, end, fields);
+            return fields.size();
+        }
+        return headerFields.size();
+    }
+
+    /**
+     * @brief Calls @p handler with the fields of every row, in the order of the file, on the calling thread.
+     *
+     * @param handler - Called as handler(const std::vector<CsvField> &fields)
+     */
+    template<typename Handler>
+    void forEachRow(Handler handler) const {
+        std::vector<CsvField> fields;
+        for (const char *line = bodyBegin; line < bodyEnd; line = nextLine(line)) {
+            const char *end = lineEnd(line);
+            if (end == line) continue;
+            split(line, end, fields);
+            handler(fields);
+        }
+    }
+
+    /**
+     * @brief Parses every row into a sample of a DataTable. The body of the file is cut into chunks at line
+     * boundaries; a first parallel pass counts the rows of every chunk, so that the table is allocated once, and a
+     * second one parses every chunk into its own rows of the table.
+     *
+     * @param featureCount - The number of features of a sample
+     * @param parseRow - Called as parseRow(const std::vector<CsvField> &fields, double *features, double &label) for
+     * every row, possibly from several threads at once. It fills the featureCount features and the label of the
+     * sample and may throw to reject the row.
+     * @param pool - The threads that parse the chunks. Without one, files of 16 MB and more are parsed on a pool of
+     * every hardware thread, smaller files on the calling thread.
+     * @throws std::runtime_error - If a row does not have as many fields as the first one, naming its line in the file
+     */
+    template<typename RowParser>
+    DataTable readTable(const size_t featureCount, RowParser parseRow, ThreadPool *pool = nullptr) const {
+        const size_t length = static_cast<size_t>(bodyEnd - bodyBegin);
+        std::unique_ptr<ThreadPool> ownPool;
+        if (!pool && length >= parallelThreshold) {
+            ownPool.reset(new ThreadPool());
+            pool = ownPool.get();
+        }
+        const size_t chunkCount = pool ? std::max<size_t>(1, std::min(4 * pool->size(), length / minimumChunk)) : 1;
+        const std::vector<const char *> boundaries = chunkBoundaries(chunkCount);
+        const size_t columns = columnCount();
+
+        auto run = [pool, chunkCount](const std::function<void(size_t)> &body) {
+            if (pool) {
+                pool->parallelFor(chunkCount, body);
+            } else {
+                for (size_t k = 0; k < chunkCount; ++k) body(k);
+            }
+        };
+
+        // Counts the rows of every chunk and turns the counts into the first row of every chunk
+        std::vector<size_t> firstRow(chunkCount + 1, 0);
+        run([this, &boundaries, &firstRow](const size_t k) {
+            size_t rows = 0;
+            for (const char *line = boundaries[k]; line < boundaries[k + 1]; line = nextLine(line)) {
+                if (lineEnd(line) != line) ++rows;
+            }
+            firstRow[k + 1] = rows;
+        });
+        for (size_t k = 0; k < chunkCount; ++k) firstRow[k + 1] += firstRow[k];
+
+        DataTable table(featureCount);
+        table.resize(firstRow.back());
+        run([this, &boundaries, &firstRow, &table, &parseRow, columns](const size_t k) {
+            std::vector<CsvField> fields;
+            size_t row = firstRow[k];
+            for (const char *line = boundaries[k]; line < boundaries[k + 1]; line = nextLine(line)) {
+                const char *end = lineEnd(line);
+                if (end == line) continue;
+                split(line, end, fields);
+                if (fields.size() != columns) {
+                    throw std::runtime_error("CSV line " + std::to_string(lineNumber(line)) + " has " +
+                                             std::to_string(fields.size()) + " fields instead of " +
+                                             std::to_string(columns));
+                }
+                double label = 0.0;
+                parseRow(fields, table.features(row), label);
+                table.setLabel(row, label);
+                ++row;
+            }
+        });
+        return table;
+    }
+
+    /**
+     * @return The size of the file in bytes
+     */
+    size_t size() const {
+        return file.size();
+    }
+};
+
+#endif //CSVREADER_H
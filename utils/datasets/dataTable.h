@@ -0,0 +1,286 @@
+#ifndef DATATABLE_H
+#define DATATABLE_H
+
+#include <vector>
+#include <memory>
+#include <random>
+#include <numeric>
+#include <utility>
+#include <stdexcept>
+#include <algorithm>
+#include <utils/alignedAllocator.h>
+
+using DatasetFormat = std::vector<std::pair<std::vector<double>, double> >;
+
+/**
+ * @brief Shuffles @p indices with the Fisher-Yates algorithm. Unlike std::shuffle and the standard distributions,
+ * whose algorithms are left to the implementation, the output of mt19937_64 is fixed by the standard, so a seed gives
+ * the same order with every compiler. The modulo is biased by less than size / 2^64, which is negligible.
+ */
+inline void shuffleIndices(std::vector<size_t> &indices, std::mt19937_64 &generator) {
+    for (size_t i = indices.size(); i > 1; --i) {
+        std::swap(indices[i - 1], indices[static_cast<size_t>(generator() % i)]);
+    }
+}
+
+/**
+ * The storage of a dataset: one contiguous (rows x features) row-major matrix of features and one array of labels.
+ * Compared with a DatasetFormat, where every sample owns a vector of its own, a table takes one allocation for all of
+ * its features, carries no per-sample overhead and hands whole batches to the kernels as plain matrices.
+ *
+ * Subsets of a table, such as the training split or a mini-batch, are DatasetViews, which never copy the samples.
+ */
+class DataTable {
+    size_t width;
+    AlignedVector<double> values;
+    std::vector<double> targets;
+
+public:
+    DataTable() : width(0) {
+    }
+
+    /**
+     * @param featureCount - The number of features of every sample
+     * @param capacity - The number of samples to reserve room for
+     */
+    explicit DataTable(const size_t featureCount, const size_t capacity = 0) : width(featureCount) {
+        reserve(capacity);
+    }
+
+    /**
+     * @brief Converts samples in the row-per-vector format, so that existing datasets can be passed wherever a table
+     * is expected.
+     */
+    DataTable(const DatasetFormat &samples) : width(samples.empty() ? 0 : samples.front().first.size()) {
+        reserve(samples.size());
+        for (const auto &sample: samples) {
+            addSample(sample.first, sample.second);
+        }
+    }
+
+    void reserve(const size_t capacity) {
+        values.reserve(capacity * width);
+        targets.reserve(capacity);
+    }
+
+    /**
+     * @brief Sets the number of samples. New samples have zero features and labels, for loaders that fill the rows
+     * in place, possibly from several threads.
+     */
+    void resize(const size_t rows) {
+        values.resize(rows * width);
+        targets.resize(rows);
+    }
+
+    /**
+     * @brief Appends a sample. The first sample of a table without a feature count sets it.
+     *
+     * @param features - The featureCount() features of the sample
+     * @param label - The target of the sample
+     */
+    void addSample(const double *features, const double label) {
+        values.insert(values.end(), features, features + width);
+        targets.push_back(label);
+    }
+
+    /**
+     * @throws std::invalid_argument - If the sample does not have featureCount() features
+     */
+    void addSample(const std::vector<double> &features, const double label) {
+        if (targets.empty() && width == 0) {
+            width = features.size();
+        }
+        if (features.size() != width) {
+            throw std::invalid_argument("All the samples of a dataset must have the same number of features");
+        }
+        addSample(features.data(), label);
+    }
+
+    /**
+     * @brief Appends every sample of @p other.
+     */
+    void append(const DataTable &other) {
+        if (other.empty()) return;
+        if (empty() && width == 0) {
+            width = other.width;
+        }
+        if (other.width != width) {
+            throw std::invalid_argument("All the samples of a dataset must have the same number of features");
+        }
+        values.insert(values.end(), other.values.begin(), other.values.end());
+        targets.insert(targets.end(), other.targets.begin(), other.targets.end());
+    }
+
+    size_t size() const {
+        return targets.size();
+    }
+
+    bool empty() const {
+        return targets.empty();
+    }
+
+    size_t featureCount() const {
+        return width;
+    }
+
+    const double *features(const size_t row) const {
+        return values.data() + row * width;
+    }
+
+    double *features(const size_t row) {
+        return values.data() + row * width;
+    }
+
+    double label(const size_t row) const {
+        return targets[row];
+    }
+
+    void setLabel(const size_t row, const double value) {
+        targets[row] = value;
+    }
+
+    /**
+     * @return The (size() x featureCount()) row-major matrix of features
+     */
+    const double *data() const {
+        return values.data();
+    }
+
+    double *data() {
+        return values.data();
+    }
+
+    const std::vector<double> &labels() const {
+        return targets;
+    }
+};
+
+/**
+ * A subset of the samples of a DataTable, either a range of rows or a list of row indices, in the order in which they
+ * are visited. A view is a few words large: slicing it, for example into mini-batches, shares its index list instead
+ * of copying it. The table must outlive every view of it.
+ */
+class DatasetView {
+    const DataTable *table;
+    std::shared_ptr<const std::vector<size_t> > indices; // null for a range of rows
+    size_t first;  // the first row of a range, or the first position in the index list
+    size_t count;
+
+public:
+    DatasetView() : table(nullptr), first(0), count(0) {
+    }
+
+    /**
+     * @brief A view of every row of @p table.
+     */
+    DatasetView(const DataTable &table) : table(&table), first(0), count(table.size()) {
+    }
+
+    /**
+     * @brief A view of the rows [begin, end) of @p table.
+     */
+    DatasetView(const DataTable &table, const size_t begin, const size_t end)
+        : table(&table), first(begin), count(end - begin) {
+        if (begin > end || end > table.size()) {
+            throw std::out_of_range("The range of a dataset view must lie within its table");
+        }
+    }
+
+    /**
+     * @brief A view of the rows of @p table listed in @p rows, in that order.
+     */
+    DatasetView(const DataTable &table, std::vector<size_t> rows)
+        : table(&table), first(0), count(rows.size()) {
+        for (const size_t row: rows) {
+            if (row >= table.size()) throw std::out_of_range("A dataset view refers to a row outside of its table");
+        }
+        indices = std::make_shared<const std::vector<size_t> >(std::move(rows));
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    size_t featureCount() const {
+        return table ? table->featureCount() : 0;
+    }
+
+    /**
+     * @return Whether the samples of the view are consecutive rows of the table, see rows()
+     */
+    bool contiguous() const {
+        return !indices;
+    }
+
+    /**
+     * @return The row of the table that holds the sample at position @p i of the view
+     */
+    size_t row(const size_t i) const {
+        return indices ? (*indices)[first + i] : first + i;
+    }
+
+    const double *features(const size_t i) const {
+        return table->features(row(i));
+    }
+
+    double label(const size_t i) const {
+        return table->label(row(i));
+    }
+
+    /**
+     * @return The (size() x featureCount()) matrix of features of a contiguous view, in place
+     */
+    const double *rows() const {
+        return table->features(first);
+    }
+
+    /**
+     * @brief The samples at the positions [begin, end) of this view, without copying them.
+     */
+    DatasetView slice(const size_t begin, const size_t end) const {
+        if (begin > end || end > count) {
+            throw std::out_of_range("The slice of a dataset view must lie within the view");
+        }
+        DatasetView view(*this);
+        view.first = first + begin;
+        view.count = end - begin;
+        return view;
+    }
+
+    /**
+     * @brief The samples of this view in a random order, for example a fresh order for every epoch. Only the row
+     * indices are permuted, the samples stay where they are in the table.
+     */
+    DatasetView shuffled(std::mt19937_64 &generator) const {
+        std::vector<size_t> rows(count);
+        for (size_t i = 0; i < count; ++i) rows[i] = row(i);
+        shuffleIndices(rows, generator);
+        DatasetView view;
+        view.table = table;
+        view.count = count;
+        view.indices = std::make_shared<const std::vector<size_t> >(std::move(rows));
+        return view;
+    }
+
+    /**
+     * @brief Copies the features of the samples [begin, end) of this view into a row-major matrix, converting them to
+     * the type of @p destination.
+     */
+    template<typename Scalar>
+    void gather(const size_t begin, const size_t end, Scalar *destination) const {
+        const size_t n = featureCount();
+        if (contiguous()) {
+            std::copy(features(begin), features(begin) + (end - begin) * n, destination);
+            return;
+        }
+        for (size_t i = begin; i < end; ++i, destination += n) {
+            std::copy(features(i), features(i) + n, destination);
+        }
+    }
+};
+
+#endif //DATATABLE_H
@@ -0,0 +1,171 @@
+#ifndef DATASETCACHE_H
+#define DATASETCACHE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <stdexcept>
+#include <utils/io/mappedFile.h>
+#include <utils/datasets/dataTable.h>
+
+/**
+ * The binary cache of a dataset that was loaded from a text file. It holds the samples exactly as the loader left
+ * them, encoded and normalized, so that later runs skip the parsing. A file starts with a 128-byte Header, followed by
+ * the (rows x features) row-major matrix of features and by the labels, both in double and 64-byte aligned.
+ *
+ * A cache belongs to one source file and one loader: it is only used while the size and the content hash of the
+ * source and the tag of the loader match the ones recorded in its header.
+ */
+namespace datasetCache {
+    constexpr char magic[8] = {'N', 'E', 'E', 'D', 'L', 'E', 'D', 'S'};
+    constexpr uint32_t version = 1;
+    constexpr uint32_t byteOrderMark = 0x01020304;
+    constexpr uint64_t alignment = 64;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint64_t rows;
+        uint64_t featureCount;
+        uint64_t sourceSize;
+        uint64_t sourceHash;
+        uint64_t loaderTag;
+        uint64_t fileSize;
+        double minimum;  // the range of the min-max normalization
+        double maximum;
+        uint8_t reserved[48];
+    };
+
+    static_assert(sizeof(Header) == 128, "The header of a dataset cache takes 128 bytes");
+
+    /**
+     * @brief Where the cache of @p source lives: next to it, with an extra extension.
+     */
+    inline std::string pathFor(const std::string &source) {
+        return source + ".needlecache";
+    }
+
+    /**
+     * @brief A 64-bit hash of @p size bytes, FNV-1a over 64-bit words with the high half of the state folded back in
+     * after every word. Going through the data eight bytes at a time hashes a large source file at memory speed.
+     */
+    inline uint64_t hashContents(const unsigned char *data, const size_t size) {
+        const uint64_t prime = 1099511628211ull;
+        uint64_t hash = 14695981039346656037ull;
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            hash = (hash ^ word) * prime;
+            hash ^= hash >> 32;
+        }
+        for (; i < size; ++i) {
+            hash = (hash ^ data[i]) * prime;
+        }
+        return (hash ^ size) * prime;
+    }
+
+    inline uint64_t hashContents(const std::string &text) {
+        return hashContents(reinterpret_cast<const unsigned char *>(text.data()), text.size());
+    }
+
+    inline uint64_t labelsOffset(const uint64_t rows, const uint64_t featureCount) {
+        const uint64_t end = sizeof(Header) + rows * featureCount * sizeof(double);
+        return (end + alignment - 1) / alignment * alignment;
+    }
+
+    /**
+     * @brief Writes the cache of a dataset. The file is written under a temporary name and renamed at the end, so a
+     * concurrent run never maps a half-written cache.
+     *
+     * @param path - The cache file, see pathFor()
+     * @param table - The samples, after encoding and normalization
+     * @param sourceSize - The size of the source file
+     * @param sourceHash - The hashContents() of the source file
+     * @param loaderTag - The hashContents() of the name of the loader
+     * @param minimum - The lower bound of the normalization range
+     * @param maximum - The upper bound of the normalization range
+     * @return - True if the cache was written
+     */
+    inline bool save(const std::string &path, const DataTable &table, const uint64_t sourceSize,
+                     const uint64_t sourceHash, const uint64_t loaderTag, const double minimum,
+                     const double maximum) {
+        Header header{};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version = version;
+        header.byteOrder = byteOrderMark;
+        header.rows = table.size();
+        header.featureCount = table.featureCount();
+        header.sourceSize = sourceSize;
+        header.sourceHash = sourceHash;
+        header.loaderTag = loaderTag;
+        header.minimum = minimum;
+        header.maximum = maximum;
+        const uint64_t labels = labelsOffset(header.rows, header.featureCount);
+        header.fileSize = labels + header.rows * sizeof(double);
+
+        const std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) return false;
+            const char zeros[alignment] = {};
+            const uint64_t featureBytes = header.rows * header.featureCount * sizeof(double);
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char *>(table.data()), static_cast<std::streamsize>(featureBytes));
+            file.write(zeros, static_cast<std::streamsize>(labels - sizeof(Header) - featureBytes));
+            file.write(reinterpret_cast<const char *>(table.labels().data()),
+                       static_cast<std::streamsize>(header.rows * sizeof(double)));
+            if (!file) {
+                file.close();
+                std::remove(temporary.c_str());
+                return false;
+            }
+        }
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Maps the cache at @p path and reads it into @p table if it was made from the current source file by the
+     * same loader.
+     *
+     * @return - False if there is no cache, or if it is stale or invalid, in which case nothing is changed
+     */
+    inline bool load(const std::string &path, const uint64_t sourceSize, const uint64_t sourceHash,
+                     const uint64_t loaderTag, DataTable &table, double &minimum, double &maximum) {
+        if (!std::ifstream(path).good()) return false;
+        const MappedFile file(path);
+        if (file.size() < sizeof(Header)) return false;
+        const Header *header = reinterpret_cast<const Header *>(file.data());
+        const bool current = std::memcmp(header->magic, magic, sizeof(magic)) == 0 && header->version == version &&
+                             header->byteOrder == byteOrderMark && header->sourceSize == sourceSize &&
+                             header->sourceHash == sourceHash && header->loaderTag == loaderTag &&
+                             header->fileSize == file.size() && header->featureCount > 0 &&
+                             labelsOffset(header->rows, header->featureCount) + header->rows * sizeof(double) ==
+                             file.size();
+        if (!current) return false;
+
+        const double *features = reinterpret_cast<const double *>(file.data() + sizeof(Header));
+        const double *labels = reinterpret_cast<const double *>(
+            file.data() + labelsOffset(header->rows, header->featureCount));
+        DataTable cached(static_cast<size_t>(header->featureCount));
+        cached.resize(static_cast<size_t>(header->rows));
+        std::memcpy(cached.data(), features, header->rows * header->featureCount * sizeof(double));
+        for (size_t row = 0; row < cached.size(); ++row) {
+            cached.setLabel(row, labels[row]);
+        }
+
+        table = std::move(cached);
+        minimum = header->minimum;
+        maximum = header->maximum;
+        return true;
+    }
+}
+
+#endif //DATASETCACHE_H
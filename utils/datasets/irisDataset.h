@@ -2,45 +2,40 @@
 #define IRISDATASET_H
 
 #include <vector>
-#include <algorithm>  // std::shuffle
-#include <random>     // std::mt19937, std::random_device
+#include <stdexcept>
 
 #include <utils/datasets/Dataset.h>
+#include <utils/datasets/csvReader.h>
 
 class IrisDataset final: public Dataset {
 public:
-    explicit IrisDataset(const std::string& filepath) : Dataset(IrisDataset::loadData(filepath)) {
-        minMaxNormalization(this->data);
+    /**
+     * @param filepath - The CSV file
+     * @param useCache - Whether to keep the parsed dataset in a binary cache next to the file, see loadNormalized()
+     */
+    explicit IrisDataset(const std::string& filepath, const bool useCache = true) : Dataset(DataTable()) {
+        loadNormalized(filepath, "iris", useCache);
     }
 
-     DatasetFormat loadData(std::string filepath) override{
-        std::string line;
-        std::vector<std::string> tokenizedRow;
-        DatasetFormat data;
-        std::vector<double> properties;
-        std::ifstream inputFile(filepath);
-
-        getline(inputFile, line);
+    /**
+     * @brief Reads the Iris CSV file: an id column, the four measurements and the name of the species.
+     */
+    DataTable loadData(std::string filepath) override{
+        const CsvReader reader(filepath);
+        const size_t columns = reader.columnCount();
+        if (columns < 3) {
+            throw std::runtime_error("The Iris dataset needs an id, the features and a class in every row");
+        }
 
-        while(getline(inputFile, line)) {
-            size_t start = 0;
-            for (size_t i = 0; i < line.length(); i++) {
-                if(line.at(i) == ',') {
-                    tokenizedRow.push_back(line.substr(start, i-start));
-                    start = i + 1;
-                }else if(i == line.length()-1) {
-                    tokenizedRow.push_back(line.substr(start, i+1-start));
+        return reader.readTable(columns - 2, [columns](const std::vector<CsvField> &row, double *features,
+                                                        double &irisClass) {
+            for (size_t j = 1; j < columns - 1; j++) {
+                if (!csv::parseDouble(row[j], features[j - 1])) {
+                    throw std::runtime_error("Invalid Iris measurement: " + row[j].str());
                 }
             }
 
-            for(size_t j = 1; j < tokenizedRow.size()-1; j++) {
-                auto value = std::stod(tokenizedRow.at(j));
-                properties.push_back(value);
-            }
-
-            double irisClass;
-            const std::string className = tokenizedRow.at(tokenizedRow.size()-1);
-
+            const CsvField &className = row[columns - 1];
             if(className == "Iris-setosa") {
                 irisClass = 0;
             }else if(className == "Iris-versicolor") {
@@ -48,13 +43,7 @@ public:
             }else {
                 irisClass = 2;
             }
-
-            data.emplace_back(properties, irisClass);
-            properties.clear();
-            tokenizedRow.clear();
-        }
-
-        return data;
+        });
     }
 
     int getNumClasses() override{
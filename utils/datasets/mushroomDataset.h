@@ -1,47 +1,40 @@
 #ifndef MUSHROOMDATASETLOADER_H
 #define MUSHROOMDATASETLOADER_H
 #include <vector>
-#include <fstream>
+#include <stdexcept>
 #include <utils/datasets/Dataset.h>
+#include <utils/datasets/csvReader.h>
 
 class MushroomDataset final : public Dataset {
 public:
-    explicit MushroomDataset(const std::string& filepath) : Dataset(MushroomDataset::loadData(filepath)) {
-        minMaxNormalization(this->data);
+    /**
+     * @param filepath - The CSV file
+     * @param useCache - Whether to keep the parsed dataset in a binary cache next to the file, see loadNormalized()
+     */
+    explicit MushroomDataset(const std::string& filepath, const bool useCache = true) : Dataset(DataTable()) {
+        loadNormalized(filepath, "mushroom", useCache);
     }
 
-    DatasetFormat loadData(std::string filepath) override{
-        std::string line;
-        std::vector<std::string> tokenizedRow;
-        DatasetFormat data;
-        std::vector<double> properties;
-        std::ifstream inputFile(filepath);
-
-        getline(inputFile, line);
-
-        while(getline(inputFile, line)) {
-            size_t start = 0;
-            for (size_t i = 0; i < line.length(); i++) {
-                if(line.at(i) == ',') {
-                    tokenizedRow.push_back(line.substr(start, i-start));
-                    start = i + 1;
-                }else if(i == line.length()-1) {
-                    tokenizedRow.push_back(line.substr(start, 1));
-                }
-            }
+    /**
+     * @brief Reads the Mushroom CSV file: the class ('e' for edible) followed by one letter per attribute, which
+     * becomes its distance from 'a'.
+     */
+    DataTable loadData(std::string filepath) override{
+        const CsvReader reader(filepath);
+        const size_t columns = reader.columnCount();
+        if (columns < 2) {
+            throw std::runtime_error("The Mushroom dataset needs a class and the features in every row");
+        }
 
-            for(size_t j = 1; j < tokenizedRow.size(); j++) {
-                auto value = tokenizedRow.at(j).c_str()[0] - 'a' >= 0 ? tokenizedRow.at(j).c_str()[0] - 'a' : 0;
-                properties.push_back(value);
+        return reader.readTable(columns - 1, [columns](const std::vector<CsvField> &row, double *features,
+                                                        double &mushroomClass) {
+            for(size_t j = 1; j < columns; j++) {
+                const char value = row[j].front();
+                features[j - 1] = value - 'a' >= 0 ? value - 'a' : 0;
             }
 
-            auto mushroomClass = tokenizedRow.at(0) == "e" ? 1 : 0;
-            data.emplace_back(properties, mushroomClass);
-            properties.clear();
-            tokenizedRow.clear();
-        }
-
-        return data;
+            mushroomClass = row[0] == "e" ? 1 : 0;
+        });
     }
 
     int getNumClasses() override{
@@ -0,0 +1,326 @@
+#ifndef STREAMINGDATASET_H
+#define STREAMINGDATASET_H
+
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <utils/producerRing.h>
+#include <utils/datasets/dataTable.h>
+#include <utils/datasets/datasetCache.h>
+#include <utils/datasets/csvReader.h>
+
+/**
+ * Samples that are read from disk a chunk at a time, for datasets that do not fit in memory.
+ */
+class ChunkSource {
+public:
+    virtual ~ChunkSource() = default;
+
+    virtual size_t featureCount() const = 0;
+
+    /**
+     * @brief Goes back to the first sample.
+     */
+    virtual void rewind() = 0;
+
+    /**
+     * @brief Reads the next samples into @p chunk, which has featureCount() features, replacing its rows.
+     *
+     * @return - The number of samples read, at most @p maxRows and zero once every sample was read
+     */
+    virtual size_t read(DataTable &chunk, size_t maxRows) = 0;
+};
+
+/**
+ * Streams the samples of a dataset cache (see datasetCache), which are already encoded and normalized.
+ */
+class CacheChunkSource final : public ChunkSource {
+    std::ifstream file;
+    datasetCache::Header header;
+    uint64_t nextRow;
+    std::vector<double> labels;
+
+public:
+    /**
+     * @throws std::runtime_error - If the file can not be opened or is not a dataset cache
+     */
+    explicit CacheChunkSource(const std::string &path) : header(), nextRow(0) {
+        using namespace datasetCache;
+        file.open(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open dataset cache: " + path);
+        }
+        const uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+        file.seekg(0);
+        file.read(reinterpret_cast<char *>(&header), sizeof(header));
+        if (!file || std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version ||
+            header.byteOrder != byteOrderMark || header.featureCount == 0 || header.fileSize != fileSize ||
+            labelsOffset(header.rows, header.featureCount) + header.rows * sizeof(double) != fileSize) {
+            throw std::runtime_error("Invalid dataset cache: " + path);
+        }
+    }
+
+    size_t featureCount() const override {
+        return static_cast<size_t>(header.featureCount);
+    }
+
+    void rewind() override {
+        nextRow = 0;
+    }
+
+    size_t read(DataTable &chunk, const size_t maxRows) override {
+        const size_t rows = static_cast<size_t>(std::min<uint64_t>(maxRows, header.rows - nextRow));
+        chunk.resize(rows);
+        if (rows == 0) return 0;
+
+        const uint64_t width = header.featureCount;
+        file.seekg(static_cast<std::streamoff>(sizeof(datasetCache::Header) + nextRow * width * sizeof(double)));
+        file.read(reinterpret_cast<char *>(chunk.data()), static_cast<std::streamsize>(rows * width * sizeof(double)));
+        labels.resize(rows);
+        file.seekg(static_cast<std::streamoff>(datasetCache::labelsOffset(header.rows, width) +
+                                               nextRow * sizeof(double)));
+        file.read(reinterpret_cast<char *>(labels.data()), static_cast<std::streamsize>(rows * sizeof(double)));
+        if (!file) {
+            throw std::runtime_error("Failed to read the dataset cache");
+        }
+
+        for (size_t row = 0; row < rows; ++row) chunk.setLabel(row, labels[row]);
+        nextRow += rows;
+        return rows;
+    }
+};
+
+/**
+ * Streams the rows of a CSV file, which is read in blocks of 1 MB. Only the current block and the line that crosses
+ * its end are held in memory. The rows are tokenized like in CsvReader and turned into samples by a CsvRowParser.
+ */
+class CsvChunkSource final : public ChunkSource {
+    std::ifstream file;
+    size_t width;
+    CsvRowParser parseRow;
+    char delimiter;
+    bool hasHeader;
+    std::vector<char> pending;
+    size_t position;
+    bool endOfFile;
+    size_t columns;
+    size_t lineNumber; // the line of the file that was read last, counting the header and blank lines
+    std::vector<CsvField> fields;
+
+    // The number of bytes read from the file at a time
+    static constexpr size_t blockSize = 1024 * 1024;
+
+    /**
+     * @brief Finds the next line, reading from the file as needed.
+     *
+     * @return - False at the end of the file
+     */
+    bool nextLine(const char *&begin, const char *&end) {
+        while (true) {
+            const char *data = pending.data();
+            const void *newline = position < pending.size()
+                                      ? std::memchr(data + position, '\n', pending.size() - position)
+                                      : nullptr;
+            if (newline || (endOfFile && position < pending.size())) {
+                begin = data + position;
+                end = newline ? static_cast<const char *>(newline) : data + pending.size();
+                position = newline ? static_cast<size_t>(end - data) + 1 : pending.size();
+                if (end > begin && end[-1] == '\r') --end;
+                ++lineNumber;
+                return true;
+            }
+            if (endOfFile) return false;
+
+            // Keeps the start of the unfinished line and appends the next block to it
+            pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(std::min(position,
+                                                                                                   pending.size())));
+            position = 0;
+            const size_t kept = pending.size();
+            pending.resize(kept + blockSize);
+            file.read(pending.data() + kept, static_cast<std::streamsize>(blockSize));
+            const size_t received = static_cast<size_t>(file.gcount());
+            pending.resize(kept + received);
+            endOfFile = received < blockSize;
+        }
+    }
+
+public:
+    /**
+     * @param path - The CSV file
+     * @param featureCount - The number of features of a sample
+     * @param parseRow - Turns the fields of a row into a sample, see CsvReader::readTable
+     * @param delimiter - The character between two fields
+     * @param hasHeader - Whether the first line names the columns instead of holding a row
+     * @throws std::runtime_error - If the file can not be opened
+     */
+    CsvChunkSource(const std::string &path, const size_t featureCount, CsvRowParser parseRow,
+                   const char delimiter = ',', const bool hasHeader = true)
+        : file(path, std::ios::binary), width(featureCount), parseRow(std::move(parseRow)), delimiter(delimiter),
+          hasHeader(hasHeader), position(0), endOfFile(false), columns(0), lineNumber(0) {
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file: " + path);
+        }
+        rewind();
+    }
+
+    size_t featureCount() const override {
+        return width;
+    }
+
+    void rewind() override {
+        file.clear();
+        file.seekg(0);
+        pending.clear();
+        position = 0;
+        endOfFile = false;
+        lineNumber = 0;
+        const char *begin, *end;
+        if (hasHeader) nextLine(begin, end);
+    }
+
+    /**
+     * @throws std::runtime_error - If a row does not have as many fields as the first one
+     */
+    size_t read(DataTable &chunk, const size_t maxRows) override {
+        chunk.resize(maxRows);
+        size_t rows = 0;
+        const char *begin, *end;
+        while (rows < maxRows && nextLine(begin, end)) {
+            if (begin == end) continue;
+            csv::splitFields(begin, end, delimiter, fields);
+            if (columns == 0) columns = fields.size();
+            if (fields.size() != columns) {
+                throw std::runtime_error("CSV line " + std::to_string(lineNumber) + " has " +
+                                         std::to_string(fields.size()) + " fields instead of " +
+                                         std::to_string(columns));
+            }
+            double label = 0.0;
+            parseRow(fields, chunk.features(rows), label);
+            chunk.setLabel(rows, label);
+            ++rows;
+        }
+        chunk.resize(rows);
+        return rows;
+    }
+};
+
+/**
+ * A dataset that is streamed from disk instead of loaded, so that its size is not limited by memory. A background
+ * thread reads the source chunk by chunk into a bounded ring of buffers while the consumer trains on the chunks it
+ * already read, so I/O overlaps with compute. The memory taken by the samples is bufferCount x chunkRows samples,
+ * whatever the size of the file.
+ *
+ * The samples are shuffled within a window of one chunk: every chunk is handed out as a view of its rows in a random
+ * order. The chunks themselves come in the order of the file, so the window should be large compared with runs of
+ * similar samples in the file.
+ */
+class StreamingDataset {
+    std::unique_ptr<ChunkSource> source;
+    size_t rowsPerChunk;
+    std::unique_ptr<ProducerRing<DataTable> > buffers;
+    bool shuffle;
+    std::mt19937_64 generator;
+
+public:
+    /**
+     * @param source - Where the samples are read from
+     * @param chunkRows - The number of samples in a chunk, best a multiple of the batch size
+     * @param bufferCount - The number of chunks held in memory, at least 2: one that is consumed and one that is read
+     */
+    explicit StreamingDataset(std::unique_ptr<ChunkSource> source, const size_t chunkRows = 65536,
+                              const size_t bufferCount = 4)
+        : source(std::move(source)), rowsPerChunk(std::max<size_t>(1, chunkRows)), shuffle(true),
+          generator(std::random_device()()) {
+        if (!this->source) {
+            throw std::invalid_argument("A streaming dataset needs a source");
+        }
+        buffers.reset(new ProducerRing<DataTable>(bufferCount, DataTable(this->source->featureCount(), rowsPerChunk)));
+    }
+
+    /**
+     * @brief Streams a dataset cache, see Dataset::loadNormalized.
+     */
+    static std::unique_ptr<StreamingDataset> fromCache(const std::string &path, const size_t chunkRows = 65536,
+                                                       const size_t bufferCount = 4) {
+        return std::unique_ptr<StreamingDataset>(new StreamingDataset(
+            std::unique_ptr<ChunkSource>(new CacheChunkSource(path)), chunkRows, bufferCount));
+    }
+
+    /**
+     * @brief Streams a CSV file, see CsvChunkSource.
+     */
+    static std::unique_ptr<StreamingDataset> fromCsv(const std::string &path, const size_t featureCount,
+                                                     CsvRowParser parseRow, const size_t chunkRows = 65536,
+                                                     const size_t bufferCount = 4) {
+        return std::unique_ptr<StreamingDataset>(new StreamingDataset(
+            std::unique_ptr<ChunkSource>(new CsvChunkSource(path, featureCount, std::move(parseRow))), chunkRows,
+            bufferCount));
+    }
+
+    ~StreamingDataset() {
+        // The reader uses the source, so it stops before the source is destroyed
+        buffers.reset();
+    }
+
+    StreamingDataset(const StreamingDataset &) = delete;
+
+    StreamingDataset &operator=(const StreamingDataset &) = delete;
+
+    size_t featureCount() const {
+        return source->featureCount();
+    }
+
+    size_t chunkRows() const {
+        return rowsPerChunk;
+    }
+
+    size_t bufferCount() const {
+        return buffers->depth();
+    }
+
+    /**
+     * @brief Seeds the order of the samples within every chunk.
+     */
+    void setSeed(const uint64_t seed) {
+        generator.seed(seed);
+    }
+
+    /**
+     * @brief Enables or disables the shuffling of the samples within every chunk (enabled by default).
+     */
+    void setShuffle(const bool enable) {
+        shuffle = enable;
+    }
+
+    /**
+     * @brief Rewinds the source and starts reading it in the background. An epoch that was not read to the end is
+     * abandoned.
+     */
+    void startEpoch() {
+        buffers->stop();
+        source->rewind();
+        buffers->start([this](DataTable &chunk) { return source->read(chunk, rowsPerChunk) > 0; });
+    }
+
+    /**
+     * @brief Hands out the next chunk of the epoch and gives the previous one back to the I/O thread. It waits for
+     * the chunk if the I/O thread has not read it yet.
+     *
+     * @param chunk - Receives a view of the samples of the chunk, valid until the next call or the next epoch
+     * @return - False once the whole source was handed out
+     * @throws - The exception of the source, if reading it failed
+     */
+    bool nextChunk(DatasetView &chunk) {
+        DataTable *table = buffers->next();
+        if (!table) return false;
+        chunk = shuffle ? DatasetView(*table).shuffled(generator) : DatasetView(*table);
+        return true;
+    }
+};
+
+#endif //STREAMINGDATASET_H
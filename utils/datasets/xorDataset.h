@@ -8,13 +8,13 @@ public:
 
     XORDataset() : Dataset(XORDataset::loadData("")){}
 
-    DatasetFormat loadData(std::string filepath) override{
-        DatasetFormat data;
+    DataTable loadData(std::string filepath) override{
+        DataTable data(2, 4);
 
-        data.push_back({{0.0, 0.0}, 0.0});  // 0 XOR 0 = 0
-        data.push_back({{0.0, 1.0}, 1.0});  // 0 XOR 1 = 1
-        data.push_back({{1.0, 0.0}, 1.0});  // 1 XOR 0 = 1
-        data.push_back({{1.0, 1.0}, 0.0});  // 1 XOR 1 = 0
+        data.addSample({0.0, 0.0}, 0.0);  // 0 XOR 0 = 0
+        data.addSample({0.0, 1.0}, 1.0);  // 0 XOR 1 = 1
+        data.addSample({1.0, 0.0}, 1.0);  // 1 XOR 0 = 1
+        data.addSample({1.0, 1.0}, 0.0);  // 1 XOR 1 = 0
 
         return data;
     }
@@ -2,6 +2,8 @@
 #define HELPERFUNCTIONS_H
 #include <vector>
 #include <autoGradEngine/node.h>
+#include <utils/alignedAllocator.h>
+#include <utils/datasets/dataTable.h>
 
 namespace helper {
     template<typename T>
@@ -14,17 +16,53 @@ namespace helper {
         return -1;
     }
 
-    inline std::vector<Node *> createInputNodes(const std::vector<double> &inputs) {
-        std::vector<Node *> inputNodes;
+    template<typename Scalar = double>
+    std::vector<BasicNode<Scalar> *> createInputNodes(const std::vector<double> &inputs) {
+        std::vector<BasicNode<Scalar> *> inputNodes;
         inputNodes.reserve(inputs.size());
         for (const double val: inputs) {
-            inputNodes.push_back(new Node(val));
+            inputNodes.push_back(new BasicNode<Scalar>(static_cast<Scalar>(val)));
         }
         return inputNodes;
     }
 
-    inline void deleteInputNodes(std::vector<Node *> &nodes) {
-        for (const Node *node: nodes) {
+    /**
+     * @return The values of @p values in the precision of @p Scalar. Doubles are used in place, any other type is
+     * converted into @p buffer.
+     */
+    template<typename Scalar>
+    const Scalar *scalarData(const std::vector<double> &values, std::vector<Scalar> &buffer) {
+        buffer.assign(values.begin(), values.end());
+        return buffer.data();
+    }
+
+    inline const double *scalarData(const std::vector<double> &values, std::vector<double> &) {
+        return values.data();
+    }
+
+    /**
+     * @return The features of the samples [begin, end) of @p view as a row-major matrix in the precision of @p Scalar.
+     * The rows of a contiguous view of doubles are used in place, anything else is gathered into @p buffer.
+     */
+    template<typename Scalar>
+    const Scalar *scalarRows(const DatasetView &view, const size_t begin, const size_t end,
+                             AlignedVector<Scalar> &buffer) {
+        buffer.resize((end - begin) * view.featureCount());
+        view.gather(begin, end, buffer.data());
+        return buffer.data();
+    }
+
+    inline const double *scalarRows(const DatasetView &view, const size_t begin, const size_t end,
+                                    AlignedVector<double> &buffer) {
+        if (view.contiguous()) return view.features(begin);
+        buffer.resize((end - begin) * view.featureCount());
+        view.gather(begin, end, buffer.data());
+        return buffer.data();
+    }
+
+    template<typename Scalar>
+    void deleteInputNodes(std::vector<BasicNode<Scalar> *> &nodes) {
+        for (const BasicNode<Scalar> *node: nodes) {
             delete node;
         }
     }
@@ -0,0 +1,120 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <stdexcept>
+#include <fstream>
+#include <utils/alignedAllocator.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define NEEDLE_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * A read-only view of a whole file. On POSIX systems the file is mapped into memory with mmap, so opening it costs
+ * nothing up front and its pages are only read from disk (or shared from the page cache) when they are touched.
+ * Elsewhere the file is read into a 64-byte aligned buffer, which gives the same interface at the cost of a copy.
+ *
+ * The first byte of the view is aligned to at least 64 bytes in both cases, so data that is aligned within the file
+ * stays aligned in memory.
+ */
+class MappedFile {
+    const unsigned char *bytes;
+    size_t length;
+#ifndef NEEDLE_HAS_MMAP
+    AlignedVector<unsigned char> buffer;
+#endif
+
+    void release() {
+#ifdef NEEDLE_HAS_MMAP
+        if (bytes && length > 0) munmap(const_cast<unsigned char *>(bytes), length);
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+public:
+    /**
+     * @param filepath - The file to open
+     * @throws std::runtime_error - If the file can not be opened or mapped
+     */
+    explicit MappedFile(const std::string &filepath) : bytes(nullptr), length(0) {
+#ifdef NEEDLE_HAS_MMAP
+        const int descriptor = ::open(filepath.c_str(), O_RDONLY);
+        if (descriptor < 0) {
+            throw std::runtime_error("Failed to open file: " + filepath);
+        }
+        struct stat status{};
+        if (fstat(descriptor, &status) != 0) {
+            ::close(descriptor);
+            throw std::runtime_error("Failed to read the size of file: " + filepath);
+        }
+        length = static_cast<size_t>(status.st_size);
+        if (length > 0) {
+            void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (mapping == MAP_FAILED) {
+                ::close(descriptor);
+                throw std::runtime_error("Failed to map file: " + filepath);
+            }
+            bytes = static_cast<const unsigned char *>(mapping);
+        }
+        // The mapping keeps the file alive on its own
+        ::close(descriptor);
+#else
+        std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file: " + filepath);
+        }
+        length = static_cast<size_t>(file.tellg());
+        buffer.resize(length);
+        file.seekg(0);
+        file.read(reinterpret_cast<char *>(buffer.data()), static_cast<std::streamsize>(length));
+        bytes = buffer.data();
+#endif
+    }
+
+    ~MappedFile() {
+        release();
+    }
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept : bytes(other.bytes), length(other.length) {
+#ifndef NEEDLE_HAS_MMAP
+        buffer = std::move(other.buffer);
+#endif
+        other.bytes = nullptr;
+        other.length = 0;
+    }
+
+    MappedFile &operator=(MappedFile &&other) noexcept {
+        if (this != &other) {
+            release();
+            bytes = other.bytes;
+            length = other.length;
+#ifndef NEEDLE_HAS_MMAP
+            buffer = std::move(other.buffer);
+#endif
+            other.bytes = nullptr;
+            other.length = 0;
+        }
+        return *this;
+    }
+
+    const unsigned char *data() const {
+        return bytes;
+    }
+
+    size_t size() const {
+        return length;
+    }
+};
+
+#endif //MAPPEDFILE_H
@@ -0,0 +1,156 @@
+#ifndef PRODUCERRING_H
+#define PRODUCERRING_H
+
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <vector>
+#include <algorithm>
+
+/**
+ * A bounded ring of buffers between a producer thread and a consumer. The producer fills free buffers in the
+ * background and queues them; the consumer takes them in the same order and gives each one back when it asks for the
+ * next, so the producer runs at most depth() - 1 buffers ahead and the memory it takes is fixed.
+ *
+ * A buffer belongs to exactly one side at a time, so filling and reading it happen outside of the lock.
+ */
+template<typename Slot>
+class ProducerRing {
+    std::vector<Slot> slots;
+    std::deque<size_t> freeSlots;
+    std::deque<size_t> filledSlots;
+    size_t current;
+    bool holding;
+    bool done;
+    bool stopping;
+    std::exception_ptr failure;
+    std::mutex mutex;
+    std::condition_variable slotFreed;
+    std::condition_variable slotFilled;
+    std::thread producer;
+    std::function<bool(Slot &)> produce;
+
+    /**
+     * @brief The loop of the producer thread: takes a free buffer, fills it and queues it, until the producer runs
+     * out or the ring is stopped.
+     */
+    void produceLoop() {
+        try {
+            while (true) {
+                size_t slot;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    slotFreed.wait(lock, [this] { return stopping || !freeSlots.empty(); });
+                    if (stopping) return;
+                    slot = freeSlots.front();
+                    freeSlots.pop_front();
+                }
+
+                const bool filled = produce(slots[slot]);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!filled) {
+                    freeSlots.push_front(slot);
+                    done = true;
+                    slotFilled.notify_one();
+                    return;
+                }
+                filledSlots.push_back(slot);
+                slotFilled.notify_one();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            failure = std::current_exception();
+            done = true;
+            slotFilled.notify_one();
+        }
+    }
+
+public:
+    /**
+     * @param depth - The number of buffers, at least 2: one that is consumed and one that is filled
+     * @param prototype - The initial value of every buffer, for example one with its memory already reserved
+     */
+    explicit ProducerRing(const size_t depth, const Slot &prototype = Slot())
+        : slots(std::max<size_t>(2, depth), prototype), current(0), holding(false), done(true), stopping(false) {
+    }
+
+    ~ProducerRing() {
+        stop();
+    }
+
+    ProducerRing(const ProducerRing &) = delete;
+
+    ProducerRing &operator=(const ProducerRing &) = delete;
+
+    size_t depth() const {
+        return slots.size();
+    }
+
+    /**
+     * @brief Starts a producer thread that calls @p fill on every free buffer until it returns false. A run that was
+     * not consumed to the end is abandoned.
+     *
+     * @param fill - Called as fill(Slot &slot) on the producer thread; returns false, without filling the buffer, once
+     * there is nothing left to produce, and may throw to end the run
+     */
+    void start(std::function<bool(Slot &)> fill) {
+        stop();
+        produce = std::move(fill);
+        freeSlots.clear();
+        filledSlots.clear();
+        for (size_t slot = 0; slot < slots.size(); ++slot) freeSlots.push_back(slot);
+        holding = false;
+        done = false;
+        stopping = false;
+        failure = nullptr;
+        producer = std::thread(&ProducerRing::produceLoop, this);
+    }
+
+    /**
+     * @brief Stops the producer thread, waiting for the buffer it is filling.
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        slotFreed.notify_all();
+        if (producer.joinable()) producer.join();
+    }
+
+    /**
+     * @brief Hands out the next filled buffer and gives the previous one back to the producer. It waits for the
+     * buffer if the producer has not filled it yet.
+     *
+     * @return - The buffer, which stays valid until the next call or the next start(), or nullptr once the producer
+     * ran out
+     * @throws - The exception of the producer, if it failed
+     */
+    Slot *next() {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (holding) {
+            freeSlots.push_back(current);
+            holding = false;
+            slotFreed.notify_one();
+        }
+        slotFilled.wait(lock, [this] { return !filledSlots.empty() || done; });
+        if (filledSlots.empty()) {
+            if (failure) {
+                const std::exception_ptr error = failure;
+                failure = nullptr;
+                std::rethrow_exception(error);
+            }
+            return nullptr;
+        }
+        current = filledSlots.front();
+        filledSlots.pop_front();
+        holding = true;
+        return &slots[current];
+    }
+};
+
+#endif //PRODUCERRING_H
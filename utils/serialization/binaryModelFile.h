@@ -0,0 +1,331 @@
+#ifndef BINARYMODELFILE_H
+#define BINARYMODELFILE_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <stdexcept>
+#include <algorithm>
+#include <nnComponents/module.h>
+#include <nnComponents/inference/inferenceEngine.h>
+#include <utils/io/mappedFile.h>
+
+/**
+ * The binary model format. A file starts with a 64-byte Header, followed by one 32-byte LayerRecord per dense layer
+ * and then by the weights and the biases of every layer, each block starting at a multiple of 64 bytes from the
+ * beginning of the file. The weights of a layer are its (outputs x inputs) row-major matrix, as stored by Layer.
+ *
+ * Values are written in the byte order of the machine that saved the model, which the header records, so that a
+ * mapped file can be used in place. The checksum is the 64-bit FNV-1a hash of every byte after the header.
+ */
+namespace binaryModel {
+    constexpr char magic[8] = {'N', 'E', 'E', 'D', 'L', 'E', 'M', 'F'};
+    constexpr uint32_t version = 1;
+    constexpr uint32_t byteOrderMark = 0x01020304;
+    constexpr size_t alignment = 64;
+
+    // The codes of the scalar types in the header
+    constexpr uint32_t float32 = 1;
+    constexpr uint32_t float64 = 2;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint32_t scalarType;
+        uint32_t layerCount;
+        uint64_t fileSize;
+        uint64_t checksum;
+        uint8_t reserved[24];
+    };
+
+    struct LayerRecord {
+        int32_t inputs;
+        int32_t outputs;
+        int32_t activation;
+        uint32_t reserved;
+        uint64_t weightsOffset;
+        uint64_t biasesOffset;
+    };
+
+    static_assert(sizeof(Header) == 64, "The header of a binary model takes 64 bytes");
+    static_assert(sizeof(LayerRecord) == 32, "A layer record of a binary model takes 32 bytes");
+
+    inline uint32_t scalarTypeOf(const float *) {
+        return float32;
+    }
+
+    inline uint32_t scalarTypeOf(const double *) {
+        return float64;
+    }
+
+    inline size_t scalarSize(const uint32_t scalarType) {
+        return scalarType == float32 ? sizeof(float) : scalarType == float64 ? sizeof(double) : 0;
+    }
+
+    inline uint64_t alignUp(const uint64_t offset) {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    /**
+     * @brief Continues the 64-bit FNV-1a hash @p hash with @p size bytes.
+     */
+    inline uint64_t fnv1a(const unsigned char *data, const size_t size, uint64_t hash = 14695981039346656037ull) {
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= data[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    /**
+     * @brief Writes the layers to @p filepath in the binary format.
+     *
+     * @param layers - The layers of the network, from the first hidden layer to the output layer
+     * @param filepath - The file to create
+     * @return - True if the model was written completely
+     */
+    template<typename Scalar>
+    bool save(const std::vector<BasicDenseLayerView<Scalar> > &layers, const std::string &filepath) {
+        // Lays out the file first, so that the header can be written with its final size
+        std::vector<LayerRecord> records(layers.size());
+        uint64_t offset = alignUp(sizeof(Header) + records.size() * sizeof(LayerRecord));
+        for (size_t l = 0; l < layers.size(); ++l) {
+            const uint64_t weightBytes = static_cast<uint64_t>(layers[l].inputs) * layers[l].outputs * sizeof(Scalar);
+            records[l] = LayerRecord{layers[l].inputs, layers[l].outputs, static_cast<int32_t>(layers[l].activation),
+                                     0, offset, alignUp(offset + weightBytes)};
+            offset = alignUp(records[l].biasesOffset + static_cast<uint64_t>(layers[l].outputs) * sizeof(Scalar));
+        }
+
+        Header header{};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version = version;
+        header.byteOrder = byteOrderMark;
+        header.scalarType = scalarTypeOf(static_cast<const Scalar *>(nullptr));
+        header.layerCount = static_cast<uint32_t>(layers.size());
+        header.fileSize = offset;
+
+        std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        // Everything after the header goes through write(), which keeps the checksum up to date
+        uint64_t position = sizeof(Header);
+        uint64_t checksum = fnv1a(nullptr, 0);
+        const unsigned char zeros[alignment] = {};
+        auto write = [&](const void *data, const size_t size) {
+            file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+            checksum = fnv1a(static_cast<const unsigned char *>(data), size, checksum);
+            position += size;
+        };
+        auto padTo = [&](const uint64_t target) {
+            write(zeros, static_cast<size_t>(target - position));
+        };
+
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        write(records.data(), records.size() * sizeof(LayerRecord));
+        for (size_t l = 0; l < layers.size(); ++l) {
+            padTo(records[l].weightsOffset);
+            write(layers[l].weights, static_cast<size_t>(layers[l].inputs) * layers[l].outputs * sizeof(Scalar));
+            padTo(records[l].biasesOffset);
+            write(layers[l].biases, static_cast<size_t>(layers[l].outputs) * sizeof(Scalar));
+        }
+        padTo(header.fileSize);
+
+        header.checksum = checksum;
+        file.seekp(0);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        return static_cast<bool>(file);
+    }
+}
+
+/**
+ * A model in the binary format, mapped into memory. The parameters are never parsed: layerViews() points straight into
+ * the mapping, so an InferenceEngine bound to them serves the model without copying its weights, and copyParameters()
+ * is a plain copy into the layers of a network. The views stay valid for as long as the MappedModel lives.
+ */
+class MappedModel {
+    MappedFile file;
+    const binaryModel::Header *header;
+    const binaryModel::LayerRecord *records;
+
+    static void check(const bool condition, const std::string &message) {
+        if (!condition) throw std::runtime_error("Invalid binary model: " + message);
+    }
+
+    template<typename Scalar>
+    const Scalar *block(const uint64_t offset) const {
+        return reinterpret_cast<const Scalar *>(file.data() + offset);
+    }
+
+public:
+    /**
+     * @brief Maps @p filepath and validates its header, its layer table and, unless disabled, its checksum. Skipping
+     * the checksum keeps the pages of the parameters untouched until they are used.
+     *
+     * @throws std::runtime_error - If the file can not be read or is not a valid binary model
+     */
+    explicit MappedModel(const std::string &filepath, const bool verifyChecksum = true)
+        : file(filepath), header(nullptr), records(nullptr) {
+        using namespace binaryModel;
+        check(file.size() >= sizeof(Header), "the file is too small");
+        header = reinterpret_cast<const Header *>(file.data());
+        check(std::memcmp(header->magic, magic, sizeof(magic)) == 0, "wrong magic number");
+        check(header->version == version, "unsupported version " + std::to_string(header->version));
+        check(header->byteOrder == byteOrderMark, "the model was saved with a different byte order");
+        check(scalarSize(header->scalarType) > 0, "unknown scalar type");
+        check(header->fileSize == file.size(), "the file is truncated");
+        check(header->layerCount > 0, "the model has no layers");
+        check(sizeof(Header) + static_cast<uint64_t>(header->layerCount) * sizeof(LayerRecord) <= file.size(),
+              "the layer table does not fit in the file");
+        records = reinterpret_cast<const LayerRecord *>(file.data() + sizeof(Header));
+
+        const size_t valueSize = scalarSize(header->scalarType);
+        for (size_t l = 0; l < header->layerCount; ++l) {
+            const LayerRecord &record = records[l];
+            check(record.inputs > 0 && record.outputs > 0, "layer " + std::to_string(l) + " is empty");
+            check(l == 0 || record.inputs == records[l - 1].outputs, "consecutive layers do not fit together");
+            check(record.weightsOffset % alignment == 0 && record.biasesOffset % alignment == 0,
+                  "unaligned parameters");
+            const uint64_t weightBytes = static_cast<uint64_t>(record.inputs) * record.outputs * valueSize;
+            check(record.weightsOffset + weightBytes <= file.size() &&
+                  record.biasesOffset + static_cast<uint64_t>(record.outputs) * valueSize <= file.size(),
+                  "the parameters of layer " + std::to_string(l) + " do not fit in the file");
+        }
+
+        if (verifyChecksum) {
+            check(fnv1a(file.data() + sizeof(Header), file.size() - sizeof(Header)) == header->checksum,
+                  "checksum mismatch");
+        }
+    }
+
+    /**
+     * @return Whether @p filepath starts with the magic number of the binary format
+     */
+    static bool isBinaryModel(const std::string &filepath) {
+        std::ifstream stream(filepath, std::ios::binary);
+        char start[sizeof(binaryModel::magic)] = {};
+        return stream.read(start, sizeof(start)) && std::memcmp(start, binaryModel::magic, sizeof(start)) == 0;
+    }
+
+    size_t layerCount() const {
+        return header->layerCount;
+    }
+
+    uint32_t scalarType() const {
+        return header->scalarType;
+    }
+
+    int inputSize() const {
+        return layerCount() == 0 ? 0 : records[0].inputs;
+    }
+
+    /**
+     * @return The number of outputs of every layer, the output layer included
+     */
+    std::vector<int> layerSizes() const {
+        std::vector<int> sizes;
+        for (size_t l = 0; l < layerCount(); ++l) sizes.push_back(records[l].outputs);
+        return sizes;
+    }
+
+    Activation activation(const size_t layer) const {
+        return static_cast<Activation>(records[layer].activation);
+    }
+
+    /**
+     * @brief Checks that the saved layers are the ones of the network described by @p specs, in the form taken by the
+     * Network constructor: the size of the input layer and then the size and activation of every layer.
+     *
+     * @throws std::runtime_error - If a size or an activation differs
+     */
+    void checkArchitecture(const std::vector<std::pair<int, Activation> > &specs) const {
+        check(specs.size() == layerCount() + 1, "the network does not have as many layers as the saved model");
+        check(specs.front().first == inputSize(), "the network does not have the input size of the saved model");
+        for (size_t l = 0; l < layerCount(); ++l) {
+            check(specs[l + 1].first == records[l].outputs && specs[l + 1].second == activation(l),
+                  "layer " + std::to_string(l) + " does not have the size or the activation of the saved layer");
+        }
+    }
+
+    /**
+     * @return Views of the layers that point into the mapped file, for models saved with the scalar type @p Scalar
+     * @throws std::runtime_error - If the model was saved with another scalar type
+     */
+    template<typename Scalar>
+    std::vector<BasicDenseLayerView<Scalar> > layerViews() const {
+        check(header->scalarType == binaryModel::scalarTypeOf(static_cast<const Scalar *>(nullptr)),
+              "the model was saved with another scalar type");
+        std::vector<BasicDenseLayerView<Scalar> > views;
+        for (size_t l = 0; l < layerCount(); ++l) {
+            const binaryModel::LayerRecord &record = records[l];
+            views.push_back(BasicDenseLayerView<Scalar>{record.inputs, record.outputs, activation(l),
+                                                        block<Scalar>(record.weightsOffset),
+                                                        block<Scalar>(record.biasesOffset)});
+        }
+        return views;
+    }
+
+    /**
+     * @brief Copies the parameters into @p blocks, which must hold the weights and then the biases of every layer,
+     * like Network::parameterBlocks(). Values saved with another scalar type are converted.
+     *
+     * @throws std::runtime_error - If the blocks do not have the shape of the saved layers
+     */
+    template<typename Scalar>
+    void copyParameters(const std::vector<BasicParameterBlock<Scalar> > &blocks) const {
+        check(blocks.size() == 2 * layerCount(), "the network does not have as many layers as the saved model");
+        for (size_t l = 0; l < layerCount(); ++l) {
+            const binaryModel::LayerRecord &record = records[l];
+            const BasicParameterBlock<Scalar> &weights = blocks[2 * l], &biases = blocks[2 * l + 1];
+            check(weights.size == static_cast<size_t>(record.inputs) * record.outputs &&
+                  biases.size == static_cast<size_t>(record.outputs),
+                  "layer " + std::to_string(l) + " does not have the shape of the saved layer");
+            if (header->scalarType == binaryModel::float32) {
+                std::copy(block<float>(record.weightsOffset), block<float>(record.weightsOffset) + weights.size,
+                          weights.data);
+                std::copy(block<float>(record.biasesOffset), block<float>(record.biasesOffset) + biases.size,
+                          biases.data);
+            } else {
+                std::copy(block<double>(record.weightsOffset), block<double>(record.weightsOffset) + weights.size,
+                          weights.data);
+                std::copy(block<double>(record.biasesOffset), block<double>(record.biasesOffset) + biases.size,
+                          biases.data);
+            }
+        }
+    }
+};
+
+/**
+ * A model that is served straight from its MappedModel: the InferenceEngine is bound to views of the mapping, so the
+ * weights are never copied and their pages are only read when they are used. It keeps the mapping alive for as long as
+ * it lives. The classifiers build one with loadForInference(), which also checks the saved architecture.
+ */
+template<typename Scalar>
+class BasicMappedInferenceModel {
+    std::unique_ptr<MappedModel> mapped;
+    BasicInferenceEngine<Scalar> inference;
+
+public:
+    /**
+     * @throws std::runtime_error - If the model was saved with another scalar type
+     */
+    explicit BasicMappedInferenceModel(std::unique_ptr<MappedModel> model)
+        : mapped(std::move(model)), inference(mapped->layerViews<Scalar>()) {
+    }
+
+    const MappedModel &model() const {
+        return *mapped;
+    }
+
+    BasicInferenceEngine<Scalar> &engine() {
+        return inference;
+    }
+};
+
+#endif //BINARYMODELFILE_H
@@ -22,6 +22,15 @@ struct ModelMetadata {
     }
 };
 
+/**
+ * The formats a network can be saved in. TEXT is the original format of ModelSerializer, BINARY the mappable format of
+ * binaryModelFile.h, which loads without parsing and keeps the layer activations. Loading recognizes both.
+ */
+enum class ModelFormat {
+    TEXT,
+    BINARY
+};
+
 /**
  * The model serializer captures the parameters of a network along with its layer structure and saves them in a .txt file.
  * Additionally, it offers methods for retrieving that information for creating inference models that help making predictions.
@@ -29,7 +38,8 @@ struct ModelMetadata {
 class ModelSerializer {
 public:
     // Save model with metadata in text format
-    static bool saveWithMetadata(const std::vector<Node *> &parameters,
+    template<typename Scalar>
+    static bool saveWithMetadata(const std::vector<BasicNode<Scalar> *> &parameters,
                                  const ModelMetadata &metadata,
                                  const std::string &filepath) {
         std::ofstream file(filepath); // Text mode by default
@@ -54,10 +64,10 @@ public:
         size_t num_params = parameters.size();
         file << num_params << "\n";
 
-        // Use maximum precision to avoid losing accuracy in text conversion
-        file << std::fixed << std::setprecision(std::numeric_limits<double>::max_digits10);
+        // Use enough significant digits for every value to read back exactly, whatever its magnitude
+        file << std::setprecision(std::numeric_limits<Scalar>::max_digits10);
 
-        for (const Node *param: parameters) {
+        for (const BasicNode<Scalar> *param: parameters) {
             if (param) {
                 file << param->data << "\n";
             }
@@ -95,7 +105,8 @@ public:
     }
 
     // Load parameters with validation
-    static bool loadWithValidation(std::vector<Node *> &parameters,
+    template<typename Scalar>
+    static bool loadWithValidation(std::vector<BasicNode<Scalar> *> &parameters,
                                    const std::string &filepath) {
         std::ifstream file(filepath); // Text mode by default
         if (!file.is_open()) {
@@ -130,7 +141,7 @@ public:
         }
 
         // Read parameter values
-        for (Node *param: parameters) {
+        for (BasicNode<Scalar> *param: parameters) {
             if (param) {
                 file >> param->data;
             }
@@ -0,0 +1,130 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of worker threads that run the iterations of a parallel loop. The calling thread takes part in every
+ * loop as well, so a pool of size n starts n - 1 threads. Iterations are handed out one at a time from a shared
+ * counter, which balances the load when some of them take longer than others.
+ */
+class ThreadPool {
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+
+    const std::function<void(size_t)> *task;
+    size_t taskCount;
+    std::atomic<size_t> nextTask;
+    size_t busyThreads;
+    size_t generation;
+    bool stopping;
+    std::exception_ptr failure;
+
+    void drain() {
+        for (size_t i = nextTask++; i < taskCount; i = nextTask++) {
+            try {
+                (*task)(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!failure) failure = std::current_exception();
+            }
+        }
+    }
+
+    void workerLoop() {
+        size_t seenGeneration = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this, seenGeneration] { return stopping || generation != seenGeneration; });
+                if (stopping) return;
+                seenGeneration = generation;
+            }
+
+            drain();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busyThreads == 0) finished.notify_one();
+        }
+    }
+
+public:
+    /**
+     * @param size - The number of threads that run a loop, the calling thread included. Zero picks the number of
+     * hardware threads.
+     */
+    explicit ThreadPool(size_t size = 0)
+        : task(nullptr), taskCount(0), nextTask(0), busyThreads(0), generation(0), stopping(false) {
+        if (size == 0) size = std::max(1u, std::thread::hardware_concurrency());
+        threads.reserve(size - 1);
+        for (size_t i = 1; i < size; ++i) {
+            threads.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &thread: threads) thread.join();
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * @return The number of threads that run a loop, the calling thread included
+     */
+    size_t size() const {
+        return threads.size() + 1;
+    }
+
+    /**
+     * @brief Runs @p body(i) for every i in [0, count) across the pool and returns once all of them are done. The
+     * first exception thrown by an iteration is rethrown on the calling thread.
+     */
+    void parallelFor(const size_t count, const std::function<void(size_t)> &body) {
+        if (count == 0) return;
+        if (threads.empty() || count == 1) {
+            for (size_t i = 0; i < count; ++i) body(i);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = &body;
+            taskCount = count;
+            nextTask = 0;
+            busyThreads = threads.size();
+            failure = nullptr;
+            ++generation;
+        }
+        wake.notify_all();
+
+        drain();
+
+        std::exception_ptr error;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [this] { return busyThreads == 0; });
+            task = nullptr;
+            error = failure;
+        }
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+#endif //THREADPOOL_H